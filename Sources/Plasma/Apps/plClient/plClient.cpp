@@ -43,6 +43,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsWindows.h"
 #include "plClient.h"
 #include "hsStream.h"
+#include "hsJobSystem.h"
 #include "plResMgr/plResManager.h"
 #include "plResMgr/plKeyFinder.h"
 #include "pnKeyedObject/plKey.h"
@@ -360,6 +361,9 @@ bool plClient::Shutdown()
     fPageMgr = nil;
     plGlobalVisMgr::DeInit();
 
+    // Everything that might still be handing out jobs is gone now
+    hsJobSystem::Shutdown();
+
 #ifdef TRACK_AG_ALLOCS
     DumpAGAllocs();
 #endif // TRACK_AG_ALLOCS
@@ -939,6 +943,9 @@ void plClient::IQueueRoomLoad(const std::vector<plLocation>& locs, bool hold)
 
         fLoadRooms.push_back(new LoadRequest(loc, hold));
 
+        // Start reading the page in the background while earlier rooms load
+        ((plResManager*)hsgResMgr::ResMgr())->PrefetchPage(loc);
+
         if (lastAgeName.empty() || info->GetAge() == lastAgeName)
             lastAgeName = info->GetAge();
         else
@@ -967,6 +974,7 @@ void plClient::ILoadNextRoom()
         bool isLoading = IIsRoomLoading(req->loc);
         if (alreadyLoaded || isLoading)
         {
+            ((plResManager*)hsgResMgr::ResMgr())->DropPrefetchedPage(req->loc);
             delete req;
             req = nil;
             fNumLoadingRooms--;
@@ -1341,6 +1349,8 @@ bool plClient::StartInit()
     hsStatusMessage("Init client\n");
     fFlags.SetBit( kFlagIniting );
 
+    hsJobSystem::Init();
+
     pfLocalizationMgr::Initialize("dat");
 
     plQuality::SetQuality(fQuality);
@@ -1595,6 +1605,9 @@ bool plClient::IUpdate()
     plProfile_BeginTiming(DispatchQueue);
     plgDispatch::Dispatch()->MsgQueueProcess();
     plProfile_EndTiming(DispatchQueue);
+
+    // Results handed back from worker jobs
+    hsJobSystem::ProcessMainThreadJobs();
     
     const char *inputUpdate = "Update";
     if (fInputManager) // Is this used anymore? Seems to always be nil.
@@ -949,6 +949,9 @@ LONG WINAPI plCustomUnhandledExceptionFilter( struct _EXCEPTION_POINTERS *Except
     // Before we do __ANYTHING__, pass the exception to plCrashHandler
     s_crash.ReportCrash(ExceptionInfo);
 
+    // Get any log lines still sitting in the writer queue onto disk
+    plStatusLogMgr::GetInstance().FlushLogs();
+
     // Now, try to create a nice exception dialog after plCrashHandler is done.
     s_crash.WaitForHandle();
     HWND parentHwnd = gClient ? gClient->GetWindowHandle() : GetActiveWindow();
@@ -41,6 +41,7 @@ Mead, WA   99021
 *==LICENSE==*/
 
 #include "HeadSpin.h"
+#include "hsJobSystem.h"
 #include "plFileSystem.h"
 #include "plProduct.h"
 
@@ -401,8 +402,9 @@ int __stdcall WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdL
     }
     HANDLE _onePatcherMut = CreatePatcherMutex().release();
 
-    // Initialize the network core
+    // Initialize the network core, and some worker threads for the patcher to hash files on
     s_launcher.InitializeNetCore();
+    hsJobSystem::Init();
 
     // Welp, now that we know we're (basically) sane, let's create our client window
     // and pump window messages until we're through.
@@ -420,6 +422,7 @@ int __stdcall WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdL
     //       awhile (it can... dang eap...)
     ReleaseMutex(_onePatcherMut);
     CloseHandle(_onePatcherMut);
+    hsJobSystem::Shutdown();
 
     // kthxbai
     return s_error.empty() ? PLASMA_OK : PLASMA_PHAILURE;
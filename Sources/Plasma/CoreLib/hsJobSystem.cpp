@@ -0,0 +1,360 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "hsJobSystem.h"
+#include "hsThread.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+struct hsJob
+{
+    hsJobFunc   fFunc;
+    hsJobGroup* fGroup;
+
+    hsJob() : fGroup() { }
+    hsJob(hsJobFunc func, hsJobGroup* group) : fFunc(std::move(func)), fGroup(group) { }
+};
+
+// Jobs are coarse (tens of microseconds and up), so a plain lock per deque
+// costs next to nothing next to the work itself.
+class hsJobDeque
+{
+    std::mutex          fMutex;
+    std::deque<hsJob>   fJobs;
+
+public:
+    void Push(hsJob&& job)
+    {
+        hsLockGuard(fMutex);
+        fJobs.push_back(std::move(job));
+    }
+
+    // Owner end: newest first, while its data is still in cache
+    bool Pop(hsJob& job)
+    {
+        hsLockGuard(fMutex);
+        if (fJobs.empty())
+            return false;
+        job = std::move(fJobs.back());
+        fJobs.pop_back();
+        return true;
+    }
+
+    // Thief end: oldest first, which tend to be the biggest pieces of work
+    bool Steal(hsJob& job)
+    {
+        hsLockGuard(fMutex);
+        if (fJobs.empty())
+            return false;
+        job = std::move(fJobs.front());
+        fJobs.pop_front();
+        return true;
+    }
+};
+
+class hsJobWorker : public hsThread
+{
+    unsigned fIndex;
+
+public:
+    hsJobWorker(unsigned index) : fIndex(index) { }
+    void Run() override;
+};
+
+struct hsJobScheduler
+{
+    std::vector<std::unique_ptr<hsJobDeque>>  fDeques;   // One per worker
+    std::vector<std::unique_ptr<hsJobWorker>> fWorkers;
+    hsJobDeque                  fShared;    // Jobs from non-worker threads
+
+    std::atomic<bool>           fRunning;
+    std::atomic<int32_t>        fQueued;    // Jobs waiting in any deque
+
+    std::mutex                  fSleepMutex;
+    std::condition_variable     fSleepCond;
+
+    std::mutex                  fMainMutex;
+    std::vector<hsJobFunc>      fMainJobs;
+    std::thread::id             fMainThread;
+
+    hsJobScheduler() : fRunning(false), fQueued(0) { }
+    ~hsJobScheduler() { hsJobSystem::Shutdown(); }
+
+    void Push(hsJob&& job);
+    bool TryRunJob();
+    void Wake(bool all);
+
+    static void Complete(hsJob& job);
+};
+
+static hsJobScheduler s_scheduler;
+
+// Index of the worker running on this thread, or -1 for any other thread
+static thread_local int t_workerIndex = -1;
+
+void hsJobScheduler::Wake(bool all)
+{
+    // Take the lock so a thread that is just about to sleep can't miss this
+    {
+        hsLockGuard(fSleepMutex);
+    }
+
+    if (all)
+        fSleepCond.notify_all();
+    else
+        fSleepCond.notify_one();
+}
+
+void hsJobScheduler::Push(hsJob&& job)
+{
+    if (t_workerIndex >= 0)
+        fDeques[t_workerIndex]->Push(std::move(job));
+    else
+        fShared.Push(std::move(job));
+
+    ++fQueued;
+    Wake(false);
+}
+
+bool hsJobScheduler::TryRunJob()
+{
+    hsJob job;
+    bool found = false;
+
+    int self = t_workerIndex;
+    if (self >= 0)
+        found = fDeques[self]->Pop(job);
+    if (!found)
+        found = fShared.Steal(job);
+
+    // Go looking through everyone else's, starting just past our own so that
+    // thieves spread out instead of all hammering worker 0
+    for (size_t i = 1; !found && i <= fDeques.size(); i++)
+    {
+        size_t victim = (self + i) % fDeques.size();
+        if (int(victim) != self)
+            found = fDeques[victim]->Steal(job);
+    }
+
+    if (!found)
+        return false;
+
+    --fQueued;
+    job.fFunc();
+    Complete(job);
+    return true;
+}
+
+void hsJobScheduler::Complete(hsJob& job)
+{
+    // Anyone waiting on the group is asleep on the same condition as the idle
+    // workers, so everyone has to hear about it
+    if (job.fGroup && --job.fGroup->fPending == 0)
+        s_scheduler.Wake(true);
+}
+
+void hsJobWorker::Run()
+{
+    t_workerIndex = fIndex;
+
+    while (s_scheduler.fRunning)
+    {
+        if (s_scheduler.TryRunJob())
+            continue;
+
+        std::unique_lock<std::mutex> lock(s_scheduler.fSleepMutex);
+        s_scheduler.fSleepCond.wait(lock, [] () {
+            return !s_scheduler.fRunning || s_scheduler.fQueued > 0;
+        });
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void hsJobGroup::Run(hsJobFunc job)
+{
+    if (!s_scheduler.fRunning)
+    {
+        job();
+        return;
+    }
+
+    ++fPending;
+    s_scheduler.Push(hsJob(std::move(job), this));
+}
+
+void hsJobGroup::Wait()
+{
+    while (fPending > 0)
+    {
+        if (s_scheduler.TryRunJob())
+            continue;
+
+        // Nothing left to help with; whatever is outstanding is already
+        // running on another thread
+        std::unique_lock<std::mutex> lock(s_scheduler.fSleepMutex);
+        s_scheduler.fSleepCond.wait(lock, [this] () {
+            return fPending == 0 || s_scheduler.fQueued > 0;
+        });
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void hsJobSystem::Init(unsigned numWorkers)
+{
+    if (s_scheduler.fRunning)
+        return;
+
+    s_scheduler.fMainThread = std::this_thread::get_id();
+
+    if (numWorkers == 0)
+    {
+        unsigned hwThreads = std::thread::hardware_concurrency();
+        numWorkers = hwThreads > 1 ? hwThreads - 1 : 0;
+    }
+    if (numWorkers == 0)
+        return;
+
+    for (unsigned i = 0; i < numWorkers; i++)
+        s_scheduler.fDeques.emplace_back(new hsJobDeque);
+
+    s_scheduler.fRunning = true;
+    for (unsigned i = 0; i < numWorkers; i++)
+    {
+        s_scheduler.fWorkers.emplace_back(new hsJobWorker(i));
+        s_scheduler.fWorkers.back()->Start();
+    }
+}
+
+void hsJobSystem::Shutdown()
+{
+    if (!s_scheduler.fRunning)
+        return;
+
+    // Nobody gets left holding a group that never finishes
+    while (s_scheduler.fQueued > 0)
+    {
+        if (!s_scheduler.TryRunJob())
+            std::this_thread::yield();
+    }
+
+    s_scheduler.fRunning = false;
+    s_scheduler.Wake(true);
+    for (auto& worker : s_scheduler.fWorkers)
+        worker->Stop();
+    s_scheduler.fWorkers.clear();
+    s_scheduler.fDeques.clear();
+
+    ProcessMainThreadJobs();
+}
+
+unsigned hsJobSystem::GetNumWorkers()
+{
+    return unsigned(s_scheduler.fWorkers.size());
+}
+
+bool hsJobSystem::IsMainThread()
+{
+    return std::this_thread::get_id() == s_scheduler.fMainThread;
+}
+
+void hsJobSystem::Submit(hsJobFunc job)
+{
+    if (!s_scheduler.fRunning)
+        job();
+    else
+        s_scheduler.Push(hsJob(std::move(job), nullptr));
+}
+
+void hsJobSystem::ParallelFor(size_t begin, size_t end, size_t grainSize,
+                              const std::function<void(size_t, size_t)>& body)
+{
+    if (end <= begin)
+        return;
+
+    size_t count = end - begin;
+    if (grainSize == 0)
+    {
+        size_t numChunks = (GetNumWorkers() + 1) * 4;
+        grainSize = std::max<size_t>((count + numChunks - 1) / numChunks, 1);
+    }
+
+    if (!s_scheduler.fRunning || count <= grainSize)
+    {
+        body(begin, end);
+        return;
+    }
+
+    hsJobGroup group;
+    for (size_t chunk = begin; chunk < end; chunk += grainSize)
+    {
+        size_t chunkEnd = std::min(chunk + grainSize, end);
+        group.Run([&body, chunk, chunkEnd] () { body(chunk, chunkEnd); });
+    }
+    group.Wait();
+}
+
+void hsJobSystem::RunOnMainThread(hsJobFunc job)
+{
+    hsLockGuard(s_scheduler.fMainMutex);
+    s_scheduler.fMainJobs.push_back(std::move(job));
+}
+
+void hsJobSystem::ProcessMainThreadJobs()
+{
+    hsAssert(s_scheduler.fMainThread == std::thread::id() || IsMainThread(),
+             "ProcessMainThreadJobs called off the main thread");
+
+    std::vector<hsJobFunc> jobs;
+    {
+        hsLockGuard(s_scheduler.fMainMutex);
+        jobs.swap(s_scheduler.fMainJobs);
+    }
+
+    // Jobs queued while we run these wait for the next frame
+    for (hsJobFunc& job : jobs)
+        job();
+}
@@ -0,0 +1,129 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef hsJobSystem_Defined
+#define hsJobSystem_Defined
+
+#include "HeadSpin.h"
+#include <atomic>
+#include <functional>
+
+typedef std::function<void()> hsJobFunc;
+
+/** A set of jobs that can be waited on together.
+ *  The group must outlive every job submitted to it; the destructor waits
+ *  for any that are still outstanding.
+ */
+class hsJobGroup
+{
+    std::atomic<uint32_t> fPending;
+
+    friend struct hsJobScheduler;
+
+public:
+    hsJobGroup() : fPending(0) { }
+    ~hsJobGroup() { Wait(); }
+
+    hsJobGroup(const hsJobGroup&) = delete;
+    void operator=(const hsJobGroup&) = delete;
+
+    /** Submit a job as part of this group. */
+    void Run(hsJobFunc job);
+
+    /** Block until every job in this group has finished.  The calling thread
+     *  runs queued jobs (from any group) while it waits, so it is safe to
+     *  wait from inside a job.
+     */
+    void Wait();
+
+    /** Returns \p true if every job in this group has finished. */
+    bool IsDone() const { return fPending == 0; }
+};
+
+/** Engine-wide work-stealing job scheduler.
+ *  Each worker thread owns a deque of jobs: jobs submitted from a worker go
+ *  on the back of its own deque and it takes them back LIFO, while idle
+ *  workers steal from the front of everyone else's.  Jobs submitted from
+ *  any other thread go into a shared queue that the workers drain.
+ *
+ *  Until Init() is called (or if there is only one core to go around) every
+ *  job simply runs inline on the thread that submitted it.
+ */
+namespace hsJobSystem
+{
+    /** Start the worker threads.  Zero picks one less than the number of
+     *  hardware threads, leaving a core for the main thread.
+     */
+    void Init(unsigned numWorkers = 0);
+
+    /** Run anything still queued and stop the worker threads. */
+    void Shutdown();
+
+    /** Number of worker threads, not counting the main thread. */
+    unsigned GetNumWorkers();
+
+    /** Returns \p true if called from the thread that called Init(). */
+    bool IsMainThread();
+
+    /** Submit a job that nobody needs to wait on. */
+    void Submit(hsJobFunc job);
+
+    /** Split [begin, end) into chunks of at least \a grainSize elements and
+     *  call \a body(chunkBegin, chunkEnd) for each of them in parallel.
+     *  Returns once every chunk is done.  Zero picks a grain size that gives
+     *  each thread a few chunks to balance out uneven work.
+     */
+    void ParallelFor(size_t begin, size_t end, size_t grainSize,
+                     const std::function<void(size_t, size_t)>& body);
+
+    /** Queue a job to be run on the main thread, for work that has to touch
+     *  things that aren't thread safe (the dispatcher, the resManager, the
+     *  pipeline...).  It runs during the next ProcessMainThreadJobs().
+     */
+    void RunOnMainThread(hsJobFunc job);
+
+    /** Run every job queued with RunOnMainThread().  Call once per frame
+     *  from the main thread.
+     */
+    void ProcessMainThreadJobs();
+}
+
+#endif // hsJobSystem_Defined
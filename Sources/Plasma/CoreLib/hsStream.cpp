@@ -43,8 +43,10 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <cctype>
 #if HS_BUILD_FOR_WIN32
 #   include <io.h>
+#   include "hsWindows.h"
 #endif
 #include <algorithm>
+#include <limits>
 
 #include "hsStream.h"
 #include "hsMemory.h"
@@ -52,6 +54,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #if HS_BUILD_FOR_UNIX
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 //////////////////////////////////////////////////////////////////////////////////
 
@@ -991,6 +996,151 @@ void hsReadOnlyStream::CopyToMem(void* mem)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////
+
+hsMappedStream::hsMappedStream()
+#if HS_BUILD_FOR_WIN32
+    : fFile(INVALID_HANDLE_VALUE), fMapping(nil)
+#endif
+{
+}
+
+hsMappedStream::~hsMappedStream()
+{
+    Close();
+}
+
+bool hsMappedStream::Open(const plFileName& name, const char* mode)
+{
+    hsAssert(mode && mode[0] == 'r' && !strchr(mode, '+'), "hsMappedStream is read only");
+    if (!mode || mode[0] != 'r' || strchr(mode, '+'))
+        return false;
+
+    Close();
+
+#if HS_BUILD_FOR_WIN32
+    fFile = CreateFileW(name.WideString().data(), GENERIC_READ, FILE_SHARE_READ,
+                        nil, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nil);
+    if (fFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fFile, &size) || size.HighPart != 0) {
+        Close();
+        return false;
+    }
+
+    char* view = nil;
+    if (size.LowPart) {
+        fMapping = CreateFileMappingW(fFile, nil, PAGE_READONLY, 0, 0, nil);
+        if (fMapping)
+            view = (char*)MapViewOfFile(fMapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            Close();
+            return false;
+        }
+    }
+    uint32_t length = size.LowPart;
+#else
+    int fd = open(name.AsString().c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || uint64_t(st.st_size) > std::numeric_limits<uint32_t>::max()) {
+        close(fd);
+        return false;
+    }
+
+    uint32_t length = uint32_t(st.st_size);
+    char* view = nil;
+    if (length) {
+        void* map = mmap(nil, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        view = (char*)map;
+        // Page data is read by key offset, not front to back
+        madvise(map, length, MADV_RANDOM);
+    }
+
+    // The mapping holds its own reference to the file
+    close(fd);
+#endif
+
+    // An empty file still counts as open; give it a non-nil, zero length view
+    static char sEmpty;
+    Init(length, view ? view : &sEmpty);
+    fBytesRead = 0;
+    fPosition = 0;
+    return true;
+}
+
+bool hsMappedStream::Close()
+{
+    if (fStart && fStart != fStop) {
+#if HS_BUILD_FOR_WIN32
+        UnmapViewOfFile(fStart);
+#else
+        munmap(fStart, fStop - fStart);
+#endif
+    }
+
+#if HS_BUILD_FOR_WIN32
+    if (fMapping)
+        CloseHandle(fMapping);
+    if (fFile != INVALID_HANDLE_VALUE)
+        CloseHandle(fFile);
+    fMapping = nil;
+    fFile = INVALID_HANDLE_VALUE;
+#endif
+
+    fStart = fData = fStop = nil;
+    fBytesRead = 0;
+    fPosition = 0;
+    return true;
+}
+
+void hsMappedStream::SetPosition(uint32_t position)
+{
+    if (position > GetEOF())
+        hsThrow("SetPosition went past end of stream");
+
+    fData = fStart + position;
+    fBytesRead = position;
+    fPosition = position;
+}
+
+#if HS_BUILD_FOR_UNIX
+static void IAdviseRange(char* start, char* stop, uint32_t offset, uint32_t length, int advice)
+{
+    if (!start || offset >= uint32_t(stop - start) || !length)
+        return;
+    length = std::min(length, uint32_t(stop - start) - offset);
+
+    // madvise wants a page aligned address; the view itself is page aligned
+    static const uintptr_t pageSize = uintptr_t(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = uintptr_t(start + offset) & ~(pageSize - 1);
+    uintptr_t end = uintptr_t(start + offset + length);
+    madvise((void*)begin, end - begin, advice);
+}
+#endif
+
+void hsMappedStream::WillNeed(uint32_t offset, uint32_t length)
+{
+#if HS_BUILD_FOR_UNIX
+    IAdviseRange(fStart, fStop, offset, length, MADV_WILLNEED);
+#endif
+}
+
+void hsMappedStream::DontNeed(uint32_t offset, uint32_t length)
+{
+#if HS_BUILD_FOR_UNIX
+    IAdviseRange(fStart, fStop, offset, length, MADV_DONTNEED);
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////////
 uint32_t hsWriteOnlyStream::Read(uint32_t byteCount, void* buffer)
 {
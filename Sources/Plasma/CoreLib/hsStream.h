@@ -416,6 +416,29 @@ public:
     virtual uint32_t  GetBytesWritten() const { return fBytesRead; }
 };
 
+// read only stream over a memory mapped file.  Reads, skips and seeks are just
+// pointer arithmetic on the mapped view; the OS pages data in as it is touched.
+class hsMappedStream : public hsReadOnlyStream {
+#if HS_BUILD_FOR_WIN32
+    HANDLE  fFile;
+    HANDLE  fMapping;
+#endif
+
+public:
+    hsMappedStream();
+    ~hsMappedStream();
+
+    virtual bool      Open(const plFileName& name, const char* mode = "rb");
+    virtual bool      Close();
+    virtual void      SetPosition(uint32_t position);
+
+    bool              IsOpen() const { return fStart != nil; }
+
+    // Paging hints for a byte range of the file.  No-ops where unsupported.
+    void              WillNeed(uint32_t offset, uint32_t length);
+    void              DontNeed(uint32_t offset, uint32_t length);
+};
+
 // circular queue stream
 class hsQueueStream : public hsStream {
 private:
@@ -45,30 +45,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <cstring>
-
-#define NO_POSIX_CLOCK 1
-
-#if NO_POSIX_CLOCK
-#include <sys/time.h>
-#include <unistd.h>
-#define CLOCK_REALTIME 0
-
-//
-// A linux hack b/c we're not quite POSIX
-//
-int clock_gettime(int clocktype, struct timespec* ts)
-{
-  struct timezone tz;
-  struct timeval tv;
-
-  int result = gettimeofday(&tv, &tz);
-  ts->tv_sec = tv.tv_sec;
-  ts->tv_nsec = tv.tv_usec * 1000 + 500;  // sice we're losing accuracy round up by 500 nanos
-
-  return result;
-}
-
-#endif
+#include <ctime>
 
 /////////////////////////////////////////////////////////////////////////////
 
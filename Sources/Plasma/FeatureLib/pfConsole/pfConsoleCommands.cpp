@@ -564,6 +564,38 @@ PF_CONSOLE_CMD(Stats, SetAvgTime, "int ms", "Sets the amount of time stats are a
     plProfileManager::Instance().SetAvgTime((int)params[0]);
 }
 
+PF_CONSOLE_CMD(Stats, CaptureTrace, "int frames, ...", "Records every timer on every thread for the given number of frames\n"
+                                     "and writes a Chrome trace (for chrome://tracing or the Perfetto UI).\n"
+                                     "Optional: the file name, relative to the profile folder")
+{
+    if (plProfileManager::Instance().IsCapturing())
+    {
+        PrintString("A trace capture is already running");
+        return;
+    }
+
+    int frames = (int)params[0];
+    if (frames <= 0)
+    {
+        PrintString("Must capture at least one frame");
+        return;
+    }
+
+    plFileName traceFile;
+    if (numParams > 1)
+        traceFile = static_cast<const char *>(params[1]);
+    else
+    {
+        plUnifiedTime curTime = plUnifiedTime::GetCurrent(plUnifiedTime::kLocal);
+        traceFile = ST::format("Trace_{02}-{02}-{02}.json", curTime.GetHour(),
+                               curTime.GetMinute(), curTime.GetSecond());
+    }
+    traceFile = plFileName::Join(plProfileManagerFull::Instance().GetProfilePath(), traceFile);
+
+    plProfileManager::Instance().BeginCapture(frames, traceFile);
+    pfConsolePrintF(PrintString, "Capturing {} frames to {}", frames, traceFile);
+}
+
 PF_CONSOLE_CMD(Stats, Graph, "string stat, int min, int max", "Graphs the specified stat")
 {
     plProfileManagerFull::Instance().CreateGraph(params[0], (int)params[1], (int)params[2]);
@@ -41,10 +41,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 *==LICENSE==*/
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <mutex>
+#include <vector>
 
 #include "pfPatcher.h"
+#include "pfPatcherHashCache.h"
 
 #include "HeadSpin.h"
 #include "plCompression/plZlibStream.h"
@@ -53,6 +56,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pnNetBase/pnNbError.h"
 #include "plNetGameLib/plNetGameLib.h"
 #include "plStatusLog/plStatusLog.h"
+#include "hsJobSystem.h"
 #include "hsStream.h"
 #include "hsThread.h"
 #include "hsTimer.h"
@@ -122,11 +126,14 @@ struct pfPatcherWorker : public hsThread
 
     std::deque<Request> fRequests;
     std::deque<NetCliFileManifestEntry> fQueuedFiles;
+    std::deque<class pfPatcherStream*> fFinishedFiles; // guarded by fFileMut
 
     std::mutex fRequestMut;
     std::mutex fFileMut;
     hsSemaphore fFileSignal;
 
+    pfPatcherHashCache fHashCache;
+
     pfPatcher::CompletionFunc fOnComplete;
     pfPatcher::FileDownloadFunc fFileBeginDownload;
     pfPatcher::FileDesiredFunc fFileDownloadDesired;
@@ -138,10 +145,12 @@ struct pfPatcherWorker : public hsThread
 
     pfPatcher* fParent;
     volatile bool fStarted;
-    volatile bool fRequestActive;
 
-    uint64_t fCurrBytes;
-    uint64_t fTotalBytes;
+    uint32_t fActiveRequests; // guarded by fRequestMut
+    uint32_t fMaxActiveRequests;
+
+    std::atomic<uint64_t> fCurrBytes;
+    std::atomic<uint64_t> fTotalBytes;
 
     pfPatcherWorker();
     ~pfPatcherWorker();
@@ -149,23 +158,60 @@ struct pfPatcherWorker : public hsThread
     void OnQuit() override;
 
     void EndPatch(ENetError result, const ST::string& msg={});
+    bool IIssueRequests();
     bool IssueRequest();
+    void RequestDone();
+    void FileFinished(class pfPatcherStream* s);
+    void IFinishFiles();
     void Run() override;
-    void ProcessFile();
+    void ProcessFiles(std::deque<NetCliFileManifestEntry>& files);
     void WhitelistFile(const plFileName& file, bool justDownloaded, hsStream* s=nullptr);
 };
 
 // ===================================================
 
+/** Disk output for a downloaded file that hashes everything written to it,
+ *  so the download can be verified without reading it back.
+ */
+class pfPatcherFileStream : public hsUNIXStream
+{
+    plMD5Checksum& fMD5;
+
+public:
+    pfPatcherFileStream(plMD5Checksum& md5) : fMD5(md5) { }
+
+    uint32_t Write(uint32_t count, const void* buf) override
+    {
+        fMD5.AddTo(count, static_cast<const uint8_t*>(buf));
+        return hsUNIXStream::Write(count, buf);
+    }
+};
+
 class pfPatcherStream : public plZlibStream
 {
     pfPatcherWorker* fParent;
     plFileName fFilename;
+    plFileName fPartName;
     uint32_t fFlags;
 
     uint64_t fBytesWritten;
     float fDLStartTime;
 
+    plMD5Checksum fMD5;
+    plMD5Checksum fExpectedMD5;
+
+    // File server downloads are inflated and written out on the job system,
+    // in the order the chunks arrived, so the NetCli thread only copies them.
+    // Once the download is over, the last drain job also closes, verifies and
+    // commits the file, then hands the stream to the patch thread.
+    bool fAsync;
+    std::mutex fChunkMut;
+    std::deque<std::vector<uint8_t>> fChunks;
+    bool fDraining;
+    bool fFinishing;
+    ENetError fResult;
+    plFileName fReqName;
+
     ST::string IMakeStatusMsg() const
     {
         float secs = hsTimer::GetSeconds<float>() - fDLStartTime;
@@ -183,17 +229,82 @@ class pfPatcherStream : public plZlibStream
             fParent->fProgressTick(fParent->fCurrBytes, fParent->fTotalBytes, IMakeStatusMsg());
     }
 
+    uint32_t IWriteChunk(uint32_t count, const void* buf)
+    {
+        // write the appropriate blargs
+        if (hsCheckBits(fFlags, pfPatcherWorker::kFlagZipped))
+            return plZlibStream::Write(count, buf);
+        else
+            return fOutput->Write(count, buf);
+    }
+
+    void IDrainChunks()
+    {
+        for (;;) {
+            std::vector<uint8_t> chunk;
+            {
+                hsLockGuard(fChunkMut);
+                if (fChunks.empty()) {
+                    fDraining = false;
+                    if (!fFinishing)
+                        return;
+                    break;
+                }
+                chunk = std::move(fChunks.front());
+                fChunks.pop_front();
+            }
+            IWriteChunk(uint32_t(chunk.size()), chunk.data());
+        }
+
+        // Nothing else writes to us after Finish(), so this is the last drain
+        IFinish();
+    }
+
+    void IFinish()
+    {
+        plZlibStream::Close();
+
+        if (IS_NET_SUCCESS(fResult) && !IVerify()) {
+            PatcherLogRed("\tChecksum Mismatch: File '{}'", fFilename);
+            fResult = kNetErrBadServerData;
+        }
+        if (IS_NET_SUCCESS(fResult) && !plFileSystem::Move(fPartName, fFilename)) {
+            PatcherLogRed("\tPhailed to replace '{}'", fFilename);
+            fResult = kNetErrInternalError;
+        }
+        if (!IS_NET_SUCCESS(fResult))
+            plFileSystem::Unlink(fPartName);
+
+        // The patch thread owns us from here on
+        fParent->FileFinished(this);
+    }
+
+    /** Checks what was written against the manifest. */
+    bool IVerify()
+    {
+        fMD5.Finish();
+        return fMD5 == fExpectedMD5;
+    }
+
 public:
     pfPatcherStream(pfPatcherWorker* parent, const plFileName& filename, uint64_t size)
-        : fParent(parent), fFilename(filename), fFlags(), fBytesWritten(), fDLStartTime(), plZlibStream()
+        : fParent(parent), fFilename(filename), fFlags(), fBytesWritten(), fDLStartTime(),
+          fAsync(false), fDraining(false), fFinishing(false), fResult(kNetSuccess), plZlibStream()
     {
         fParent->fTotalBytes += size;
         fOutput = new hsRAMStream;
     }
 
     pfPatcherStream(pfPatcherWorker* parent, const plFileName& reqName, const plFileName& cliName, const NetCliFileManifestEntry& entry)
-        : fParent(parent), fFilename(cliName.Normalize()), fFlags(entry.flags), fBytesWritten(), fDLStartTime(), plZlibStream()
+        : fParent(parent), fFilename(cliName.Normalize()), fFlags(entry.flags), fBytesWritten(), fDLStartTime(),
+          fAsync(true), fDraining(false), fFinishing(false), fResult(kNetSuccess), plZlibStream()
     {
+        // Downloads land next to the real file and only replace it once they check out,
+        // so an interrupted patch never leaves a half-written file behind.
+        fPartName = fFilename;
+        fPartName += ".part";
+        fExpectedMD5.SetFromHexString(ST::string::from_wchar(entry.md5, 32).c_str());
+
         // ugh. eap removed the compressed flag in his fail manifests
         if (reqName.GetFileExt().compare_i("gz") == 0) {
             fFlags |= pfPatcherWorker::kFlagZipped;
@@ -206,13 +317,16 @@ public:
     {
         fDLStartTime = hsTimer::GetSeconds<float>();
         if (!fOutput)
-            Open(fFilename, "wb");
+            Open(fPartName, "wb");
     }
 
     bool Open(const plFileName& filename, const char* mode) override
     {
-        hsAssert(filename == fFilename, "trying to save to a different file, eh?");
-        bool retVal = plZlibStream::Open(filename, mode);
+        hsAssert(filename == fPartName, "trying to save to a different file, eh?");
+        fMD5.Start();
+        pfPatcherFileStream* output = new pfPatcherFileStream(fMD5);
+        fOutput = output;
+        bool retVal = output->Open(filename, mode);
         if (!retVal)
             PatcherLogRed("\tPhailed to open %s: '%s'", filename.AsString().c_str(), strerror(errno));
         return retVal;
@@ -223,11 +337,20 @@ public:
         // tick whatever progress bar we have
         IUpdateProgress(count);
 
-        // write the appropriate blargs
-        if (hsCheckBits(fFlags, pfPatcherWorker::kFlagZipped))
-            return plZlibStream::Write(count, buf);
-        else
-            return fOutput->Write(count, buf);
+        if (!fAsync)
+            return IWriteChunk(count, buf);
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(buf);
+        bool startDrain;
+        {
+            hsLockGuard(fChunkMut);
+            fChunks.emplace_back(bytes, bytes + count);
+            startDrain = !fDraining;
+            fDraining = true;
+        }
+        if (startDrain)
+            hsJobSystem::Submit([this] { IDrainChunks(); });
+        return count;
     }
 
     bool AtEnd() override { return fOutput->AtEnd(); }
@@ -241,7 +364,27 @@ public:
     plFileName GetFileName() const { return fFilename; }
     bool IsRedistUpdate() const { return hsCheckBits(fFlags, pfPatcherWorker::kRedistUpdate); }
     bool IsSelfPatch() const { return hsCheckBits(fFlags, pfPatcherWorker::kSelfPatch); }
-    void Unlink() const { plFileSystem::Unlink(fFilename); }
+    ENetError GetResult() const { return fResult; }
+    plFileName GetRequestName() const { return fReqName; }
+
+    /** Ends a file server download without waiting on the disk. Once the last
+     *  chunk is written the file is checked against the manifest and moved over
+     *  the real one, and the patch thread is told how it went.
+     */
+    void Finish(ENetError result, const plFileName& reqName)
+    {
+        bool startDrain;
+        {
+            hsLockGuard(fChunkMut);
+            fResult = result;
+            fReqName = reqName;
+            fFinishing = true;
+            startDrain = !fDraining;
+            fDraining = true;
+        }
+        if (startDrain)
+            hsJobSystem::Submit([this] { IDrainChunks(); });
+    }
 };
 
 // ===================================================
@@ -252,16 +395,17 @@ static void IAuthThingDownloadCB(ENetError result, void* param, const plFileName
 
     if (IS_NET_SUCCESS(result)) {
         PatcherLogGreen("\tDownloaded Legacy File '{}'", filename);
-        patcher->IssueRequest();
 
         // Now, we pass our RAM-backed file to the game code handlers. In the main client,
         // this will trickle down and add a new friend to plStreamSource. This should never
         // happen in any other app...
         writer->Rewind();
         patcher->WhitelistFile(filename, true, writer);
+        patcher->RequestDone();
     } else {
         PatcherLogRed("\tDownloaded Failed: File '{}'", filename);
         patcher->EndPatch(result, filename.AsString());
+        patcher->RequestDone();
     }
 }
 
@@ -286,10 +430,11 @@ static void IGotAuthFileList(ENetError result, void* param, const NetCliAuthFile
                 patcher->fRequests.emplace_back(fn.AsString(), pfPatcherWorker::Request::kAuthFile, s);
             }
         }
-        patcher->IssueRequest();
+        patcher->RequestDone();
     } else {
         PatcherLogRed("\tSHIT! Some legacy manifest phailed");
         patcher->EndPatch(result, "SecurePreloader failed");
+        patcher->RequestDone();
     }
 }
 
@@ -302,7 +447,7 @@ static void IHandleManifestDownload(pfPatcherWorker* patcher, const wchar_t grou
             patcher->fQueuedFiles.push_back(manifest[i]);
         patcher->fFileSignal.Signal();
     }
-    patcher->IssueRequest();
+    patcher->RequestDone();
 }
 
 static void IPreloaderManifestDownloadCB(ENetError result, void* param, const wchar_t group[], const NetCliFileManifestEntry manifest[], unsigned entryCount)
@@ -322,7 +467,7 @@ static void IPreloaderManifestDownloadCB(ENetError result, void* param, const wc
         }
 
         // continue pumping requests
-        patcher->IssueRequest();
+        patcher->RequestDone();
     }
 }
 
@@ -335,36 +480,23 @@ static void IFileManifestDownloadCB(ENetError result, void* param, const wchar_t
     else {
         PatcherLogRed("\tDownload Failed: Manifest '{}'", group);
         patcher->EndPatch(result, ST::string::from_wchar(group));
+        patcher->RequestDone();
     }
 }
 
 static void IFileThingDownloadCB(ENetError result, void* param, const plFileName& filename, hsStream* writer)
 {
-    pfPatcherWorker* patcher = static_cast<pfPatcherWorker*>(param);
+    // This is the NetCli (often UI) thread, so don't wait for the disk here.
+    // The stream comes back to the patch thread once it's been written out.
     pfPatcherStream* stream = static_cast<pfPatcherStream*>(writer);
-    stream->Close();
-
-    if (IS_NET_SUCCESS(result)) {
-        PatcherLogGreen("\tDownloaded File '{}'", stream->GetFileName());
-        patcher->WhitelistFile(stream->GetFileName(), true);
-        if (patcher->fSelfPatch && stream->IsSelfPatch())
-            patcher->fSelfPatch(stream->GetFileName());
-        if (patcher->fRedistUpdateDownloaded && stream->IsRedistUpdate())
-            patcher->fRedistUpdateDownloaded(stream->GetFileName());
-        patcher->IssueRequest();
-    } else {
-        PatcherLogRed("\tDownloaded Failed: File '{}'", stream->GetFileName());
-        stream->Unlink();
-        patcher->EndPatch(result, filename.AsString());
-    }
-
-    delete stream;
+    stream->Finish(result, filename);
 }
 
 // ===================================================
 
 pfPatcherWorker::pfPatcherWorker() :
-    fStarted(false), fCurrBytes(0), fTotalBytes(0), fRequestActive(true), fParent(nullptr)
+    fStarted(false), fCurrBytes(0), fTotalBytes(0), fActiveRequests(0),
+    fMaxActiveRequests(pfPatcher::kDefaultMaxConcurrentDownloads), fParent(nullptr)
 { }
 
 pfPatcherWorker::~pfPatcherWorker()
@@ -413,54 +545,105 @@ void pfPatcherWorker::EndPatch(ENetError result, const ST::string& msg)
     fFileSignal.Signal();
 }
 
-bool pfPatcherWorker::IssueRequest()
+bool pfPatcherWorker::IIssueRequests()
 {
-    hsLockGuard(fRequestMut);
-    if (fRequests.empty()) {
-        fRequestActive = false;
+    // Keep up to fMaxActiveRequests transfers going at once. Nothing new is
+    // started once the patch has been ended.
+    while (fStarted && !fRequests.empty() && fActiveRequests < fMaxActiveRequests) {
+        const Request& req = fRequests.front();
+        switch (req.fType) {
+            case Request::kFile:
+                req.fStream->Begin();
+                if (fFileBeginDownload)
+                    fFileBeginDownload(req.fStream->GetFileName());
+
+                NetCliFileDownloadRequest(req.fName, req.fStream, IFileThingDownloadCB, this);
+                break;
+            case Request::kManifest:
+                NetCliFileManifestRequest(IFileManifestDownloadCB, this, req.fName.to_wchar().data());
+                break;
+            case Request::kSecurePreloader:
+                // so, yeah, this is usually the "SecurePreloader" manifest on the file server...
+                // except on legacy servers, this may not exist, so we need to fall back without nuking everything!
+                NetCliFileManifestRequest(IPreloaderManifestDownloadCB, this, req.fName.to_wchar().data());
+                break;
+            case Request::kAuthFile:
+                // ffffffuuuuuu
+                req.fStream->Begin();
+                if (fFileBeginDownload)
+                    fFileBeginDownload(req.fStream->GetFileName());
+
+                NetCliAuthFileRequest(req.fName, req.fStream, IAuthThingDownloadCB, this);
+                break;
+            case Request::kPythonList:
+                NetCliAuthFileListRequest(L"Python", L"pak", IGotAuthFileList, this);
+                break;
+            case Request::kSdlList:
+                NetCliAuthFileListRequest(L"SDL", L"sdl", IGotAuthFileList, this);
+                break;
+            DEFAULT_FATAL(req.fType);
+        }
+
+        fRequests.pop_front();
+        ++fActiveRequests;
+    }
+
+    if (fActiveRequests == 0) {
         fFileSignal.Signal(); // make sure the patch thread doesn't deadlock!
         return false;
-    } else
-        fRequestActive = true;
-
-    const Request& req = fRequests.front();
-    switch (req.fType) {
-        case Request::kFile:
-            req.fStream->Begin();
-            if (fFileBeginDownload)
-                fFileBeginDownload(req.fStream->GetFileName());
-
-            NetCliFileDownloadRequest(req.fName, req.fStream, IFileThingDownloadCB, this);
-            break;
-        case Request::kManifest:
-            NetCliFileManifestRequest(IFileManifestDownloadCB, this, req.fName.to_wchar().data());
-            break;
-        case Request::kSecurePreloader:
-            // so, yeah, this is usually the "SecurePreloader" manifest on the file server...
-            // except on legacy servers, this may not exist, so we need to fall back without nuking everything!
-            NetCliFileManifestRequest(IPreloaderManifestDownloadCB, this, req.fName.to_wchar().data());
-            break;
-        case Request::kAuthFile:
-            // ffffffuuuuuu
-            req.fStream->Begin();
-            if (fFileBeginDownload)
-                fFileBeginDownload(req.fStream->GetFileName());
-
-            NetCliAuthFileRequest(req.fName, req.fStream, IAuthThingDownloadCB, this);
-            break;
-        case Request::kPythonList:
-            NetCliAuthFileListRequest(L"Python", L"pak", IGotAuthFileList, this);
-            break;
-        case Request::kSdlList:
-            NetCliAuthFileListRequest(L"SDL", L"sdl", IGotAuthFileList, this);
-            break;
-        DEFAULT_FATAL(req.fType);
-    }
-
-    fRequests.pop_front();
+    }
     return true;
 }
 
+bool pfPatcherWorker::IssueRequest()
+{
+    hsLockGuard(fRequestMut);
+    return IIssueRequests();
+}
+
+void pfPatcherWorker::RequestDone()
+{
+    // Done under one lock: once the count hits zero, the patch thread may
+    // tear everything down as soon as we let go.
+    hsLockGuard(fRequestMut);
+    hsAssert(fActiveRequests > 0, "more requests finished than were issued?");
+    --fActiveRequests;
+    IIssueRequests();
+}
+
+void pfPatcherWorker::FileFinished(pfPatcherStream* s)
+{
+    hsLockGuard(fFileMut);
+    fFinishedFiles.push_back(s);
+    fFileSignal.Signal();
+}
+
+void pfPatcherWorker::IFinishFiles()
+{
+    std::deque<pfPatcherStream*> finished;
+    {
+        hsLockGuard(fFileMut);
+        finished.swap(fFinishedFiles);
+    }
+
+    for (pfPatcherStream* stream : finished) {
+        if (IS_NET_SUCCESS(stream->GetResult())) {
+            PatcherLogGreen("\tDownloaded File '{}'", stream->GetFileName());
+            WhitelistFile(stream->GetFileName(), true);
+            if (fSelfPatch && stream->IsSelfPatch())
+                fSelfPatch(stream->GetFileName());
+            if (fRedistUpdateDownloaded && stream->IsRedistUpdate())
+                fRedistUpdateDownloaded(stream->GetFileName());
+        } else {
+            PatcherLogRed("\tDownloaded Failed: File '{}'", stream->GetFileName());
+            EndPatch(stream->GetResult(), stream->GetRequestName().AsString());
+        }
+
+        delete stream;
+        RequestDone();
+    }
+}
+
 void pfPatcherWorker::Run()
 {
     // So here's the rub:
@@ -468,52 +651,106 @@ void pfPatcherWorker::Run()
     // As we receive the answer, the NetCli thread populates fQueuedFiles and pings the fFileSignal semaphore, then issues the next request...
     // In this non-UI/non-Net thread, we do the stutter-prone/time-consuming IO/hashing operations. (Typically, the UI thread == Net thread)
     // As we find files that need updating, we add them to fRequests.
-    // If there is no net request from ME when we find a file, we issue the request
-    // Once a file is downloaded, the next request is issued.
+    // Up to fMaxActiveRequests net requests are in flight at once; as each finishes, the next is issued.
+    // Downloaded data is inflated, written and hashed on the job system rather than the NetCli thread.
+    // Finished downloads come back here to be reported, so the NetCli thread never waits on the disk.
     // When there are no files in my deque and no requests in my deque, we exit without errors.
 
     PatcherLogWhite("--- Patch Started ({} requests) ---", fRequests.size());
     fStarted = true;
     IssueRequest();
 
+    plFileName hashCachePath = pfPatcherHashCache::GetDefaultPath();
+    fHashCache.Read(hashCachePath, plFileSystem::GetCWD());
+
     // Now, work until we're done processing files
     do {
         fFileSignal.Wait();
+        IFinishFiles();
 
-        hsLockGuard(fFileMut);
-        if (!fQueuedFiles.empty()) {
-            ProcessFile();
-            continue;
+        // Take everything that's queued so the NetCli thread can keep adding
+        // manifests while we grind through the hashing.
+        std::deque<NetCliFileManifestEntry> files;
+        {
+            hsLockGuard(fFileMut);
+            if (fQueuedFiles.empty()) {
+                // This makes sure both queues are empty before exiting.
+                if (!IssueRequest())
+                    break;
+                continue;
+            }
+            files.swap(fQueuedFiles);
         }
+        ProcessFiles(files);
+    } while (fStarted);
 
-        // This makes sure both queues are empty before exiting.
-        if (!fRequestActive)
-            if(!IssueRequest())
+    // If the patch was ended early, the other transfers still call back into us,
+    // so we can't go away until they have.
+    for (;;) {
+        IFinishFiles();
+        {
+            hsLockGuard(fRequestMut);
+            if (fActiveRequests == 0)
                 break;
-    } while (fStarted);
+        }
+        fFileSignal.Wait();
+    }
+
+    if (fHashCache.IsDirty())
+        fHashCache.Write(hashCachePath, plFileSystem::GetCWD());
 
     EndPatch(kNetSuccess);
 }
 
-void pfPatcherWorker::ProcessFile()
+void pfPatcherWorker::ProcessFiles(std::deque<NetCliFileManifestEntry>& files)
 {
-    do {
-        NetCliFileManifestEntry& entry = fQueuedFiles.front();
+    struct FileCheck
+    {
+        plFileInfo fInfo;
+        plMD5Checksum fMD5;
+    };
+
+    // Files of the wrong size can't match, and files that haven't changed since
+    // we last hashed them already have a checksum. Only the rest need reading.
+    std::vector<FileCheck> checks(files.size());
+    std::vector<size_t> toHash;
+    for (size_t i = 0; i < files.size(); ++i) {
+        plFileInfo& mine = checks[i].fInfo;
+        mine = plFileInfo(ST::string::from_wchar(files[i].clientName));
+        if (mine.FileSize() != files[i].fileSize)
+            continue;
+        if (!fHashCache.Find(mine, checks[i].fMD5))
+            toHash.push_back(i);
+    }
+
+    // Hash the misses on the job system, one file per job
+    hsJobSystem::ParallelFor(0, toHash.size(), 1,
+        [&checks, &toHash] (size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                FileCheck& check = checks[toHash[i]];
+                check.fMD5.CalcFromFile(check.fInfo.FileName());
+            }
+        }
+    );
+    for (size_t i : toHash) {
+        if (checks[i].fMD5.IsValid())
+            fHashCache.Update(checks[i].fInfo, checks[i].fMD5);
+    }
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        NetCliFileManifestEntry& entry = files[i];
 
         // eap sucks
         plFileName clName = ST::string::from_wchar(entry.clientName);
         ST::string dlName = ST::string::from_wchar(entry.downloadName);
 
         // Check to see if ours matches
-        plFileInfo mine(clName);
-        if (mine.FileSize() == entry.fileSize) {
-            plMD5Checksum cliMD5(clName);
+        if (checks[i].fMD5.IsValid()) {
             plMD5Checksum srvMD5;
             srvMD5.SetFromHexString(ST::string::from_wchar(entry.md5, 32).c_str());
 
-            if (cliMD5 == srvMD5) {
+            if (checks[i].fMD5 == srvMD5) {
                 WhitelistFile(clName, false);
-                fQueuedFiles.pop_front();
                 continue;
             }
         }
@@ -522,7 +759,6 @@ void pfPatcherWorker::ProcessFile()
         if (fFileDownloadDesired) {
             if (!fFileDownloadDesired(clName)) {
                 PatcherLogRed("\tDeclined '{}'", entry.clientName);
-                fQueuedFiles.pop_front();
                 continue;
             }
         }
@@ -545,11 +781,9 @@ void pfPatcherWorker::ProcessFile()
             hsLockGuard(fRequestMut);
             fRequests.emplace_back(dlName, Request::kFile, s);
         }
-        fQueuedFiles.pop_front();
 
-        if (!fRequestActive)
-            IssueRequest();
-    } while (!fQueuedFiles.empty());
+        IssueRequest();
+    }
 }
 
 void pfPatcherWorker::WhitelistFile(const plFileName& file, bool justDownloaded, hsStream* stream)
@@ -641,6 +875,14 @@ void pfPatcher::OnSelfPatch(FileDownloadFunc cb)
 
 // ===================================================
 
+void pfPatcher::SetMaxConcurrentDownloads(uint32_t count)
+{
+    hsAssert(!fWorker->fStarted, "Too late to change the number of concurrent downloads");
+    fWorker->fMaxActiveRequests = std::max(count, 1u);
+}
+
+// ===================================================
+
 void pfPatcher::RequestGameCode()
 {
     hsLockGuard(fWorker->fRequestMut);
@@ -85,6 +85,9 @@ public:
     /** Represents a function that takes (bytesDLed, totalBytes, statsStr) as a progress indicator. */
     typedef std::function<void(uint64_t, uint64_t, const ST::string&)> ProgressTickFunc;
 
+    /** How many manifest and file transfers the patcher keeps in flight at once by default. */
+    static const uint32_t kDefaultMaxConcurrentDownloads = 4;
+
     pfPatcher();
     ~pfPatcher();
 
@@ -131,6 +134,12 @@ public:
     /** This is called when the current application has been updated. */
     void OnSelfPatch(FileDownloadFunc cb);
 
+    /** Set how many manifest and file transfers may be in flight at once. Patches with lots of
+     *  small files are bound by round trips rather than bandwidth, so more than one helps.
+     *  \remarks This must be called before Start().
+     */
+    void SetMaxConcurrentDownloads(uint32_t count);
+
     void RequestGameCode();
     void RequestManifest(const ST::string& mfs);
     void RequestManifest(const std::vector<ST::string>& mfs);
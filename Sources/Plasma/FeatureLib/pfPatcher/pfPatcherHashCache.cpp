@@ -0,0 +1,167 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "pfPatcherHashCache.h"
+
+#include "hsStream.h"
+#include "pnEncryption/plChecksum.h"
+
+static const uint32_t kCacheMagic       = 0x48435450;   // 'PTCH'
+static const uint32_t kCacheVersion     = 1;
+static const uint32_t kMaxCacheEntries  = 0x40000;
+
+static void IWrite64(hsStream* s, uint64_t value)
+{
+    s->WriteLE32(uint32_t(value));
+    s->WriteLE32(uint32_t(value >> 32));
+}
+
+static uint64_t IRead64(hsStream* s)
+{
+    uint64_t lo = s->ReadLE32();
+    uint64_t hi = s->ReadLE32();
+    return lo | (hi << 32);
+}
+
+static ST::string IMakeKey(const plFileName& file)
+{
+    return file.Normalize().AsString();
+}
+
+plFileName pfPatcherHashCache::GetDefaultPath()
+{
+    return plFileName::Join(plFileSystem::GetUserDataPath(), "PatcherHashes.cache");
+}
+
+bool pfPatcherHashCache::Read(const plFileName& cacheFile, const plFileName& rootPath)
+{
+    fEntries.clear();
+    fDirty = true;
+
+    hsUNIXStream s;
+    if (!s.Open(cacheFile, "rb"))
+        return false;
+
+    if (s.ReadLE32() != kCacheMagic || s.ReadLE32() != kCacheVersion ||
+        s.ReadSafeString() != rootPath.AsString())
+    {
+        s.Close();
+        return false;
+    }
+
+    uint32_t numEntries = s.ReadLE32();
+    if (numEntries > kMaxCacheEntries) {
+        s.Close();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numEntries && !s.AtEnd(); ++i) {
+        ST::string name = s.ReadSafeString();
+        Entry& entry = fEntries[name];
+        entry.fModifyTime = IRead64(&s);
+        entry.fFileSize = int64_t(IRead64(&s));
+        s.Read(sizeof(entry.fMD5), entry.fMD5);
+    }
+
+    // The trailing magic tells us the last write wasn't cut short
+    bool good = (fEntries.size() == numEntries && s.ReadLE32() == kCacheMagic);
+    s.Close();
+
+    if (!good) {
+        fEntries.clear();
+        return false;
+    }
+
+    fDirty = false;
+    return true;
+}
+
+bool pfPatcherHashCache::Write(const plFileName& cacheFile, const plFileName& rootPath)
+{
+    hsUNIXStream s;
+    if (!s.Open(cacheFile, "wb"))
+        return false;
+
+    s.WriteLE32(kCacheMagic);
+    s.WriteLE32(kCacheVersion);
+    s.WriteSafeString(rootPath.AsString());
+    s.WriteLE32(uint32_t(fEntries.size()));
+
+    for (EntryMap::const_iterator it = fEntries.begin(); it != fEntries.end(); ++it) {
+        const Entry& entry = it->second;
+        s.WriteSafeString(it->first);
+        IWrite64(&s, entry.fModifyTime);
+        IWrite64(&s, uint64_t(entry.fFileSize));
+        s.Write(sizeof(entry.fMD5), entry.fMD5);
+    }
+
+    s.WriteLE32(kCacheMagic);
+    s.Close();
+
+    fDirty = false;
+    return true;
+}
+
+bool pfPatcherHashCache::Find(const plFileInfo& info, plMD5Checksum& md5) const
+{
+    EntryMap::const_iterator it = fEntries.find(IMakeKey(info.FileName()));
+    if (it == fEntries.end())
+        return false;
+
+    const Entry& entry = it->second;
+    if (entry.fModifyTime != info.ModifyTime() || entry.fFileSize != info.FileSize())
+        return false;
+
+    md5.SetValue(const_cast<uint8_t*>(entry.fMD5));
+    return true;
+}
+
+void pfPatcherHashCache::Update(const plFileInfo& info, const plMD5Checksum& md5)
+{
+    hsAssert(md5.GetSize() == sizeof(Entry::fMD5), "MD5 isn't 16 bytes?");
+
+    Entry& entry = fEntries[IMakeKey(info.FileName())];
+    entry.fModifyTime = info.ModifyTime();
+    entry.fFileSize = info.FileSize();
+    memcpy(entry.fMD5, md5.GetValue(), sizeof(entry.fMD5));
+    fDirty = true;
+}
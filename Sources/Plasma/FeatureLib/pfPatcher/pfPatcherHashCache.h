@@ -0,0 +1,94 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef _pfPatcherHashCache_inc_
+#define _pfPatcherHashCache_inc_
+
+#include "HeadSpin.h"
+#include "plFileSystem.h"
+
+#include <map>
+
+class plMD5Checksum;
+
+/** Remembers the MD5 of every game file the patcher has hashed, along with
+ *  the file's size and modification time, so that files which haven't been
+ *  touched since the last patch don't need to be read again to be verified.
+ */
+class pfPatcherHashCache
+{
+    struct Entry
+    {
+        uint64_t fModifyTime;
+        int64_t  fFileSize;
+        uint8_t  fMD5[16];
+
+        Entry() : fModifyTime(0), fFileSize(-1), fMD5() { }
+    };
+
+    typedef std::map<ST::string, Entry> EntryMap;
+    EntryMap fEntries;
+    bool fDirty;
+
+public:
+    pfPatcherHashCache() : fDirty(false) { }
+
+    /** Loads the cache, throwing it away if it was written for a different
+     *  install or doesn't look right.  Returns false if nothing was loaded.
+     */
+    bool Read(const plFileName& cacheFile, const plFileName& rootPath);
+
+    /** Saves every entry in the cache. */
+    bool Write(const plFileName& cacheFile, const plFileName& rootPath);
+
+    /** Fills in \a md5 with the cached checksum of \a info's file if it
+     *  hasn't changed since it was hashed.
+     */
+    bool Find(const plFileInfo& info, plMD5Checksum& md5) const;
+    void Update(const plFileInfo& info, const plMD5Checksum& md5);
+
+    bool IsDirty() const { return fDirty; }
+
+    static plFileName GetDefaultPath();
+};
+
+#endif // _pfPatcherHashCache_inc_
@@ -43,6 +43,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define plProfile_h_inc
 
 #include "HeadSpin.h"
+#include <atomic>
 
 #ifndef PLASMA_EXTERNAL_RELEASE
 #define PL_PROFILE_ENABLED
@@ -137,6 +138,8 @@ class plProfileLaps;
 
 class plProfileBase
 {
+    friend class plProfileManager;
+
 public:
     enum
     {
@@ -166,6 +169,11 @@ protected:
     // Number of times EndTiming was called. Can be used to combine timing and counting in one timer
     uint32_t fTimerSamples;
 
+    // Set by plProfileManager while a trace capture is running, so timers
+    // record events even if nobody is displaying them
+    static std::atomic<bool> fTracing;
+    static bool ITracing() { return fTracing.load(std::memory_order_relaxed); }
+
     void IAddAvg();
 
     void IPrintValue(uint64_t value, char* buf, bool printType);
@@ -208,8 +216,8 @@ protected:
 
     plProfileVar() {}
 
-    void IBeginTiming();
-    void IEndTiming();
+    void IBeginTiming(const char* lapName = nil);
+    void IEndTiming(const char* lapName = nil);
     
     void IBeginLap(const char* lapName); 
     void IEndLap(const char* lapName);
@@ -220,8 +228,8 @@ public:
     ~plProfileVar();
 
     // For timing
-    void BeginTiming() { if (fActive && fRunning) IBeginTiming(); }
-    void EndTiming() { if (fActive && fRunning) IEndTiming(); }
+    void BeginTiming() { if ((fActive || ITracing()) && fRunning) IBeginTiming(); }
+    void EndTiming() { if ((fActive || ITracing()) && fRunning) IEndTiming(); }
 
     void NewMem(uint32_t memAmount) { fValue += memAmount; }
     void DelMem(uint32_t memAmount) { fValue -= memAmount; }
@@ -238,8 +246,8 @@ public:
     // Will output to log like
     // Timername : lapCnt: (lapName) : 3.22 msec
     //
-    void BeginLap(const char* lapName) { if(fActive && fRunning) IBeginLap(lapName); }
-    void EndLap(const char* lapName) { if(fActive && fRunning) IEndLap(lapName); }
+    void BeginLap(const char* lapName) { if((fActive || ITracing()) && fRunning) IBeginLap(lapName); }
+    void EndLap(const char* lapName) { if((fActive || ITracing()) && fRunning) IEndLap(lapName); }
     
     const char* GetGroup() { return fGroup; }
 
@@ -41,10 +41,97 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 *==LICENSE==*/
 #include "plProfileManager.h"
 #include "plProfile.h"
+#include "hsThread.h"
 #include "hsTimer.h"
 #include <algorithm>
+#include <memory>
+#include <mutex>
 
-plProfileManager::plProfileManager() : fLastAvgTime(0), fProcessorSpeed(0)
+///////////////////////////////////////////////////////////////////////////////
+// Trace capture
+//
+// Each thread that hits a timer during a capture gets its own ring of events,
+// so recording is just a couple of stores with no locking.  If a thread
+// overflows its ring, the oldest events are dropped.
+
+struct plProfileTraceEvent
+{
+    enum Type : uint8_t { kBegin, kEnd };
+
+    uint64_t            fTicks;
+    plProfileVar*       fVar;
+    Type                fType;
+    char                fLapName[39];   // Copied, lap names are usually temporaries
+};
+
+struct plProfileTraceBuffer
+{
+    enum { kNumEvents = 1 << 15 };      // Must be a power of two
+
+    size_t                                  fThreadHash;
+    uint32_t                                fThreadIdx;
+    std::unique_ptr<plProfileTraceEvent[]>  fEvents;
+    std::atomic<uint64_t>                   fCount;
+
+    plProfileTraceBuffer(size_t threadHash, uint32_t threadIdx)
+        : fThreadHash(threadHash), fThreadIdx(threadIdx),
+          fEvents(new plProfileTraceEvent[kNumEvents]), fCount(0)
+    { }
+};
+
+static std::mutex s_traceBuffersMut;
+static std::vector<std::unique_ptr<plProfileTraceBuffer>> s_traceBuffers;
+static thread_local plProfileTraceBuffer* s_traceBuffer = nil;
+
+std::atomic<bool> plProfileBase::fTracing(false);
+
+static void IRecordTraceEvent(plProfileTraceEvent::Type type, plProfileVar* var,
+                              const char* lapName, uint64_t ticks)
+{
+    if (!s_traceBuffer)
+    {
+        std::lock_guard<std::mutex> lock(s_traceBuffersMut);
+        s_traceBuffers.emplace_back(new plProfileTraceBuffer(hsThread::ThisThreadHash(),
+                                                             (uint32_t)s_traceBuffers.size() + 1));
+        s_traceBuffer = s_traceBuffers.back().get();
+    }
+
+    uint64_t count = s_traceBuffer->fCount.load(std::memory_order_relaxed);
+    plProfileTraceEvent& event = s_traceBuffer->fEvents[count & (plProfileTraceBuffer::kNumEvents - 1)];
+    event.fTicks = ticks;
+    event.fVar = var;
+    event.fType = type;
+    if (lapName)
+    {
+        strncpy(event.fLapName, lapName, std::size(event.fLapName) - 1);
+        event.fLapName[std::size(event.fLapName) - 1] = 0;
+    }
+    else
+        event.fLapName[0] = 0;
+    s_traceBuffer->fCount.store(count + 1, std::memory_order_release);
+}
+
+static void IWriteJSONString(FILE* fp, const char* str)
+{
+    fputc('"', fp);
+    for (; *str; str++)
+    {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+plProfileManager::plProfileManager()
+    : fLastAvgTime(0), fProcessorSpeed(0), fCaptureFrames(0), fCapturePending(false),
+      fCaptureStart(0), fMainThread(0)
 {
 }
 
@@ -74,6 +161,9 @@ static plProfileVar gVarEFPS("EFPS", "General", plProfileVar::kDisplayTime | plP
 
 void plProfileManager::BeginFrame()
 {
+    if (fCapturePending)
+        IStartCapture();
+
     for (int i = 0; i < fVars.size(); i++)
     {
         fVars[i]->BeginFrame();
@@ -123,6 +213,96 @@ void plProfileManager::EndFrame()
         if (var->GetLaps())
             var->GetLaps()->EndFrame();
     }
+
+    if (fCaptureFrames > 0 && --fCaptureFrames == 0)
+    {
+        plProfileBase::fTracing.store(false, std::memory_order_relaxed);
+        IWriteCapture();
+    }
+}
+
+void plProfileManager::BeginCapture(uint32_t numFrames, const plFileName& filename)
+{
+    if (numFrames == 0 || IsCapturing())
+        return;
+
+    fCaptureFrames = numFrames;
+    fCapturePath = filename;
+    fCapturePending = true;
+}
+
+void plProfileManager::IStartCapture()
+{
+    fCapturePending = false;
+    fMainThread = hsThread::ThisThreadHash();
+
+    // Nobody is recording right now, so the buffers are safe to reset
+    {
+        std::lock_guard<std::mutex> lock(s_traceBuffersMut);
+        for (const auto& buffer : s_traceBuffers)
+            buffer->fCount.store(0, std::memory_order_relaxed);
+    }
+
+    fCaptureStart = hsTimer::GetTicks();
+    plProfileBase::fTracing.store(true, std::memory_order_relaxed);
+}
+
+void plProfileManager::IWriteCapture()
+{
+    FILE* fp = plFileSystem::Open(fCapturePath, "wb");
+    if (!fp)
+    {
+        hsStatusMessageF("Unable to write profile trace to %s", fCapturePath.AsString().c_str());
+        return;
+    }
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", fp);
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(s_traceBuffersMut);
+    for (const auto& buffer : s_traceBuffers)
+    {
+        uint64_t count = buffer->fCount.load(std::memory_order_acquire);
+        if (count == 0)
+            continue;
+
+        fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                first ? "" : ",\n", buffer->fThreadIdx);
+        if (buffer->fThreadHash == fMainThread)
+            fputs("\"Main\"", fp);
+        else
+            fprintf(fp, "\"Thread %u\"", buffer->fThreadIdx);
+        fputs("}}", fp);
+        first = false;
+
+        uint64_t begin = count > plProfileTraceBuffer::kNumEvents ? count - plProfileTraceBuffer::kNumEvents : 0;
+        for (uint64_t i = begin; i < count; i++)
+        {
+            const plProfileTraceEvent& event = buffer->fEvents[i & (plProfileTraceBuffer::kNumEvents - 1)];
+            // Events from threads that were already timing when we started
+            if (event.fTicks < fCaptureStart)
+                continue;
+
+            double usecs = hsTimer::GetSeconds(event.fTicks - fCaptureStart) * 1000000.0;
+            fprintf(fp, ",\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":",
+                    event.fType == plProfileTraceEvent::kBegin ? 'B' : 'E', buffer->fThreadIdx, usecs);
+            IWriteJSONString(fp, event.fVar->GetName());
+            fputs(",\"cat\":", fp);
+            IWriteJSONString(fp, event.fVar->GetGroup());
+            if (event.fLapName[0])
+            {
+                fputs(",\"args\":{\"lap\":", fp);
+                IWriteJSONString(fp, event.fLapName);
+                fputc('}', fp);
+            }
+            fputc('}', fp);
+        }
+    }
+
+    fputs("\n]}\n", fp);
+    fclose(fp);
+
+    hsStatusMessageF("Wrote profile trace to %s", fCapturePath.AsString().c_str());
 }
 
 uint64_t plProfileManager::GetTime()
@@ -380,32 +560,50 @@ plProfileVar::~plProfileVar()
 
 void plProfileVar::IBeginLap(const char* lapName)
 {
-    if (!fLaps)
-        fLaps = new plProfileLaps;
-    fDisplayFlags |= kDisplayLaps;
-    if(fLapsActive)
-        fLaps->BeginLap(fValue, lapName);
-    BeginTiming();
+    if (fActive)
+    {
+        if (!fLaps)
+            fLaps = new plProfileLaps;
+        fDisplayFlags |= kDisplayLaps;
+        if(fLapsActive)
+            fLaps->BeginLap(fValue, lapName);
+    }
+    IBeginTiming(lapName);
 }
 
 void plProfileVar::IEndLap(const char* lapName)
 {
-    EndTiming();
-    if(fLapsActive)
+    IEndTiming(lapName);
+    if(fActive && fLapsActive && fLaps)
         fLaps->EndLap(fValue, lapName);
 }
 
-void plProfileVar::IBeginTiming()
+void plProfileVar::IBeginTiming(const char* lapName)
 {
+    uint64_t ticks = hsTimer::GetTicks();
+    if (ITracing())
+        IRecordTraceEvent(plProfileTraceEvent::kBegin, this, lapName, ticks);
+
+    // We may only be here for the trace
+    if (!fActive)
+        return;
+
     if( hsCheckBits( fDisplayFlags, kDisplayResetEveryBegin ) )
         fValue = 0;
 
-    fValue -= hsTimer::GetTicks();
+    fValue -= ticks;
 }
 
-void plProfileVar::IEndTiming()
+void plProfileVar::IEndTiming(const char* lapName)
 {
-    fValue += hsTimer::GetTicks();
+    uint64_t ticks = hsTimer::GetTicks();
+    if (ITracing())
+        IRecordTraceEvent(plProfileTraceEvent::kEnd, this, lapName, ticks);
+
+    if (!fActive)
+        return;
+
+    fValue += ticks;
 
     fTimerSamples++;
 
@@ -45,6 +45,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "HeadSpin.h"
 #include <vector>
 
+#include "plFileSystem.h"
 #include "plProfile.h"
 
 class plProfileManager 
@@ -59,8 +60,18 @@ protected:
 
     uint32_t fProcessorSpeed;
 
+    // Trace capture
+    uint32_t   fCaptureFrames;     // Frames left to capture, counting the current one
+    bool       fCapturePending;    // Waiting for the next BeginFrame() to start
+    plFileName fCapturePath;
+    uint64_t   fCaptureStart;
+    size_t     fMainThread;
+
     plProfileManager();
 
+    void IStartCapture();
+    void IWriteCapture();
+
 public:
     ~plProfileManager();
 
@@ -73,6 +84,12 @@ public:
 
     void SetAvgTime(uint32_t avgMS);
 
+    // Record every timer begin/end on every thread for the next numFrames
+    // frames, then write them to filename as a Chrome trace (JSON), which
+    // chrome://tracing and the Perfetto UI can both open.
+    void BeginCapture(uint32_t numFrames, const plFileName& filename);
+    bool IsCapturing() const { return fCapturePending || fCaptureFrames > 0; }
+
     uint32_t GetProcessorSpeed() { return fProcessorSpeed; }
 
     // Backdoor for hack timers in calculated profiles
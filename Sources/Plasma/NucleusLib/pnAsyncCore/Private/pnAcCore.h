@@ -78,6 +78,7 @@ enum EAsyncPerfCounter {
     kAsyncPerfSocketConnAttemptsInTotal,
     kAsyncPerfSocketDisconnectBacklog,
     kAsyncPerfSocketDisconnectInvalidConnType,
+    kAsyncPerfSocketUringWritesTotal,
     kAsyncPerfNameLookupAttemptsCurr,
     kAsyncPerfNameLookupAttemptsTotal,
 
@@ -60,7 +60,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "Private/Nt/pnAceNt.h"
 #include "Private/Unix/pnAceUx.h"
 
+#ifdef HS_BUILD_FOR_WIN32
 #include <process.h>
+#endif
 
 #ifdef HS_BUILD_FOR_MACOS
 #include <malloc/malloc.h>
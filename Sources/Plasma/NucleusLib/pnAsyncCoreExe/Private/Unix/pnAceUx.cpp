@@ -0,0 +1,374 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+/*****************************************************************************
+*
+*   $/Plasma20/Sources/Plasma/NucleusLib/pnAsyncCoreExe/Private/Unix/pnAceUx.cpp
+*   
+***/
+
+#include "../../Pch.h"
+
+#ifdef HS_BUILD_FOR_LINUX
+
+#include "pnAceUxInt.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <csignal>
+#include <unistd.h>
+
+
+namespace Ux {
+
+/****************************************************************************
+*
+*   Private data
+*
+***/
+
+// The reactor only needs a handful of threads; notify callbacks are short
+// and the sockets themselves are never blocking.
+const unsigned kMaxWorkerThreads = 4;
+
+// Longest time a worker waits in epoll_wait before running maintenance
+// (connect timeouts, soft close timeouts and retired object cleanup)
+const int kMaintenanceMs = 250;
+
+const unsigned kMaxEventsPerWait = 64;
+
+static std::atomic<bool>        s_running;
+static hsEvent                  s_waitEvent;
+
+static int                      s_epoll = -1;
+static int                      s_wakeFd = -1;
+
+static unsigned                 s_ioThreadCount;
+static std::thread              s_ioThreads[kMaxWorkerThreads];
+
+// Retired objects are freed once every worker has started a new call to
+// epoll_wait after the object was unregistered; at that point no worker can
+// still be holding an event which refers to it.
+static std::atomic<uint64_t>    s_retireEpoch;
+static std::atomic<uint64_t>    s_workerEpoch[kMaxWorkerThreads];
+static std::mutex               s_retireCrit;
+static std::vector<UxObject *>  s_retireList;
+
+static std::mutex               s_maintenanceCrit;
+static unsigned                 s_maintenanceTimeMs;
+
+
+/****************************************************************************
+*
+*   Retired objects
+*
+***/
+
+//===========================================================================
+static void IUxFreeRetiredObjects (bool force) {
+    uint64_t safeEpoch = (uint64_t) -1;
+    if (!force) {
+        for (unsigned thread = 0; thread < s_ioThreadCount; ++thread)
+            safeEpoch = std::min(safeEpoch, s_workerEpoch[thread].load());
+    }
+
+    std::vector<UxObject *> freeList;
+    {
+        hsLockGuard(s_retireCrit);
+        auto keep = s_retireList.begin();
+        for (UxObject * obj : s_retireList) {
+            if (obj->retireEpoch <= safeEpoch && (force || IUxSocketCanDelete(obj)))
+                freeList.push_back(obj);
+            else
+                *keep++ = obj;
+        }
+        s_retireList.erase(keep, s_retireList.end());
+    }
+
+    for (UxObject * obj : freeList)
+        IUxSocketDeleteObject(obj);
+}
+
+//===========================================================================
+// Explicit wakeups (connect cancellation and failure) force a pass;
+// otherwise it runs at most once every kMaintenanceMs across all workers.
+static void IUxRunMaintenance (bool force) {
+    std::unique_lock<std::mutex> lock(s_maintenanceCrit, std::try_to_lock);
+    if (!lock.owns_lock())
+        return;
+
+    unsigned currTimeMs = TimeGetMs();
+    if (!force && (int) (currTimeMs - s_maintenanceTimeMs) < kMaintenanceMs)
+        return;
+    s_maintenanceTimeMs = currTimeMs;
+
+    IUxSocketMaintenance();
+    IUxFreeRetiredObjects(false);
+}
+
+
+/****************************************************************************
+*
+*   Worker threads
+*
+***/
+
+//===========================================================================
+static void UxWorkerThreadProc (unsigned threadIndex) {
+    PerfAddCounter(kAsyncPerfThreadsTotal, 1);
+    PerfAddCounter(kAsyncPerfThreadsCurr, 1);
+
+    // io_uring writes are issued from this thread and, unlike send(), a
+    // write to a reset socket raises SIGPIPE; keep it pending instead
+    sigset_t sigPipe;
+    sigemptyset(&sigPipe);
+    sigaddset(&sigPipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigPipe, nil);
+    IUxUringSetReactorThread();
+
+    epoll_event events[kMaxEventsPerWait];
+    while (s_running) {
+        // publish the epoch *before* waiting; any object retired after this
+        // point must wait for this thread to come around again
+        s_workerEpoch[threadIndex] = s_retireEpoch.load();
+
+        int count = epoll_wait(s_epoll, events, std::size(events), kMaintenanceMs);
+        if (count < 0) {
+            if (errno != EINTR)
+                LogMsg(kLogError, "epoll_wait failed ({})", errno);
+            count = 0;
+        }
+
+        bool wakeup = false;
+        for (int i = 0; i < count; ++i) {
+            uint64_t key = events[i].data.u64;
+            if (key == kUxWakeupKey) {
+                uint64_t value;
+                while (read(s_wakeFd, &value, sizeof(value)) > 0)
+                    ;
+                wakeup = true;
+            }
+            else if (key == kUxRingKey) {
+                IUxUringComplete();
+            }
+            else if (IUxIsConnectKey(key)) {
+                IUxSocketDispatchConnect(key, events[i].events);
+            }
+            else {
+                IUxSocketDispatchEvent((UxObject *) (uintptr_t) key, events[i].events);
+            }
+        }
+
+        // submit every write queued during this pass with one system call
+        IUxUringSubmit();
+
+        IUxRunMaintenance(wakeup);
+    }
+
+    // pass the shutdown wakeup on to the next worker
+    IUxWakeup();
+
+    PerfSubCounter(kAsyncPerfThreadsCurr, 1);
+}
+
+
+/****************************************************************************
+*
+*   Module functions
+*
+***/
+
+//===========================================================================
+bool IUxRegister (int fd, uint64_t key, uint32_t events) {
+    epoll_event ev;
+    ev.events   = events;
+    ev.data.u64 = key;
+    if (epoll_ctl(s_epoll, EPOLL_CTL_ADD, fd, &ev)) {
+        LogMsg(kLogError, "epoll_ctl(add) failed ({})", errno);
+        return false;
+    }
+    return true;
+}
+
+//===========================================================================
+// Re-registering a descriptor makes epoll re-evaluate its readiness, so an
+// edge is reported again for any condition which is already true
+void IUxRearm (int fd, uint64_t key, uint32_t events) {
+    epoll_event ev;
+    ev.events   = events;
+    ev.data.u64 = key;
+    if (epoll_ctl(s_epoll, EPOLL_CTL_MOD, fd, &ev))
+        LogMsg(kLogError, "epoll_ctl(mod) failed ({})", errno);
+}
+
+//===========================================================================
+void IUxUnregister (int fd) {
+    epoll_event ev = {};
+    epoll_ctl(s_epoll, EPOLL_CTL_DEL, fd, &ev);
+}
+
+//===========================================================================
+void IUxWakeup () {
+    if (s_wakeFd < 0)
+        return;
+    uint64_t value = 1;
+    (void) write(s_wakeFd, &value, sizeof(value));
+}
+
+//===========================================================================
+// The object must already have been unregistered from the reactor
+void IUxRetireObject (UxObject * obj) {
+    hsLockGuard(s_retireCrit);
+    obj->retireEpoch = ++s_retireEpoch;
+    s_retireList.push_back(obj);
+}
+
+
+/*****************************************************************************
+*
+*   Module exports
+*
+***/
+
+//===========================================================================
+void UxInitialize () {
+    // ensure initialization only occurs once
+    if (s_running)
+        return;
+
+    if (-1 == (s_epoll = epoll_create1(EPOLL_CLOEXEC)))
+        ErrorAssert(__LINE__, __FILE__, "epoll_create1 failed (%d)", errno);
+
+    if (-1 == (s_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)))
+        ErrorAssert(__LINE__, __FILE__, "eventfd failed (%d)", errno);
+    IUxRegister(s_wakeFd, kUxWakeupKey, EPOLLIN | EPOLLET);
+
+    // prefer io_uring for socket writes; fall back to sending from the
+    // epoll reactor if the kernel doesn't support everything we need
+    if (IUxUringInitialize())
+        LogMsg(kLogDebug, "AsyncCore: using io_uring socket writes");
+
+    // calculate number of IO worker threads to create
+    s_ioThreadCount = std::thread::hardware_concurrency();
+    s_ioThreadCount = std::max(s_ioThreadCount, 1u);
+    s_ioThreadCount = std::min(s_ioThreadCount, kMaxWorkerThreads);
+
+    s_running = true;
+    s_maintenanceTimeMs = TimeGetMs();
+    for (unsigned thread = 0; thread < s_ioThreadCount; ++thread) {
+        s_workerEpoch[thread] = s_retireEpoch.load();
+        s_ioThreads[thread] = std::thread(UxWorkerThreadProc, thread);
+    }
+}
+
+//===========================================================================
+void UxDestroy (unsigned /* exitThreadWaitMs */) {
+    // cleanup worker threads; they notice s_running within kMaintenanceMs
+    // even if the wakeup is lost, so there's no need to time out the joins
+    s_running = false;
+    IUxWakeup();
+    for (unsigned thread = 0; thread < s_ioThreadCount; ++thread) {
+        if (s_ioThreads[thread].joinable())
+            s_ioThreads[thread].join();
+    }
+    s_ioThreadCount = 0;
+
+    // fail outstanding connection attempts and close listeners
+    IUxSocketDestroy();
+    IUxUringDestroy();
+    IUxFreeRetiredObjects(true);
+
+    if (s_wakeFd != -1) {
+        close(s_wakeFd);
+        s_wakeFd = -1;
+    }
+    if (s_epoll != -1) {
+        close(s_epoll);
+        s_epoll = -1;
+    }
+}
+
+//===========================================================================
+void UxSignalShutdown () {
+    s_waitEvent.Signal();
+}
+
+//===========================================================================
+void UxWaitForShutdown () {
+    s_waitEvent.Wait();
+}
+
+//===========================================================================
+void UxSleep (unsigned sleepMs) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+}
+
+} using namespace Ux;
+
+
+/****************************************************************************
+*
+*   Public exports
+*
+***/
+
+//===========================================================================
+void UxGetApi (AsyncApi * api) {
+    api->initialize             = UxInitialize;
+    api->destroy                = UxDestroy;
+    api->signalShutdown         = UxSignalShutdown;
+    api->waitForShutdown        = UxWaitForShutdown;
+    api->sleep                  = UxSleep;
+    
+    api->socketConnect          = UxSocketConnect;
+    api->socketConnectCancel    = UxSocketConnectCancel;
+    api->socketDisconnect       = UxSocketDisconnect;
+    api->socketDelete           = UxSocketDelete;
+    api->socketSend             = UxSocketSend;
+    api->socketWrite            = UxSocketWrite;
+    api->socketSetNotifyProc    = UxSocketSetNotifyProc;
+    api->socketSetBacklogAlloc  = UxSocketSetBacklogAlloc;
+    api->socketStartListening   = UxSocketStartListening;
+    api->socketStopListening    = UxSocketStopListening;
+    api->socketEnableNagling    = UxSocketEnableNagling;
+}
+
+#endif // HS_BUILD_FOR_LINUX
@@ -51,14 +51,14 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #define PLASMA20_SOURCES_PLASMA_NUCLEUSLIB_PNASYNCCOREEXE_PRIVATE_UNIX_PNACEUX_H
 
 
-#ifdef HS_BUILD_FOR_UNIX
+#ifdef HS_BUILD_FOR_LINUX
 
 /****************************************************************************
 *
-*   Win9x API functions
+*   Unix (epoll) API functions
 *
 ***/
 
 void UxGetApi (AsyncApi * api);
 
-#endif // HS_BUILD_FOR_UNIX
+#endif // HS_BUILD_FOR_LINUX
@@ -0,0 +1,354 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+/*****************************************************************************
+*
+*   $/Plasma20/Sources/Plasma/NucleusLib/pnAsyncCoreExe/Private/Unix/pnAceUxDns.cpp
+*   
+***/
+
+#include "../../Pch.h"
+
+#ifdef HS_BUILD_FOR_LINUX
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+
+/*****************************************************************************
+*
+*   Private
+*
+***/
+
+const unsigned kMaxLookupName = 128;
+
+struct Lookup {
+    AsyncCancelId       cancelId;
+    bool                canceled;
+    bool                byAddr;
+    plNetAddress        addr;
+    FAsyncLookupProc    lookupProc;
+    unsigned            port;
+    void *              param;
+    char                name[kMaxLookupName];
+};
+
+// getaddrinfo() blocks, so lookups are queued to a thread of their own
+// and resolved one at a time, the way WSAAsyncGetHostByName does it.
+static std::mutex               s_critsect;
+static std::condition_variable  s_lookupSignal;
+static std::condition_variable  s_exitSignal;
+static std::deque<Lookup *>     s_lookupList;
+static Lookup *                 s_lookupCurr;
+static bool                     s_lookupStarted;
+static unsigned                 s_lookupThreads;
+static uintptr_t                s_lookupGeneration;
+static unsigned                 s_nextLookupCancelId = 1;
+
+
+/*****************************************************************************
+*
+*   Internal functions
+*
+***/
+
+//===========================================================================
+// Returns false if the name could not be resolved
+static bool LookupResolve (Lookup * lookup, std::vector<plNetAddress> * addrs) {
+    if (lookup->byAddr) {
+        char host[NI_MAXHOST];
+        const sockaddr_in & sa = lookup->addr.GetAddressInfo();
+        if (getnameinfo((const sockaddr *) &sa, sizeof(sa), host, sizeof(host), nil, 0, NI_NAMEREQD))
+            return false;
+
+        strncpy(lookup->name, host, std::size(lookup->name));
+        lookup->name[std::size(lookup->name) - 1] = 0;
+        addrs->push_back(lookup->addr);
+        return true;
+    }
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family     = AF_INET;
+    hints.ai_socktype   = SOCK_STREAM;
+    hints.ai_flags      = AI_CANONNAME;
+
+    addrinfo * result;
+    if (getaddrinfo(lookup->name, nil, &hints, &result))
+        return false;
+
+    for (const addrinfo * info = result; info; info = info->ai_next) {
+        if (info->ai_family != AF_INET)
+            continue;
+
+        plNetAddress addr;
+        addr.SetHost(((const sockaddr_in *) info->ai_addr)->sin_addr.s_addr);
+        addr.SetPort(lookup->port);
+
+        // a name usually comes back once per socket type; only keep one
+        if (std::find(addrs->begin(), addrs->end(), addr) == addrs->end())
+            addrs->push_back(addr);
+    }
+
+    if (result->ai_canonname && result->ai_canonname[0]) {
+        strncpy(lookup->name, result->ai_canonname, std::size(lookup->name));
+        lookup->name[std::size(lookup->name) - 1] = 0;
+    }
+
+    freeaddrinfo(result);
+    return !addrs->empty();
+}
+
+//===========================================================================
+static void LookupDelete (Lookup * lookup) {
+    delete lookup;
+    PerfSubCounter(kAsyncPerfNameLookupAttemptsCurr, 1);
+}
+
+//===========================================================================
+// Lookups which fail are reported with an empty address list
+static void LookupProcess (Lookup * lookup) {
+    std::vector<plNetAddress> addrs;
+    bool found = LookupResolve(lookup, &addrs);
+
+    // it may have been canceled while we were waiting on the resolver
+    bool canceled;
+    {
+        std::lock_guard<std::mutex> lock(s_critsect);
+        canceled = lookup->canceled;
+        if (s_lookupCurr == lookup)
+            s_lookupCurr = nil;
+    }
+
+    if (!canceled && lookup->lookupProc)
+        lookup->lookupProc(lookup->param, lookup->name, found ? (unsigned) addrs.size() : 0, addrs.data());
+
+    LookupDelete(lookup);
+}
+
+//===========================================================================
+// Each thread serves one AsyncCore lifetime; if DnsDestroy gives up on a
+// thread stuck in the resolver, it quietly exits once the resolver returns.
+static unsigned THREADCALL LookupThreadProc (AsyncThread * thread) {
+    const uintptr_t generation = (uintptr_t) thread->argument;
+    for (;;) {
+        Lookup * lookup;
+        bool canceled;
+        {
+            std::unique_lock<std::mutex> lock(s_critsect);
+            s_lookupSignal.wait(lock, [=] {
+                return s_lookupGeneration != generation || !s_lookupList.empty();
+            });
+            if (s_lookupGeneration != generation)
+                break;
+
+            lookup = s_lookupList.front();
+            s_lookupList.pop_front();
+            canceled = lookup->canceled;
+            if (!canceled)
+                s_lookupCurr = lookup;
+        }
+
+        // canceled lookups are dropped without a callback
+        if (canceled)
+            LookupDelete(lookup);
+        else
+            LookupProcess(lookup);
+    }
+
+    std::lock_guard<std::mutex> lock(s_critsect);
+    --s_lookupThreads;
+    s_exitSignal.notify_all();
+    return 0;
+}
+
+//===========================================================================
+// must be called inside s_critsect
+static void QueueLookup (Lookup * lookup, AsyncCancelId * cancelId) {
+    if (!s_lookupStarted) {
+        s_lookupStarted = true;
+        ++s_lookupThreads;
+        AsyncThreadCreate(LookupThreadProc, (void *) s_lookupGeneration, L"AsyncLookupThread");
+    }
+
+    // get cancel id; we can avoid checking for zero by always using an odd number
+    ASSERT(s_nextLookupCancelId & 1);
+    s_nextLookupCancelId += 2;
+    *cancelId = lookup->cancelId = (AsyncCancelId) (uintptr_t) s_nextLookupCancelId;
+
+    s_lookupList.push_back(lookup);
+    s_lookupSignal.notify_one();
+}
+
+
+/*****************************************************************************
+*
+*   Module functions
+*
+***/
+
+//===========================================================================
+void DnsDestroy (unsigned exitThreadWaitMs) {
+    // fail all pending name lookups, and the one in progress
+    std::deque<Lookup *> pending;
+    {
+        std::lock_guard<std::mutex> lock(s_critsect);
+        if (!s_lookupStarted)
+            return;
+        s_lookupStarted = false;
+        ++s_lookupGeneration;
+
+        pending.swap(s_lookupList);
+        if (s_lookupCurr)
+            s_lookupCurr->canceled = true;
+        s_lookupSignal.notify_all();
+    }
+    for (Lookup * lookup : pending)
+        LookupDelete(lookup);
+
+    std::unique_lock<std::mutex> lock(s_critsect);
+    s_exitSignal.wait_for(lock, std::chrono::milliseconds(exitThreadWaitMs), [] {
+        return !s_lookupThreads;
+    });
+}
+
+
+/*****************************************************************************
+*
+*   Public functions
+*
+***/
+
+//===========================================================================
+void AsyncAddressLookupName (
+    AsyncCancelId *     cancelId,   // out
+    FAsyncLookupProc    lookupProc,
+    const char*         name, 
+    unsigned            port, 
+    void *              param
+) {
+    ASSERT(lookupProc);
+    ASSERT(name);
+
+    PerfAddCounter(kAsyncPerfNameLookupAttemptsCurr, 1);
+    PerfAddCounter(kAsyncPerfNameLookupAttemptsTotal, 1);
+
+    // Initialize lookup
+    Lookup * lookup         = new Lookup;
+    lookup->canceled        = false;
+    lookup->byAddr          = false;
+    lookup->lookupProc      = lookupProc;
+    lookup->port            = port;
+    lookup->param           = param;
+    strncpy(lookup->name, name, std::size(lookup->name));
+    lookup->name[std::size(lookup->name) - 1] = 0;
+
+    // Get name/port
+    if (char* portStr = strchr(lookup->name, ':')) {
+        if (unsigned long newPort = strtoul(portStr + 1, nullptr, 10))
+            lookup->port = newPort;
+        *portStr = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(s_critsect);
+    QueueLookup(lookup, cancelId);
+}
+
+//===========================================================================
+void AsyncAddressLookupAddr (
+    AsyncCancelId *     cancelId,   // out
+    FAsyncLookupProc    lookupProc,
+    const plNetAddress& address,
+    void *              param
+) {
+    ASSERT(lookupProc);
+
+    PerfAddCounter(kAsyncPerfNameLookupAttemptsCurr, 1);
+    PerfAddCounter(kAsyncPerfNameLookupAttemptsTotal, 1);
+
+    // Initialize lookup
+    Lookup * lookup         = new Lookup;
+    lookup->canceled        = false;
+    lookup->byAddr          = true;
+    lookup->addr            = address;
+    lookup->lookupProc      = lookupProc;
+    lookup->port            = address.GetPort();
+    lookup->param           = param;
+
+    ST::string str = address.GetHostString();
+    strncpy(lookup->name, str.c_str(), std::size(lookup->name));
+    lookup->name[std::size(lookup->name) - 1] = 0;
+
+    std::lock_guard<std::mutex> lock(s_critsect);
+    QueueLookup(lookup, cancelId);
+}
+
+//===========================================================================
+void AsyncAddressLookupCancel (
+    FAsyncLookupProc    lookupProc,
+    AsyncCancelId       cancelId        // nil = cancel all with specified lookupProc
+) {
+    std::lock_guard<std::mutex> lock(s_critsect);
+
+    auto matches = [=](const Lookup * lookup) {
+        if (lookup->lookupProc && (lookup->lookupProc != lookupProc))
+            return false;
+        if (cancelId && (lookup->cancelId != cancelId))
+            return false;
+        return true;
+    };
+
+    for (Lookup * lookup : s_lookupList) {
+        if (matches(lookup))
+            lookup->canceled = true;
+    }
+
+    // the resolver can't be interrupted, but its answer won't be reported
+    if (s_lookupCurr && matches(s_lookupCurr))
+        s_lookupCurr->canceled = true;
+}
+
+#endif // HS_BUILD_FOR_LINUX
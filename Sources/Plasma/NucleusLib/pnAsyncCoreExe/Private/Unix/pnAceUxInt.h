@@ -0,0 +1,223 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+/*****************************************************************************
+*
+*   $/Plasma20/Sources/Plasma/NucleusLib/pnAsyncCoreExe/Private/Unix/pnAceUxInt.h
+*   
+***/
+
+#ifdef PLASMA20_SOURCES_PLASMA_NUCLEUSLIB_PNASYNCCOREEXE_PRIVATE_UNIX_PNACEUXINT_H
+#error "Header $/Plasma20/Sources/Plasma/NucleusLib/pnAsyncCoreExe/Private/Unix/pnAceUxInt.h included more than once"
+#endif
+#define PLASMA20_SOURCES_PLASMA_NUCLEUSLIB_PNASYNCCOREEXE_PRIVATE_UNIX_PNACEUXINT_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Ux {
+
+/****************************************************************************
+*
+*   Type definitions
+*
+***/
+
+enum EIoType {
+    kUxSocket,
+    kUxListener,
+    kIoTypes
+};
+
+// Every object registered with the epoll reactor starts with a UxObject so
+// the worker threads can tell what kind of object an event refers to.
+// Objects are never freed directly once they have been registered; they are
+// retired through IUxRetireObject so that a worker which dequeued an event
+// just before the object was unregistered never touches freed memory.
+struct UxObject {
+    std::recursive_mutex        critsect;
+    EIoType                     ioType;
+    int                         fd;
+    void *                      userState;
+    uint64_t                    retireEpoch;
+
+    UxObject()
+        : ioType((EIoType)0), fd(-1), userState(nil), retireEpoch(0) { }
+};
+
+
+/****************************************************************************
+*
+*   Ux.cpp internal functions
+*
+***/
+
+// Connection attempts are registered by cancel id rather than by pointer;
+// cancel ids are always odd and object pointers are always even, which lets
+// one epoll_data_t carry either. The two small even keys are reserved for
+// the reactor's own descriptors.
+const uint64_t kUxWakeupKey = 0;
+const uint64_t kUxRingKey   = 2;
+inline bool IUxIsConnectKey (uint64_t key) { return (key & 1) != 0; }
+
+bool IUxRegister (int fd, uint64_t key, uint32_t events);
+void IUxRearm (int fd, uint64_t key, uint32_t events);
+void IUxUnregister (int fd);
+void IUxWakeup ();
+void IUxRetireObject (UxObject * obj);
+
+
+/*****************************************************************************
+*
+*   UxSocket.cpp internal functions
+*
+***/
+
+struct UxSock;
+
+void IUxSocketDestroy ();
+void IUxSocketMaintenance ();
+bool IUxSocketCanDelete (UxObject * obj);
+void IUxSocketDeleteObject (UxObject * obj);
+
+void IUxSocketDispatchEvent (UxObject * obj, uint32_t events);
+void IUxSocketDispatchConnect (uint64_t cancelKey, uint32_t events);
+void IUxSocketCompleteWrite (UxObject * obj, int result);
+
+
+/*****************************************************************************
+*
+*   UxUring.cpp internal functions
+*
+***/
+
+// When the kernel supports it, socket writes are submitted through an
+// io_uring instead of being sent from the reactor with sendmsg(). Writes
+// are staged in registered buffers and submitted in batches by the
+// reactor; completions are delivered through IUxSocketCompleteWrite.
+bool IUxUringInitialize ();
+void IUxUringDestroy ();
+bool IUxUringActive ();
+
+uint8_t * IUxUringAllocBuffer (int * bufIndex);
+void IUxUringFreeBuffer (int bufIndex);
+unsigned IUxUringBufferBytes ();
+
+// Queues a write from any thread; it is always submitted by a reactor
+// thread on its next pass, which also keeps SIGPIPE off other threads
+void IUxUringQueueWrite (
+    int             fd,
+    uint64_t        key,
+    const uint8_t * data,
+    unsigned        bytes,
+    int             bufIndex
+);
+void IUxUringSubmit ();
+void IUxUringComplete ();
+
+// Marks the calling thread as a reactor thread; SIGPIPE must be blocked
+void IUxUringSetReactorThread ();
+
+
+/*****************************************************************************
+*
+*   Unix Async API functions
+*
+***/
+
+void UxInitialize ();
+void UxDestroy (unsigned exitThreadWaitMs);
+void UxSignalShutdown ();
+void UxWaitForShutdown ();
+void UxSleep (unsigned sleepMs);
+void UxSocketConnect (
+    AsyncCancelId *         cancelId,
+    const plNetAddress&     netAddr,
+    FAsyncNotifySocketProc  notifyProc,
+    void *                  param,
+    const void *            sendData,
+    unsigned                sendBytes,
+    unsigned                connectMs,
+    unsigned                localPort
+);
+void UxSocketConnectCancel (
+    FAsyncNotifySocketProc  notifyProc,
+    AsyncCancelId           cancelId
+);
+void UxSocketDisconnect (
+    AsyncSocket     sock,
+    bool            hardClose
+);
+void UxSocketDelete (AsyncSocket sock);
+bool UxSocketSend (
+    AsyncSocket     sock,
+    const void *    data,
+    unsigned        bytes
+);
+bool UxSocketWrite (
+    AsyncSocket     sock,
+    const void *    buffer,
+    unsigned        bytes,
+    void *          param
+);
+void UxSocketSetNotifyProc (
+    AsyncSocket             sock,
+    FAsyncNotifySocketProc  notifyProc
+);
+void UxSocketSetBacklogAlloc (
+    AsyncSocket     sock,
+    unsigned        bufferSize
+);
+unsigned UxSocketStartListening (
+    const plNetAddress&     listenAddr,
+    FAsyncNotifySocketProc  notifyProc
+);
+void UxSocketStopListening (
+    const plNetAddress&     listenAddr,
+    FAsyncNotifySocketProc  notifyProc
+);
+void UxSocketEnableNagling (
+    AsyncSocket             conn,
+    bool                    enable
+);
+
+}   // namespace Ux
@@ -0,0 +1,1493 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+/*****************************************************************************
+*
+*   $/Plasma20/Sources/Plasma/NucleusLib/pnAsyncCoreExe/Private/Unix/pnAceUxSocket.cpp
+*   
+***/
+
+#include "../../Pch.h"
+
+#ifdef HS_BUILD_FOR_LINUX
+
+#include "pnAceUxInt.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <deque>
+#include <list>
+#include <vector>
+
+
+namespace Ux {
+
+/****************************************************************************
+*
+*   Private
+*
+***/
+
+// how long to wait for connect() to complete
+static const unsigned   kConnectTimeMs      = 10*1000;
+
+static const int        kTcpSndBufSize      = 64*1024-1;
+static const int        kTcpRcvBufSize      = 64*1024-1;
+static const int        kListenBacklog      = 400;
+
+// wait before checking for backlog problems
+static const unsigned   kBacklogInitMs      = 3*60*1000;
+
+// destroy a connection if it has a backlog "problem"
+static const unsigned   kBacklogFailMs      = 2*60*1000;
+
+static const unsigned   kMinBacklogBytes    = 4 * 1024;
+
+// maximum number of queued buffers handed to the kernel per sendmsg()
+static const unsigned   kMaxWriteIov        = 16;
+
+// Sockets stay registered for every event for their whole lifetime; the
+// registration is edge-triggered so each state change is reported once.
+static const uint32_t   kSocketEvents       = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+
+struct UxListener : UxObject {
+    plNetAddress            addr;
+    FAsyncNotifySocketProc  notifyProc;
+    int                     listenCount;
+
+    UxListener() : notifyProc(nil), listenCount(0) {
+        ioType = kUxListener;
+    }
+};
+
+struct UxOpConnAttempt {
+    AsyncCancelId           cancelId;
+    bool                    canceled;
+    unsigned                localPort;
+    plNetAddress            remoteAddr;
+    FAsyncNotifySocketProc  notifyProc;
+    void *                  param;
+    int                     fd;
+    unsigned                failTimeMs;
+    unsigned                sendBytes;
+    uint8_t                 sendData[1];    // actually [sendBytes]
+    // no additional fields
+};
+
+struct UxOpSocketWrite {
+    bool                    notify;
+    int                     bufIndex;       // io_uring registered buffer, or -1
+    unsigned                queueTimeMs;
+    unsigned                bytesAlloc;
+    unsigned                bytesSent;
+    AsyncNotifySocketWrite  write;
+
+    UxOpSocketWrite()
+        : notify(false), bufIndex(-1), queueTimeMs(0), bytesAlloc(0), bytesSent(0) { }
+};
+
+struct UxSock;
+typedef std::list<UxSock *> UxSockList;
+typedef std::vector<UxOpSocketWrite *> UxWriteList;
+
+struct UxSock : UxObject {
+    UxSockList::iterator    closeLink;      // valid while closeLinked
+    bool                    closeLinked;
+    plNetAddress            addr;
+    unsigned                closeTimeMs;
+    bool                    aborted;
+    unsigned                connType;
+    FAsyncNotifySocketProc  notifyProc;
+    unsigned                bytesLeft;
+    AsyncNotifySocketRead   read;
+    unsigned                backlogAlloc;
+    unsigned                initTimeMs;
+    std::deque<UxOpSocketWrite *> writeList;
+
+    // Only one worker processes a socket at a time; events which arrive
+    // on another worker while the socket is being processed are merged
+    // into pendingEvents and handled by the worker which owns it.
+    bool                    dispatching;
+    uint32_t                pendingEvents;
+
+    // io_uring: set while the head of writeList has been handed to the
+    // kernel. The descriptor is kept open (deferredCloseFd) and the
+    // socket is kept alive until that write completes.
+    bool                    sendInFlight;
+    int                     deferredCloseFd;
+
+    uint8_t                 buffer[kAsyncSocketBufferSize];
+
+    UxSock ();
+    ~UxSock ();
+};
+
+
+static std::recursive_mutex             s_listenCrit;
+static std::vector<UxListener *>        s_listenList;
+
+static std::recursive_mutex             s_connectCrit;
+static std::vector<UxOpConnAttempt *>   s_connectList;
+static unsigned                         s_nextConnectCancelId = 1;
+
+
+// soft closed sockets, in the order their close times out
+const unsigned kCloseTimeoutMs = 8*1000;
+static std::recursive_mutex             s_socketCrit;
+static UxSockList                       s_closeList;
+
+
+//===========================================================================
+static void FreeWrite (UxOpSocketWrite * op) {
+    if (op->bufIndex >= 0)
+        IUxUringFreeBuffer(op->bufIndex);
+    op->~UxOpSocketWrite();
+    free(op);
+}
+
+//===========================================================================
+inline UxSock::UxSock ()
+    : closeLinked(false), closeTimeMs(0), aborted(false), connType(0), notifyProc(nil), bytesLeft(0)
+    , backlogAlloc(0), initTimeMs(0), dispatching(false), pendingEvents(0)
+    , sendInFlight(false), deferredCloseFd(-1)
+{
+    ioType = kUxSocket;
+    memset(buffer, 0, sizeof(buffer));
+
+    PerfAddCounter(kAsyncPerfSocketsCurr, 1);
+    PerfAddCounter(kAsyncPerfSocketsTotal, 1);
+}
+
+//===========================================================================
+UxSock::~UxSock () {
+    // Make sure socket can only be deleted after it has been closed
+    ASSERT(fd == -1);
+
+    ASSERT(!sendInFlight);
+    for (UxOpSocketWrite * op : writeList)
+        FreeWrite(op);
+
+    PerfSubCounter(kAsyncPerfSocketsCurr, 1);
+}
+
+//===========================================================================
+static inline uint64_t SocketKey (UxObject * obj) {
+    return (uint64_t) (uintptr_t) obj;
+}
+
+//===========================================================================
+// must be called inside s_listenCrit
+static bool ListenPortIncrement (
+    const plNetAddress&     listenAddr,
+    FAsyncNotifySocketProc  notifyProc,
+    int                     count
+) {
+    for (auto it = s_listenList.begin(); it != s_listenList.end(); ++it) {
+        UxListener * listener = *it;
+        if (listener->addr != listenAddr)
+            continue;
+        if (listener->notifyProc != notifyProc)
+            continue;
+
+        listener->listenCount += count;
+        ASSERT(listener->listenCount >= 0);
+
+        // destroy unused ports
+        if (!listener->listenCount) {
+            s_listenList.erase(it);
+            IUxUnregister(listener->fd);
+            close(listener->fd);
+            listener->fd = -1;
+            IUxRetireObject(listener);
+        }
+        return true;
+    }
+    return false;
+}
+
+//===========================================================================
+static void SocketGetAddresses (
+    UxSock *        sock,
+    plNetAddress*   localAddr,
+    plNetAddress*   remoteAddr
+) {
+    localAddr->Clear();
+    remoteAddr->Clear();
+
+    // don't have to enter critsect or validate socket before referencing it
+    // because this routine is called before the user has a chance to close it
+    socklen_t nameLen = sizeof(AddressType);
+    if (getsockname(sock->fd, (sockaddr *) &localAddr->GetAddressInfo(), &nameLen))
+        LogMsg(kLogError, "getsockname failed");
+
+    nameLen = sizeof(AddressType);
+    if (getpeername(sock->fd, (sockaddr *) &remoteAddr->GetAddressInfo(), &nameLen))
+        LogMsg(kLogError, "getpeername failed");
+}
+
+//===========================================================================
+// Makes the eventual close() abortive; any unsent data is lost
+static void SetHardClose (int fd) {
+    static const linger s_linger = { true, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &s_linger, sizeof(s_linger));
+}
+
+//===========================================================================
+// must be called inside sock->critsect
+static void FreeQueuedWrites (UxSock * sock) {
+    for (UxOpSocketWrite * op : sock->writeList) {
+        PerfSubCounter(kAsyncPerfSocketBytesWaitQueued, op->write.bytes - op->bytesSent);
+        FreeWrite(op);
+    }
+    sock->writeList.clear();
+}
+
+//===========================================================================
+// must be called inside sock->critsect
+static void SocketAbort (UxSock * sock) {
+    if (sock->fd == -1)
+        return;
+
+    // Mark the socket closed in such a way that, if it has already been
+    // soft closed, the mark won't invalidate the ordering of s_closeList
+    sock->closeTimeMs |= 1;
+    sock->aborted = true;
+
+    // The reactor owns the descriptor, so rather than closing it here shut
+    // it down and let the owning worker complete the close; re-arming makes
+    // sure a worker sees the hangup even if it raced with this call.
+    shutdown(sock->fd, SHUT_RDWR);
+    IUxRearm(sock->fd, SocketKey(sock), kSocketEvents);
+}
+
+//===========================================================================
+static void SocketClose (UxSock * sock) {
+    int fd;
+    bool deferClose;
+    {
+        hsLockGuard(s_socketCrit);
+        hsLockGuard(sock->critsect);
+
+        fd = sock->fd;
+        sock->fd = -1;
+        sock->closeTimeMs |= 1;
+
+        // To avoid a race condition, the socket must be unlinked from
+        // the soft disconnect list before anyone can delete it
+        if (sock->closeLinked) {
+            s_closeList.erase(sock->closeLink);
+            sock->closeLinked = false;
+        }
+
+        // The kernel may still be reading from the head of the write
+        // queue; closing now would also let the descriptor number be
+        // reused under the pending write. IUxSocketCompleteWrite
+        // finishes the job. Otherwise any data still queued is lost.
+        deferClose = sock->sendInFlight;
+        if (deferClose)
+            sock->deferredCloseFd = fd;
+        else
+            FreeQueuedWrites(sock);
+    }
+
+    if (fd != -1) {
+        IUxUnregister(fd);
+        if (sock->aborted)
+            SetHardClose(fd);
+        if (!deferClose)
+            close(fd);
+    }
+
+    if (sock->notifyProc) {
+        // We have to be extremely careful from this point because
+        // sockets can be deleted during the notification callback.
+        // After this call, the application becomes responsible for
+        // calling UxSocketDelete at some later point in time.
+        FAsyncNotifySocketProc notifyProc   = sock->notifyProc;
+        sock->notifyProc                    = nil;
+        notifyProc((AsyncSocket) sock, kNotifySocketDisconnect, nil, &sock->userState);
+    }
+    else {
+        // Since the no application notification procedure was
+        // ever set, the socket can now be deleted safely.
+        UxSocketDelete((AsyncSocket) sock);
+    }
+}
+
+//===========================================================================
+static bool SocketDispatchRead (UxSock * sock) {
+    // put "fast case" first -- connType already established
+    if (sock->notifyProc)
+        return sock->notifyProc((AsyncSocket) sock, kNotifySocketRead, &sock->read, &sock->userState);
+
+    ASSERT(sock->read.buffer == sock->buffer);
+    ASSERT(sock->read.bytes);
+
+    // make sure there's an event procedure to handle this event
+    AsyncNotifySocketListen notify;
+    unsigned bytesProcessed;
+    sock->notifyProc = AsyncSocketFindNotifyProc(
+        sock->read.buffer,
+        sock->read.bytes,
+        &bytesProcessed,
+        &notify.connType, 
+        &notify.buildId,
+        &notify.buildType,
+        &notify.branchId,
+        &notify.productId
+    );
+    if (!sock->notifyProc)
+        return false;
+
+    // perform kNotifySocketListenSuccess
+    SocketGetAddresses(sock, &notify.localAddr, &notify.remoteAddr);
+    notify.param            = nil;
+    notify.asyncId          = 0;
+    notify.addr             = sock->addr;
+    sock->userState         = nil;
+    sock->connType          = notify.connType;
+    notify.buffer           = sock->read.buffer + bytesProcessed;
+    notify.bytes            = sock->read.bytes - bytesProcessed;
+    notify.bytesProcessed   = 0;
+    if (!sock->notifyProc((AsyncSocket) sock, kNotifySocketListenSuccess, &notify, &sock->userState))
+        return false;
+    bytesProcessed += notify.bytesProcessed;
+
+    // if we didn't use up all the bytes, dispatch a read operation
+    if (0 != (sock->read.bytes -= bytesProcessed)) {
+        sock->read.buffer += bytesProcessed;
+        if (!sock->notifyProc((AsyncSocket) sock, kNotifySocketRead, &sock->read, &sock->userState))
+            return false;
+    }
+
+    // add bytes used by IOsFindListenProc and kNotifySocketListenSuccess
+    sock->read.bytesProcessed += bytesProcessed;
+    return true;
+}
+
+//===========================================================================
+static bool SocketCompleteRead (UxSock * sock, unsigned bytes) {
+    // add new bytes to buffer bytes
+    sock->bytesLeft += bytes;
+
+    // dispatch data
+    sock->read.param            = nil;
+    sock->read.asyncId          = 0;
+    sock->read.buffer           = sock->buffer;
+    sock->read.bytes            = sock->bytesLeft;
+    sock->read.bytesProcessed   = 0;
+
+    if (!SocketDispatchRead(sock))
+        return false;
+
+    // if only some of the bytes were used then shift
+    // remaining bytes down otherwise clear buffer.
+    if (0 != (sock->bytesLeft -= sock->read.bytesProcessed)) {
+        if ((sock->bytesLeft > sizeof(sock->buffer))
+        ||  ((sock->read.bytesProcessed + sock->bytesLeft) > sizeof(sock->buffer))
+        ) {
+            LogMsg(
+                kLogError,
+                "SocketDispatchRead error for {}: {} {} {}",
+                (void *) sock->notifyProc,
+                sock->bytesLeft,
+                sock->read.bytes,
+                sock->read.bytesProcessed
+            );
+            return false;
+        }
+
+        if (sock->read.bytesProcessed) {
+            memmove(
+                sock->buffer,
+                sock->buffer + sock->read.bytesProcessed,
+                sock->bytesLeft
+            );
+        }
+
+        // make sure there's enough space left in the buffer for another read
+        if (sock->bytesLeft >= sizeof(sock->buffer))
+            return false;
+    }
+
+    return true;
+}
+
+//===========================================================================
+// Edge-triggered: keep reading until the kernel has nothing more for us
+static bool SocketRead (UxSock * sock) {
+    for (;;) {
+        ssize_t bytes = recv(
+            sock->fd,
+            sock->buffer + sock->bytesLeft,
+            sizeof(sock->buffer) - sock->bytesLeft,
+            0
+        );
+        if (bytes < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        // a zero-byte read means the socket is going
+        // to shutdown, so don't read any further
+        if (!bytes)
+            return false;
+
+        if (!SocketCompleteRead(sock, (unsigned) bytes))
+            return false;
+    }
+}
+
+//===========================================================================
+// must be called inside sock->critsect
+static UxOpSocketWrite * SocketQueueWrite (
+    UxSock *        sock,
+    const uint8_t * data,
+    unsigned        bytes
+) {
+    // check for data backlog
+    if (!sock->writeList.empty()) {
+        UxOpSocketWrite * firstQueuedWrite = sock->writeList.front();
+        unsigned currTimeMs = TimeGetMs();
+        if (((long) (currTimeMs - firstQueuedWrite->queueTimeMs) >= (long) kBacklogFailMs)
+        &&  ((long) (currTimeMs - sock->initTimeMs) >= (long) kBacklogInitMs)
+        ) {
+            PerfAddCounter(kAsyncPerfSocketDisconnectBacklog, 1);
+
+            if (sock->connType) {
+                LogMsg(
+                    kLogPerf,
+                    "Backlog, c:{} q:{}, i:{}",
+                    sock->connType,
+                    currTimeMs - firstQueuedWrite->queueTimeMs,
+                    currTimeMs - sock->initTimeMs
+                );
+            }
+            SocketAbort(sock);
+            return nil;
+        }
+    }
+
+    // if the last buffer still has space available then add data to it
+    UxOpSocketWrite * lastQueuedWrite = sock->writeList.empty() ? nil : sock->writeList.back();
+    if (lastQueuedWrite && !lastQueuedWrite->notify) {
+        unsigned bytesLeft = lastQueuedWrite->bytesAlloc - lastQueuedWrite->write.bytes;
+        bytesLeft = std::min(bytesLeft, bytes);
+        if (bytesLeft) {
+            PerfAddCounter(kAsyncPerfSocketBytesWaitQueued, bytesLeft);
+            memcpy(lastQueuedWrite->write.buffer + lastQueuedWrite->write.bytes, data, bytesLeft);
+            lastQueuedWrite->write.bytes += bytesLeft;
+            lastQueuedWrite->write.bytesProcessed += bytesLeft;
+            data += bytesLeft;
+            if (0 == (bytes -= bytesLeft))
+                return lastQueuedWrite;
+        }
+    }
+
+    // prefer a registered buffer when writes go through io_uring; they
+    // are large enough to coalesce several packets
+    UxOpSocketWrite * op = nil;
+    if (IUxUringActive() && bytes <= IUxUringBufferBytes()) {
+        int bufIndex;
+        if (uint8_t * buffer = IUxUringAllocBuffer(&bufIndex)) {
+            op = new(malloc(sizeof(UxOpSocketWrite))) UxOpSocketWrite;
+            op->bufIndex        = bufIndex;
+            op->bytesAlloc      = IUxUringBufferBytes();
+            op->write.buffer    = buffer;
+        }
+    }
+
+    // otherwise allocate a buffer large enough to hold the data, plus
+    // extra space in case more data needs to be queued later
+    if (!op) {
+        unsigned bytesAlloc = std::max(bytes, sock->backlogAlloc);
+        bytesAlloc          = std::max(bytesAlloc, kMinBacklogBytes);
+        op = new(malloc(sizeof(UxOpSocketWrite) + bytesAlloc)) UxOpSocketWrite;
+        op->bytesAlloc      = bytesAlloc;
+        op->write.buffer    = (uint8_t *) (op + 1);
+    }
+
+    op->notify                  = false;
+    op->queueTimeMs             = TimeGetMs();
+    op->bytesSent               = 0;
+    op->write.param             = nil;
+    op->write.asyncId           = 0;
+    op->write.bytes             = bytes;
+    op->write.bytesProcessed    = bytes;
+    memcpy(op->write.buffer, data, bytes);
+    sock->writeList.push_back(op);
+
+    PerfAddCounter(kAsyncPerfSocketBytesWaitQueued, bytes);
+    return op;
+}
+
+//===========================================================================
+// must be called inside sock->critsect
+// Hands as many queued buffers as possible to the kernel in one call. Write
+// operations which requested notification are moved onto completeList so
+// the caller can notify the application after leaving the critical section.
+static bool SocketFlushWrites (
+    UxSock *        sock,
+    UxWriteList *   completeList
+) {
+    for (;;) {
+        iovec iov[kMaxWriteIov];
+        unsigned count = 0;
+        for (UxOpSocketWrite * op : sock->writeList) {
+            if (count == kMaxWriteIov)
+                break;
+            iov[count].iov_base = op->write.buffer + op->bytesSent;
+            iov[count].iov_len  = op->write.bytes - op->bytesSent;
+            ++count;
+        }
+        if (!count)
+            break;
+
+        msghdr msg = {};
+        msg.msg_iov     = iov;
+        msg.msg_iovlen  = count;
+        ssize_t bytesSent = sendmsg(sock->fd, &msg, MSG_NOSIGNAL);
+        if (bytesSent < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        // retire buffers which have been completely sent
+        while (bytesSent) {
+            UxOpSocketWrite * op = sock->writeList.front();
+            unsigned bytes = std::min<unsigned>(bytesSent, op->write.bytes - op->bytesSent);
+            op->bytesSent += bytes;
+            bytesSent -= bytes;
+            PerfSubCounter(kAsyncPerfSocketBytesWaitQueued, bytes);
+            if (op->bytesSent < op->write.bytes)
+                break;
+
+            sock->writeList.pop_front();
+            if (op->notify)
+                completeList->push_back(op);
+            else
+                FreeWrite(op);
+        }
+    }
+
+    // all queued data has been sent; complete a pending soft close
+    if (sock->closeTimeMs)
+        shutdown(sock->fd, SHUT_WR);
+    return true;
+}
+
+//===========================================================================
+// must be called inside sock->critsect
+// Hands the head of the write queue to io_uring. Data coalesced into the
+// same buffer while the write is in flight goes out with the next one.
+static void SocketStartUringWrite (UxSock * sock) {
+    ASSERT(!sock->writeList.empty());
+    UxOpSocketWrite * op = sock->writeList.front();
+    ASSERT(sock->fd != -1);
+
+    IUxUringQueueWrite(
+        sock->fd,
+        SocketKey(sock),
+        op->write.buffer + op->bytesSent,
+        op->write.bytes - op->bytesSent,
+        op->bufIndex
+    );
+    sock->sendInFlight = true;
+}
+
+//===========================================================================
+// The calling thread must own the socket (sock->dispatching is set)
+static void SocketDispatch (UxSock * sock, uint32_t events) {
+    for (;;) {
+        bool alive = true;
+
+        // with io_uring, writes complete through IUxSocketCompleteWrite
+        if ((events & EPOLLOUT) && !IUxUringActive()) {
+            UxWriteList completeList;
+            {
+                hsLockGuard(sock->critsect);
+                alive = !sock->aborted && SocketFlushWrites(sock, &completeList);
+            }
+
+            // callback notification procedure if requested
+            for (UxOpSocketWrite * op : completeList) {
+                if (alive && sock->notifyProc) {
+                    if (!sock->notifyProc((AsyncSocket) sock, kNotifySocketWrite, &op->write, &sock->userState))
+                        UxSocketDisconnect((AsyncSocket) sock, false);
+                }
+                FreeWrite(op);
+            }
+        }
+
+        if (alive && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+            alive = SocketRead(sock);
+
+        {
+            hsLockGuard(sock->critsect);
+            if (alive && !sock->aborted) {
+                // pick up anything that arrived on other workers meanwhile
+                events = sock->pendingEvents;
+                sock->pendingEvents = 0;
+                if (events)
+                    continue;
+
+                sock->dispatching = false;
+                return;
+            }
+        }
+
+        SocketClose(sock);
+        return;
+    }
+}
+
+//===========================================================================
+static UxSock * SocketInitCommon (int fd) {
+    // set socket buffer sizes
+    int result = setsockopt(
+        fd,
+        SOL_SOCKET,
+        SO_SNDBUF,
+        &kTcpSndBufSize,
+        sizeof(kTcpSndBufSize)
+    );
+    if (result)
+        LogMsg(kLogError, "setsockopt(send) failed (set send buffer size)");
+
+    result = setsockopt(
+        fd,
+        SOL_SOCKET,
+        SO_RCVBUF,
+        &kTcpRcvBufSize,
+        sizeof(kTcpRcvBufSize)
+    );
+    if (result)
+        LogMsg(kLogError, "setsockopt(recv) failed (set recv buffer size)");
+
+    // allocate a new socket; the creating thread owns it until it has
+    // been handed to the application
+    UxSock * sock       = new UxSock;
+    sock->fd            = fd;
+    sock->initTimeMs    = TimeGetMs();
+    sock->dispatching   = true;
+
+    return sock;
+}
+
+//===========================================================================
+static bool SocketInitConnect (
+    UxSock * const          sock,
+    UxOpConnAttempt const & op
+) {
+    bool notified = false;
+    bool success = false;
+    for (;;) {
+        // attach to the reactor
+        if (!IUxRegister(sock->fd, SocketKey(sock), kSocketEvents))
+            break;
+
+        // send initial data
+        if (op.sendBytes && !UxSocketSend((AsyncSocket) sock, op.sendData, op.sendBytes))
+            break;
+
+        // Determine connType
+        if (op.sendBytes) {
+            sock->connType = op.sendData[0];
+            if (!IS_TEXT_CONNTYPE(sock->connType)) {
+                if (op.sendBytes < sizeof(AsyncSocketConnectPacket))
+                    break;
+
+                if (sock->connType != ((const AsyncSocketConnectPacket *) op.sendData)->connType)
+                    break;
+            }
+        }
+
+        // perform callback notification
+        notified = true;
+        AsyncNotifySocketConnect notify;
+        SocketGetAddresses(sock, &notify.localAddr, &notify.remoteAddr);
+        notify.param        = op.param;
+        notify.asyncId      = 0;
+        notify.connType     = sock->connType;
+        sock->notifyProc    = op.notifyProc;
+        if (!sock->notifyProc((AsyncSocket) sock, kNotifySocketConnectSuccess, &notify, &sock->userState))
+            break;
+
+        success = true;
+        break;
+    }
+
+    // start reading from the socket; anything which became ready while the
+    // socket was being set up was only reported once, so check everything
+    if (success)
+        SocketDispatch(sock, EPOLLIN | EPOLLOUT);
+    else
+        SocketClose(sock);
+    return notified;
+}
+
+//===========================================================================
+static void SocketInitListen (
+    UxSock * const          sock,
+    const plNetAddress&     listenAddr,
+    FAsyncNotifySocketProc  notifyProc
+) {
+    bool success = false;
+    for (;;) {
+        // attach to the reactor
+        if (!IUxRegister(sock->fd, SocketKey(sock), kSocketEvents))
+            break;
+
+        sock->addr = listenAddr;
+
+        if (notifyProc) {
+            // perform kNotifySocketListenSuccess
+            AsyncNotifySocketListen notify;
+            SocketGetAddresses(sock, &notify.localAddr, &notify.remoteAddr);
+            notify.param            = nil;
+            notify.asyncId          = 0;
+            notify.connType         = 0;
+            notify.buildId          = 0;
+            notify.buildType        = 0;
+            notify.branchId         = 0;
+            notify.productId        = kNilUuid;
+            notify.addr             = listenAddr;
+            notify.buffer           = sock->buffer;
+            notify.bytes            = 0;
+            notify.bytesProcessed   = 0;
+            sock->notifyProc        = notifyProc;
+            if (!sock->notifyProc((AsyncSocket) sock, kNotifySocketListenSuccess, &notify, &sock->userState))
+                break;
+        }
+
+        success = true;
+        break;
+    }
+
+    if (success)
+        SocketDispatch(sock, EPOLLIN | EPOLLOUT);
+    else
+        SocketClose(sock);
+}
+
+//===========================================================================
+static int ListenSocket (plNetAddress* listenAddr) {
+    // create a new socket to listen
+    int s;
+    if (-1 == (s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0))) {
+        LogMsg(kLogError, "socket create failed");
+        return -1;
+    }
+
+    do {
+        uint32_t node = listenAddr->GetHost();
+        uint16_t port = listenAddr->GetPort();
+
+        // bind socket to port
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family         = AF_INET;
+        addr.sin_port           = htons(port);
+        addr.sin_addr.s_addr    = node;
+        if (bind(s, (sockaddr *) &addr, sizeof(addr))) {
+            ST::string str = listenAddr->AsString();
+            LogMsg(kLogError, "bind to addr {} failed (err {})", str, errno);
+            break;
+        }
+
+        // get portNumber if unknown
+        if (!port) {
+            socklen_t addrLen = sizeof(addr);
+            if (getsockname(s, (sockaddr *) &addr, &addrLen)) {
+                LogMsg(kLogError, "getsockname failed");
+                break;
+            }
+
+            if (0 == (port = ntohs(addr.sin_port))) {
+                LogMsg(kLogError, "bad listen port");
+                break;
+            }
+        }
+
+        if (listen(s, kListenBacklog)) {
+            LogMsg(kLogError, "socket listen failed");
+            break;
+        }
+
+        // success!
+        listenAddr->SetPort(port);
+        return s;
+    } while (false);
+
+    // failure!
+    close(s);
+    listenAddr->SetPort(0);
+    return -1;
+}
+
+//===========================================================================
+static void ListenerAccept (UxListener * listener) {
+    std::vector<int> sockets;
+    plNetAddress addr;
+    FAsyncNotifySocketProc notifyProc;
+    {
+        hsLockGuard(s_listenCrit);
+
+        // the listener may have been closed after the event was queued
+        if (listener->fd == -1)
+            return;
+
+        addr        = listener->addr;
+        notifyProc  = listener->notifyProc;
+        for (;;) {
+            int s = accept4(listener->fd, nil, nil, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (s != -1)
+                sockets.push_back(s);
+            else if (errno != EINTR && errno != ECONNABORTED)
+                break;
+        }
+    }
+    PerfAddCounter(kAsyncPerfSocketConnAttemptsInTotal, (unsigned) sockets.size());
+
+    for (int s : sockets)
+        SocketInitListen(SocketInitCommon(s), addr, notifyProc);
+}
+
+//===========================================================================
+static int ConnectSocket (unsigned localPort, const plNetAddress& addr) {
+    int s;
+    if (-1 == (s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0))) {
+        LogMsg(kLogError, "socket create failed");
+        return -1;
+    }
+
+    do {
+        // bind socket to port
+        if (localPort) {
+            sockaddr_in localAddr;
+            memset(&localAddr, 0, sizeof(localAddr));
+            localAddr.sin_family        = AF_INET;
+            localAddr.sin_port          = htons((uint16_t) localPort);
+            localAddr.sin_addr.s_addr   = INADDR_ANY;
+            if (bind(s, (sockaddr *) &localAddr, sizeof(localAddr))) {
+                LogMsg(kLogError, "bind(port {}) failed ({})", localPort, errno);
+                break;
+            }
+        }
+
+        if (connect(s, (const sockaddr *) &addr.GetAddressInfo(), sizeof(AddressType))) {
+            if (errno != EINPROGRESS) {
+                LogMsg(kLogError, "socket connect failed ({})", errno);
+                break;
+            }
+        }
+
+        // success!
+        return s;
+    } while (false);
+
+    // failure!
+    close(s);
+    return -1;
+}
+
+//===========================================================================
+// The attempt must already have been removed from s_connectList
+static void SocketCompleteConnect (UxOpConnAttempt * op) {
+    // connect socket to local end
+    bool notified = false;
+    if (op->fd != -1) {
+        IUxUnregister(op->fd);
+
+        int error = 0;
+        socklen_t errorLen = sizeof(error);
+        if (!op->canceled
+        &&  !getsockopt(op->fd, SOL_SOCKET, SO_ERROR, &error, &errorLen)
+        &&  !error
+        ) {
+            notified = SocketInitConnect(SocketInitCommon(op->fd), *op);
+        }
+        else {
+            close(op->fd);
+        }
+        op->fd = -1;
+    }
+
+    // handle connection failure
+    if (!notified) {
+        AsyncNotifySocketConnect failed;
+        failed.param      = op->param;
+        failed.connType   = op->sendData[0];
+        failed.remoteAddr = op->remoteAddr;
+        failed.localAddr.Clear();
+        op->notifyProc(nil, kNotifySocketConnectFailed, &failed, nil);
+    }
+
+    op->~UxOpConnAttempt();
+    free(op);
+
+    PerfSubCounter(kAsyncPerfSocketConnAttemptsOutCurr, 1);
+}
+
+
+/****************************************************************************
+*
+*   Module functions
+*
+***/
+
+//===========================================================================
+void IUxSocketDestroy () {
+    // The worker threads are gone, so anything still waiting to connect
+    // will never complete; fail those attempts now
+    std::vector<UxOpConnAttempt *> failList;
+    {
+        hsLockGuard(s_connectCrit);
+        failList.swap(s_connectList);
+    }
+    for (UxOpConnAttempt * op : failList) {
+        op->canceled = true;
+        SocketCompleteConnect(op);
+    }
+
+    hsLockGuard(s_listenCrit);
+    ASSERT(s_listenList.empty());
+}
+
+//===========================================================================
+void IUxSocketMaintenance () {
+    unsigned currTimeMs = TimeGetMs();
+
+    // complete canceled, failed and timed out connection attempts
+    std::vector<UxOpConnAttempt *> completeList;
+    {
+        hsLockGuard(s_connectCrit);
+        auto keep = s_connectList.begin();
+        for (UxOpConnAttempt * op : s_connectList) {
+            // if the socket has taken too long to connect then abort attempt
+            if (op->fd != -1 && (int) (currTimeMs - op->failTimeMs) > 0)
+                op->canceled = true;
+
+            if (op->canceled || op->fd == -1)
+                completeList.push_back(op);
+            else
+                *keep++ = op;
+        }
+        s_connectList.erase(keep, s_connectList.end());
+    }
+    for (UxOpConnAttempt * op : completeList)
+        SocketCompleteConnect(op);
+
+    // abortive close sockets whose soft close has timed out
+    hsLockGuard(s_socketCrit);
+    while (!s_closeList.empty()) {
+        UxSock * sock = s_closeList.front();
+        if (0 < (signed) (sock->closeTimeMs - currTimeMs))
+            break;
+
+        s_closeList.pop_front();
+        hsLockGuard(sock->critsect);
+        sock->closeLinked = false;
+        SocketAbort(sock);
+    }
+}
+
+//===========================================================================
+bool IUxSocketCanDelete (UxObject * obj) {
+    if (obj->ioType != kUxSocket)
+        return true;
+
+    UxSock * sock = (UxSock *) obj;
+    hsLockGuard(sock->critsect);
+    return !sock->sendInFlight;
+}
+
+//===========================================================================
+void IUxSocketDeleteObject (UxObject * obj) {
+    switch (obj->ioType) {
+        case kUxSocket:
+            delete (UxSock *) obj;
+        break;
+
+        case kUxListener:
+            delete (UxListener *) obj;
+        break;
+
+        DEFAULT_FATAL(ioType);
+    }
+}
+
+//===========================================================================
+void IUxSocketDispatchEvent (UxObject * obj, uint32_t events) {
+    if (obj->ioType == kUxListener) {
+        ListenerAccept((UxListener *) obj);
+        return;
+    }
+
+    ASSERT(obj->ioType == kUxSocket);
+    UxSock * sock = (UxSock *) obj;
+    {
+        hsLockGuard(sock->critsect);
+
+        // the socket may have been closed after the event was queued
+        if (sock->fd == -1)
+            return;
+
+        // another worker is already processing this socket; let it pick
+        // these events up when it is done
+        if (sock->dispatching) {
+            sock->pendingEvents |= events;
+            return;
+        }
+        sock->dispatching = true;
+    }
+
+    SocketDispatch(sock, events);
+}
+
+//===========================================================================
+void IUxSocketCompleteWrite (UxObject * obj, int result) {
+    ASSERT(obj->ioType == kUxSocket);
+    UxSock * sock = (UxSock *) obj;
+
+    UxWriteList completeList;
+    int closeFd = -1;
+    {
+        hsLockGuard(sock->critsect);
+        ASSERT(sock->sendInFlight);
+        sock->sendInFlight = false;
+
+        if (result < 0) {
+            // an error occurred -- destroy connection
+            SocketAbort(sock);
+        }
+        else {
+            unsigned bytesSent = (unsigned) result;
+            while (bytesSent) {
+                UxOpSocketWrite * op = sock->writeList.front();
+                unsigned bytes = std::min(bytesSent, op->write.bytes - op->bytesSent);
+                op->bytesSent += bytes;
+                bytesSent -= bytes;
+                PerfSubCounter(kAsyncPerfSocketBytesWaitQueued, bytes);
+                if (op->bytesSent < op->write.bytes)
+                    break;
+
+                sock->writeList.pop_front();
+                if (op->notify)
+                    completeList.push_back(op);
+                else
+                    FreeWrite(op);
+            }
+        }
+
+        if (sock->fd == -1) {
+            // the socket was closed while the write was in flight
+            FreeQueuedWrites(sock);
+            closeFd = sock->deferredCloseFd;
+            sock->deferredCloseFd = -1;
+        }
+        else if (sock->aborted) {
+            // the reactor frees the queue when it closes the socket
+        }
+        else if (!sock->writeList.empty()) {
+            SocketStartUringWrite(sock);
+        }
+        else if (sock->closeTimeMs) {
+            // all queued data has been sent; complete a pending soft close
+            shutdown(sock->fd, SHUT_WR);
+        }
+    }
+
+    if (closeFd != -1)
+        close(closeFd);
+
+    // callback notification procedure if requested
+    for (UxOpSocketWrite * op : completeList) {
+        if (closeFd == -1 && sock->notifyProc) {
+            if (!sock->notifyProc((AsyncSocket) sock, kNotifySocketWrite, &op->write, &sock->userState))
+                UxSocketDisconnect((AsyncSocket) sock, false);
+        }
+        FreeWrite(op);
+    }
+}
+
+//===========================================================================
+// Whatever woke us (writable, error or hangup), SO_ERROR has the outcome
+void IUxSocketDispatchConnect (uint64_t cancelKey, uint32_t /* events */) {
+    UxOpConnAttempt * op = nil;
+    {
+        hsLockGuard(s_connectCrit);
+        for (auto it = s_connectList.begin(); it != s_connectList.end(); ++it) {
+            if ((uint64_t) (uintptr_t) (*it)->cancelId == cancelKey) {
+                op = *it;
+                s_connectList.erase(it);
+                break;
+            }
+        }
+    }
+
+    // the attempt may already have been canceled or timed out
+    if (op)
+        SocketCompleteConnect(op);
+}
+
+
+/****************************************************************************
+*
+*   Exported functions
+*
+***/
+
+//===========================================================================
+unsigned UxSocketStartListening (
+    const plNetAddress&     listenAddr,
+    FAsyncNotifySocketProc  notifyProc
+) {
+    plNetAddress addr = listenAddr;
+    hsLockGuard(s_listenCrit);
+    for (;;) {
+        // if the port is already open then just increment the reference count
+        if (ListenPortIncrement(addr, notifyProc, 1))
+            break;
+
+        int s;
+        if (-1 == (s = ListenSocket(&addr)))
+            break;
+
+        // create a new listener record
+        UxListener * listener   = new UxListener;
+        listener->fd            = s;
+        listener->addr          = addr;
+        listener->notifyProc    = notifyProc;
+        listener->listenCount   = 1;
+        s_listenList.push_back(listener);
+
+        if (!IUxRegister(s, SocketKey(listener), EPOLLIN | EPOLLET)) {
+            ListenPortIncrement(addr, notifyProc, -1);
+            addr.SetPort(0);
+        }
+        break;
+    }
+
+    return addr.GetPort();
+}
+
+//===========================================================================
+void UxSocketStopListening (
+    const plNetAddress&     listenAddr,
+    FAsyncNotifySocketProc  notifyProc
+) {
+    hsLockGuard(s_listenCrit);
+    ListenPortIncrement(listenAddr, notifyProc, -1);
+}
+
+//===========================================================================
+void UxSocketConnect (
+    AsyncCancelId *         cancelId,
+    const plNetAddress&     netAddr,
+    FAsyncNotifySocketProc  notifyProc,
+    void *                  param,
+    const void *            sendData,
+    unsigned                sendBytes,
+    unsigned                connectMs,
+    unsigned                localPort
+) {
+    ASSERT(notifyProc);
+
+    // create async connection record with enough extra bytes for sendData
+    UxOpConnAttempt * op = 
+     new(malloc(sizeof(UxOpConnAttempt) - sizeof(op->sendData) + std::max(sendBytes, 1u))) UxOpConnAttempt;
+
+    op->canceled                = false;
+    op->localPort               = localPort;
+    op->remoteAddr              = netAddr;
+    op->notifyProc              = notifyProc;
+    op->param                   = param;
+    op->fd                      = ConnectSocket(localPort, netAddr);
+    op->failTimeMs              = TimeGetMs() + (connectMs ? connectMs : kConnectTimeMs);
+    if (0 != (op->sendBytes = sendBytes))
+        memcpy(op->sendData, sendData, sendBytes);
+    else
+        op->sendData[0] = kConnTypeNil;
+
+    PerfAddCounter(kAsyncPerfSocketConnAttemptsOutCurr, 1);
+    PerfAddCounter(kAsyncPerfSocketConnAttemptsOutTotal, 1);
+
+    bool failed;
+    {
+        hsLockGuard(s_connectCrit);
+
+        // get cancel id; we can avoid checking for zero by always using an odd number
+        ASSERT(s_nextConnectCancelId & 1);
+        s_nextConnectCancelId += 2;
+
+        *cancelId = op->cancelId = (AsyncCancelId) (uintptr_t) s_nextConnectCancelId;
+        s_connectList.push_back(op);
+
+        // the attempt must be on s_connectList before the reactor can report it
+        if (op->fd != -1 && !IUxRegister(op->fd, (uint64_t) (uintptr_t) op->cancelId, EPOLLOUT | EPOLLET)) {
+            close(op->fd);
+            op->fd = -1;
+        }
+        failed = op->fd == -1;
+    }
+
+    // failed attempts are completed by the reactor so the application
+    // is always notified asynchronously
+    if (failed)
+        IUxWakeup();
+}
+
+//===========================================================================
+// due to the asynchronous nature sockets, the connect may occur
+// before the cancel can complete... you have been warned
+void UxSocketConnectCancel (
+    FAsyncNotifySocketProc notifyProc,
+    AsyncCancelId          cancelId        // nil = cancel all with specified notifyProc
+) {
+    {
+        hsLockGuard(s_connectCrit);
+        for (UxOpConnAttempt * op : s_connectList) {
+            if (cancelId && (op->cancelId != cancelId))
+                continue;
+            if (op->notifyProc != notifyProc)
+                continue;
+            op->canceled = true;
+        }
+    }
+    IUxWakeup();
+}
+
+//===========================================================================
+// This function must ONLY be called after receiving a NOTIFY_DISCONNECT message
+// for a socket. After a NOTIFY_DISCONNECT, the socket will fail all I/O initiated
+// against it, but will otherwise continue to exist. The memory for the socket will
+// only be freed when UxSocketDelete is called.
+void UxSocketDelete (AsyncSocket conn) {
+    UxSock * sock = (UxSock *) conn;
+    if (sock->ioType != kUxSocket) {
+        LogMsg(kLogError, "UxSocketDelete {} {#x}", sock->ioType, (uintptr_t)sock->notifyProc);
+        return;
+    }
+
+    IUxRetireObject(sock);
+}
+
+//===========================================================================
+void UxSocketDisconnect (AsyncSocket conn, bool hardClose) {
+    UxSock * sock = (UxSock *) conn;
+    ASSERT(sock->ioType == kUxSocket);
+
+    if (hardClose) {
+        hsLockGuard(sock->critsect);
+        SocketAbort(sock);
+        return;
+    }
+
+    hsLockGuard(s_socketCrit);
+    hsLockGuard(sock->critsect);
+    if (sock->fd == -1 || sock->closeTimeMs)
+        return;
+
+    // The socket hasn't been closed previously; mark the socket closed with
+    // a time value that indicates its ordering in s_closeList. The send side
+    // is shut down once any queued data has made it to the kernel.
+    sock->closeTimeMs = (TimeGetMs() + kCloseTimeoutMs) | 1;
+    if (sock->writeList.empty())
+        shutdown(sock->fd, SHUT_WR);
+    sock->closeLink = s_closeList.insert(s_closeList.end(), sock);
+    sock->closeLinked = true;
+}
+
+//===========================================================================
+bool UxSocketSend (
+    AsyncSocket     conn,
+    const void *    data,
+    unsigned        bytes
+) {
+    UxSock * sock = (UxSock *) conn;
+    ASSERT(sock);
+    ASSERT(data);
+    ASSERT(bytes);
+    ASSERT(sock->ioType == kUxSocket);
+
+    hsLockGuard(sock->critsect);
+
+    // Is the socket closing?
+    if (sock->closeTimeMs)
+        return false;
+
+    // with io_uring all data is staged in registered buffers and submitted
+    // by the reactor in batches, coalescing with any write in flight
+    if (IUxUringActive()) {
+        if (SocketQueueWrite(sock, (const uint8_t *) data, bytes) && !sock->sendInFlight)
+            SocketStartUringWrite(sock);
+        return true;
+    }
+
+    // if there isn't any data queued, send this batch immediately
+    if (sock->writeList.empty()) {
+        for (;;) {
+            ssize_t bytesSent = send(sock->fd, data, bytes, MSG_NOSIGNAL);
+            if (bytesSent >= 0) {
+                // if we sent all the data then exit
+                if ((unsigned) bytesSent >= bytes)
+                    return true;
+
+                // subtract the data we already sent and try again; the
+                // reactor is only told about writability once the kernel
+                // has pushed back with EAGAIN
+                data = (const uint8_t *) data + bytesSent;
+                bytes -= (unsigned) bytesSent;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            else if (errno != EINTR) {
+                // an error occurred -- destroy connection
+                SocketAbort(sock);
+                return false;
+            }
+        }
+    }
+
+    // queue the rest; it is coalesced with anything else already waiting
+    // and sent by the reactor when the socket becomes writable again
+    SocketQueueWrite(sock, (const uint8_t *) data, bytes);
+    return true;
+}
+
+//===========================================================================
+bool UxSocketWrite (
+    AsyncSocket     conn,
+    const void *    buffer,
+    unsigned        bytes,
+    void *          param
+) {
+    UxSock * sock = (UxSock *) conn;
+    ASSERT(buffer);
+    ASSERT(bytes);
+    ASSERT(sock->ioType == kUxSocket);
+
+    hsLockGuard(sock->critsect);
+
+    // Is the socket closing?
+    if (sock->closeTimeMs)
+        return false;
+
+    // the buffer is owned by the caller and written directly from there
+    UxOpSocketWrite * op        = new(malloc(sizeof(UxOpSocketWrite))) UxOpSocketWrite;
+    op->notify                  = true;
+    op->queueTimeMs             = TimeGetMs();
+    op->bytesAlloc              = bytes;
+    op->bytesSent               = 0;
+    op->write.param             = param;
+    op->write.asyncId           = 0;
+    op->write.buffer            = (uint8_t *) buffer;
+    op->write.bytes             = bytes;
+    op->write.bytesProcessed    = bytes;
+    PerfAddCounter(kAsyncPerfSocketBytesWaitQueued, bytes);
+
+    bool wasIdle = sock->writeList.empty();
+    sock->writeList.push_back(op);
+
+    if (IUxUringActive()) {
+        if (!sock->sendInFlight)
+            SocketStartUringWrite(sock);
+    }
+    else if (wasIdle) {
+        // the completion must be reported from the reactor, so have it
+        // re-check writability rather than sending from this thread
+        IUxRearm(sock->fd, SocketKey(sock), kSocketEvents);
+    }
+
+    return true;
+}
+
+//===========================================================================
+// -- use only for server<->client connections, not server<->server!
+// -- Note that Nagling is enabled by default
+void UxSocketEnableNagling (AsyncSocket conn, bool enable) {
+    UxSock * sock = (UxSock *) conn;
+    ASSERT(sock->ioType == kUxSocket);
+    
+    // must enter critical section in case someone attempts to close socket from another thread
+    hsLockGuard(sock->critsect);
+    if (sock->fd != -1) {
+        int noDelay = !enable;
+        const int result = setsockopt(
+            sock->fd,
+            IPPROTO_TCP,
+            TCP_NODELAY,
+            &noDelay,
+            sizeof(noDelay)
+        );
+        if (result)
+            LogMsg(kLogError, "setsockopt failed (nagling)");
+    }
+}
+
+//===========================================================================
+void UxSocketSetNotifyProc (
+    AsyncSocket            conn,
+    FAsyncNotifySocketProc notifyProc
+) {
+    UxSock * sock = (UxSock *) conn;
+    ASSERT(sock->ioType == kUxSocket);
+    sock->notifyProc = notifyProc;
+}
+
+//===========================================================================
+void UxSocketSetBacklogAlloc (AsyncSocket conn, unsigned bufferSize) {
+    UxSock * sock = (UxSock *) conn;
+    ASSERT(sock->ioType == kUxSocket);
+    sock->backlogAlloc = bufferSize;
+}
+
+} using namespace Ux;
+
+#endif // HS_BUILD_FOR_LINUX
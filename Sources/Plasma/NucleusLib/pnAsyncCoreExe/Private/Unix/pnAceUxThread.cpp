@@ -0,0 +1,251 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+/*****************************************************************************
+*
+*   $/Plasma20/Sources/Plasma/NucleusLib/pnAsyncCoreExe/Private/Unix/pnAceUxThread.cpp
+*   
+***/
+
+#include "../../Pch.h"
+
+#ifdef HS_BUILD_FOR_LINUX
+
+#include "hsRefCnt.h"
+
+#include <deque>
+
+
+/*****************************************************************************
+*
+*   Private
+*
+***/
+
+struct AsyncThreadTaskList : hsRefCnt {
+    ENetError error;
+    AsyncThreadTaskList ();
+    ~AsyncThreadTaskList ();
+};
+
+struct ThreadTask {
+    AsyncThreadTaskList *   taskList;
+    FAsyncThreadTask        callback;
+    void *                  param;
+    wchar_t                 debugStr[256];
+};
+
+// Stands in for the completion port the Win32 version queues tasks to
+static std::mutex               s_taskCrit;
+static std::condition_variable  s_taskSignal;
+static std::deque<ThreadTask *> s_taskQueue;
+static bool                     s_taskInitialized;
+
+
+/*****************************************************************************
+*
+*   AsyncThreadTaskList
+*
+***/
+
+//===========================================================================
+AsyncThreadTaskList::AsyncThreadTaskList ()
+:   hsRefCnt(0), error(kNetSuccess)
+{
+    PerfAddCounter(kAsyncPerfThreadTaskListCount, 1);
+}
+
+//============================================================================
+AsyncThreadTaskList::~AsyncThreadTaskList () {
+    PerfSubCounter(kAsyncPerfThreadTaskListCount, 1);
+}
+
+
+/****************************************************************************
+*
+*   ThreadTaskProc
+*
+***/
+
+//===========================================================================
+static unsigned THREADCALL ThreadTaskProc (AsyncThread * /* thread */) {
+    PerfAddCounter(kAsyncPerfThreadTaskThreadsActive, 1);
+
+    for (;;) {
+        // Get the next work item, unless there are more threads than desired
+        ThreadTask * task;
+        {
+            std::unique_lock<std::mutex> lock(s_taskCrit);
+            PerfSubCounter(kAsyncPerfThreadTaskThreadsActive, 1);
+            s_taskSignal.wait(lock, [] {
+                return !s_taskQueue.empty()
+                    || AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsRunning) > AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsDesired);
+            });
+            PerfAddCounter(kAsyncPerfThreadTaskThreadsActive, 1);
+
+            if (AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsRunning) > AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsDesired)) {
+                PerfSubCounter(kAsyncPerfThreadTaskThreadsRunning, 1);
+                break;
+            }
+
+            task = s_taskQueue.front();
+            s_taskQueue.pop_front();
+        }
+
+        task->callback(task->param, task->taskList->error);
+
+        task->taskList->UnRef("Task");
+        delete task;
+    }
+    PerfSubCounter(kAsyncPerfThreadTaskThreadsActive, 1);
+
+    return 0;
+}
+
+
+/*****************************************************************************
+*
+*   Exports
+*
+***/
+
+//============================================================================
+void AsyncThreadTaskInitialize (unsigned threads) {
+    {
+        std::lock_guard<std::mutex> lock(s_taskCrit);
+        s_taskInitialized = true;
+    }
+
+    // Create threads
+    AsyncThreadTaskSetThreadCount(threads);
+}
+
+//============================================================================
+void AsyncThreadTaskDestroy () {
+    ASSERT(!AsyncPerfGetCounter(kAsyncPerfThreadTaskListCount));
+
+    {
+        std::lock_guard<std::mutex> lock(s_taskCrit);
+        if (!s_taskInitialized)
+            return;
+        s_taskInitialized = false;
+
+        PerfSetCounter(kAsyncPerfThreadTaskThreadsDesired, 0);
+        s_taskSignal.notify_all();
+    }
+
+    // Wait until all threads have exited
+    while (AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsActive))
+        AsyncSleep(10);
+    while (AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsRunning))
+        AsyncSleep(10);
+}
+
+//===========================================================================
+unsigned AsyncThreadTaskGetThreadCount () {
+    return AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsDesired);
+}
+
+//===========================================================================
+void AsyncThreadTaskSetThreadCount (unsigned threads) {
+    ASSERT(threads >= kThreadTaskMinThreads);
+    ASSERT(threads <= kThreadTaskMaxThreads);
+
+    std::lock_guard<std::mutex> lock(s_taskCrit);
+    PerfSetCounter(kAsyncPerfThreadTaskThreadsDesired, (long) threads);
+
+    // start any threads we're short; surplus threads see the lower
+    // count when they're woken and exit
+    while (AsyncPerfGetCounter(kAsyncPerfThreadTaskThreadsRunning) < (long) threads) {
+        PerfAddCounter(kAsyncPerfThreadTaskThreadsRunning, 1);
+        AsyncThreadCreate(ThreadTaskProc, nil, L"AsyncThreadTaskList");
+    }
+    s_taskSignal.notify_all();
+}
+
+//===========================================================================
+AsyncThreadTaskList * AsyncThreadTaskListCreate () {
+    ASSERT(s_taskInitialized);
+    AsyncThreadTaskList * taskList = new AsyncThreadTaskList;
+    taskList->Ref("TaskList");
+    return taskList;
+}
+
+//===========================================================================
+void AsyncThreadTaskListDestroy (
+    AsyncThreadTaskList *   taskList,
+    ENetError               error
+) {
+    ASSERT(taskList);
+    ASSERT(error);
+    ASSERT(!taskList->error);
+
+    taskList->error = error;
+    taskList->UnRef("TaskList");
+}
+
+//===========================================================================
+void AsyncThreadTaskAdd (
+    AsyncThreadTaskList *   taskList,
+    FAsyncThreadTask        callback,
+    void *                  param,
+    const wchar_t           debugStr[],
+    EThreadTaskPriority     priority /* = kThreadTaskPriorityNormal */
+) {
+    ASSERT(s_taskInitialized);
+    ASSERT(taskList);
+    ASSERT(callback);
+    ASSERT(priority == kThreadTaskPriorityNormal);
+
+    // Allocate a new task record
+    ThreadTask * task   = new ThreadTask;
+    task->taskList      = taskList;
+    task->callback      = callback;
+    task->param         = param;
+    StrCopy(task->debugStr, debugStr, std::size(task->debugStr));
+    taskList->Ref("Task");
+
+    std::lock_guard<std::mutex> lock(s_taskCrit);
+    s_taskQueue.push_back(task);
+    s_taskSignal.notify_one();
+}
+
+#endif // HS_BUILD_FOR_LINUX
@@ -0,0 +1,466 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+/*****************************************************************************
+*
+*   $/Plasma20/Sources/Plasma/NucleusLib/pnAsyncCoreExe/Private/Unix/pnAceUxUring.cpp
+*   
+***/
+
+#include "../../Pch.h"
+
+#ifdef HS_BUILD_FOR_LINUX
+
+#include "pnAceUxInt.h"
+
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+
+namespace Ux {
+
+/****************************************************************************
+*
+*   Private
+*
+***/
+
+const unsigned kRingEntries         = 256;
+
+// Registered buffers hold several packets' worth of coalesced sends
+const unsigned kRingBufferBytes     = 8 * kAsyncSocketBufferSize;
+const unsigned kRingBufferCount     = 256;
+
+// completions reaped per pass before they are dispatched
+const unsigned kMaxCompletions      = 64;
+
+// A write which didn't fit in the submission queue
+struct UxRingWrite {
+    int                 fd;
+    uint64_t            key;
+    const uint8_t *     data;
+    unsigned            bytes;
+    int                 bufIndex;
+};
+
+struct UxRing {
+    int                 fd;
+    
+    uint8_t *           sqRing;
+    size_t              sqRingBytes;
+    unsigned *          sqHead;
+    unsigned *          sqTail;
+    unsigned            sqMask;
+    unsigned            sqEntries;
+    unsigned *          sqArray;
+    io_uring_sqe *      sqes;
+    size_t              sqesBytes;
+
+    uint8_t *           cqRing;
+    size_t              cqRingBytes;
+    unsigned *          cqHead;
+    unsigned *          cqTail;
+    unsigned            cqMask;
+    io_uring_cqe *      cqes;
+};
+
+static bool                     s_active;
+static UxRing                   s_ring;
+static std::mutex               s_ringCrit;
+static unsigned                 s_sqPending;
+static std::vector<UxRingWrite> s_sqOverflow;
+
+static uint8_t *                s_buffers;
+static std::mutex               s_bufferCrit;
+static int                      s_freeBuffers[kRingBufferCount];
+static unsigned                 s_freeBufferCount;
+
+// Only reactor threads may call io_uring_enter. WRITE_FIXED has no
+// MSG_NOSIGNAL, so a write to a reset socket raises SIGPIPE in whichever
+// thread issued it, and only the reactor threads keep SIGPIPE blocked.
+static thread_local bool        s_reactorThread;
+
+
+//===========================================================================
+static int SysUringSetup (unsigned entries, io_uring_params * params) {
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+//===========================================================================
+static int SysUringEnter (int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return (int) syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nil, 0);
+}
+
+//===========================================================================
+static int SysUringRegister (int fd, unsigned opcode, const void * arg, unsigned nrArgs) {
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs);
+}
+
+//===========================================================================
+static bool RingSupportsOps () {
+    const size_t probeBytes = sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op);
+    io_uring_probe * probe = (io_uring_probe *) calloc(1, probeBytes);
+    bool result = false;
+    if (!SysUringRegister(s_ring.fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST)) {
+        result = probe->last_op >= IORING_OP_SEND
+            && (probe->ops[IORING_OP_WRITE_FIXED].flags & IO_URING_OP_SUPPORTED)
+            && (probe->ops[IORING_OP_SEND].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    return result;
+}
+
+//===========================================================================
+static bool RingMap (const io_uring_params & params) {
+    s_ring.sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    s_ring.cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        s_ring.sqRingBytes = std::max(s_ring.sqRingBytes, s_ring.cqRingBytes);
+        s_ring.cqRingBytes = s_ring.sqRingBytes;
+    }
+
+    void * sqRing = mmap(nil, s_ring.sqRingBytes, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, s_ring.fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+        return false;
+    s_ring.sqRing = (uint8_t *) sqRing;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        s_ring.cqRing = s_ring.sqRing;
+    }
+    else {
+        void * cqRing = mmap(nil, s_ring.cqRingBytes, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, s_ring.fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+            return false;
+        s_ring.cqRing = (uint8_t *) cqRing;
+    }
+
+    s_ring.sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    void * sqes = mmap(nil, s_ring.sqesBytes, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, s_ring.fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    s_ring.sqes = (io_uring_sqe *) sqes;
+
+    s_ring.sqHead       = (unsigned *) (s_ring.sqRing + params.sq_off.head);
+    s_ring.sqTail       = (unsigned *) (s_ring.sqRing + params.sq_off.tail);
+    s_ring.sqMask       = *(unsigned *) (s_ring.sqRing + params.sq_off.ring_mask);
+    s_ring.sqEntries    = *(unsigned *) (s_ring.sqRing + params.sq_off.ring_entries);
+    s_ring.sqArray      = (unsigned *) (s_ring.sqRing + params.sq_off.array);
+
+    s_ring.cqHead       = (unsigned *) (s_ring.cqRing + params.cq_off.head);
+    s_ring.cqTail       = (unsigned *) (s_ring.cqRing + params.cq_off.tail);
+    s_ring.cqMask       = *(unsigned *) (s_ring.cqRing + params.cq_off.ring_mask);
+    s_ring.cqes         = (io_uring_cqe *) (s_ring.cqRing + params.cq_off.cqes);
+    return true;
+}
+
+//===========================================================================
+static void RingUnmap () {
+    if (s_ring.sqes)
+        munmap(s_ring.sqes, s_ring.sqesBytes);
+    if (s_ring.cqRing && s_ring.cqRing != s_ring.sqRing)
+        munmap(s_ring.cqRing, s_ring.cqRingBytes);
+    if (s_ring.sqRing)
+        munmap(s_ring.sqRing, s_ring.sqRingBytes);
+    if (s_ring.fd != -1)
+        close(s_ring.fd);
+
+    memset(&s_ring, 0, sizeof(s_ring));
+    s_ring.fd = -1;
+}
+
+//===========================================================================
+static bool RegisterBuffers () {
+    const size_t bytes = (size_t) kRingBufferBytes * kRingBufferCount;
+    void * buffers = mmap(nil, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED)
+        return false;
+    s_buffers = (uint8_t *) buffers;
+
+    iovec iov[kRingBufferCount];
+    for (unsigned i = 0; i < kRingBufferCount; ++i) {
+        iov[i].iov_base = s_buffers + (size_t) i * kRingBufferBytes;
+        iov[i].iov_len  = kRingBufferBytes;
+    }
+
+    // registered buffers count against RLIMIT_MEMLOCK
+    if (SysUringRegister(s_ring.fd, IORING_REGISTER_BUFFERS, iov, kRingBufferCount)) {
+        LogMsg(kLogDebug, "io_uring buffer registration failed ({})", errno);
+        munmap(s_buffers, bytes);
+        s_buffers = nil;
+        return false;
+    }
+
+    s_freeBufferCount = kRingBufferCount;
+    for (unsigned i = 0; i < kRingBufferCount; ++i)
+        s_freeBuffers[i] = (int) (kRingBufferCount - 1 - i);
+    return true;
+}
+
+//===========================================================================
+// must be called inside s_ringCrit
+static bool RingQueueWrite (const UxRingWrite & write) {
+    unsigned tail = *s_ring.sqTail;
+    unsigned head = __atomic_load_n(s_ring.sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= s_ring.sqEntries)
+        return false;
+
+    unsigned index = tail & s_ring.sqMask;
+    io_uring_sqe * sqe = &s_ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd         = write.fd;
+    sqe->addr       = (uint64_t) (uintptr_t) write.data;
+    sqe->len        = write.bytes;
+    sqe->user_data  = write.key;
+    if (write.bufIndex >= 0) {
+        sqe->opcode     = IORING_OP_WRITE_FIXED;
+        sqe->buf_index  = (uint16_t) write.bufIndex;
+    }
+    else {
+        sqe->opcode     = IORING_OP_SEND;
+        sqe->msg_flags  = MSG_NOSIGNAL;
+    }
+    s_ring.sqArray[index] = index;
+    __atomic_store_n(s_ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    ++s_sqPending;
+    return true;
+}
+
+//===========================================================================
+// must be called inside s_ringCrit, from a reactor thread
+static unsigned SubmitPending () {
+    ASSERT(s_reactorThread);
+    while (s_sqPending) {
+        int result = SysUringEnter(s_ring.fd, s_sqPending, 0, 0);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+
+            // EAGAIN/EBUSY: the kernel is short of resources or completions
+            // need reaping; leave the entries for the reactor's next pass
+            if (errno != EAGAIN && errno != EBUSY)
+                LogMsg(kLogError, "io_uring_enter failed ({})", errno);
+            break;
+        }
+        s_sqPending -= std::min<unsigned>(s_sqPending, (unsigned) result);
+        if (!result)
+            break;
+    }
+    return s_sqPending;
+}
+
+
+/****************************************************************************
+*
+*   Module functions
+*
+***/
+
+//===========================================================================
+bool IUxUringInitialize () {
+    memset(&s_ring, 0, sizeof(s_ring));
+    s_ring.fd = -1;
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (-1 == (s_ring.fd = SysUringSetup(kRingEntries, &params))) {
+        // ENOSYS on old kernels, EPERM when disabled by policy
+        LogMsg(kLogDebug, "io_uring unavailable ({}); using epoll sends", errno);
+        return false;
+    }
+
+    if (!(params.features & IORING_FEAT_NODROP)
+    ||  !RingMap(params)
+    ||  !RingSupportsOps()
+    ||  !RegisterBuffers()
+    ||  !IUxRegister(s_ring.fd, kUxRingKey, EPOLLIN | EPOLLET)
+    ) {
+        LogMsg(kLogDebug, "io_uring missing required features; using epoll sends");
+        RingUnmap();
+        return false;
+    }
+
+    s_sqPending = 0;
+    s_sqOverflow.clear();
+    s_active = true;
+    return true;
+}
+
+//===========================================================================
+void IUxUringDestroy () {
+    if (!s_active)
+        return;
+    s_active = false;
+
+    IUxUnregister(s_ring.fd);
+    RingUnmap();
+    s_sqOverflow.clear();
+    if (s_buffers) {
+        munmap(s_buffers, (size_t) kRingBufferBytes * kRingBufferCount);
+        s_buffers = nil;
+    }
+    s_freeBufferCount = 0;
+}
+
+//===========================================================================
+bool IUxUringActive () {
+    return s_active;
+}
+
+//===========================================================================
+void IUxUringSetReactorThread () {
+    s_reactorThread = true;
+}
+
+//===========================================================================
+uint8_t * IUxUringAllocBuffer (int * bufIndex) {
+    hsLockGuard(s_bufferCrit);
+    if (!s_freeBufferCount) {
+        *bufIndex = -1;
+        return nil;
+    }
+    *bufIndex = s_freeBuffers[--s_freeBufferCount];
+    return s_buffers + (size_t) *bufIndex * kRingBufferBytes;
+}
+
+//===========================================================================
+void IUxUringFreeBuffer (int bufIndex) {
+    hsLockGuard(s_bufferCrit);
+    ASSERT(s_freeBufferCount < kRingBufferCount);
+    s_freeBuffers[s_freeBufferCount++] = bufIndex;
+}
+
+//===========================================================================
+unsigned IUxUringBufferBytes () {
+    return kRingBufferBytes;
+}
+
+//===========================================================================
+void IUxUringQueueWrite (
+    int             fd,
+    uint64_t        key,
+    const uint8_t * data,
+    unsigned        bytes,
+    int             bufIndex
+) {
+    UxRingWrite write = { fd, key, data, bytes, bufIndex };
+    PerfAddCounter(kAsyncPerfSocketUringWritesTotal, 1);
+
+    bool wakeReactor;
+    {
+        hsLockGuard(s_ringCrit);
+
+        // Writes are never submitted from here, even when the queue is
+        // full; the reactor drains the overflow as the kernel consumes
+        // entries. Keep the order intact once anything has overflowed.
+        bool wasIdle = !s_sqPending && s_sqOverflow.empty();
+        if (!s_sqOverflow.empty() || !RingQueueWrite(write))
+            s_sqOverflow.push_back(write);
+
+        // only the first write of a batch needs to wake the reactor; later
+        // ones ride along with the same io_uring_enter
+        wakeReactor = wasIdle && !s_reactorThread;
+    }
+
+    if (wakeReactor)
+        IUxWakeup();
+}
+
+//===========================================================================
+// Reactor threads only
+void IUxUringSubmit () {
+    if (!s_active)
+        return;
+
+    hsLockGuard(s_ringCrit);
+    for (;;) {
+        size_t moved = 0;
+        while (moved < s_sqOverflow.size() && RingQueueWrite(s_sqOverflow[moved]))
+            ++moved;
+        s_sqOverflow.erase(s_sqOverflow.begin(), s_sqOverflow.begin() + moved);
+
+        // stop once everything is submitted, or the kernel is refusing more
+        if (SubmitPending() || s_sqOverflow.empty() || !moved)
+            break;
+    }
+}
+
+//===========================================================================
+void IUxUringComplete () {
+    if (!s_active)
+        return;
+
+    for (;;) {
+        struct {
+            uint64_t    key;
+            int         result;
+        } completions[kMaxCompletions];
+        unsigned count = 0;
+        {
+            hsLockGuard(s_ringCrit);
+            unsigned head = *s_ring.cqHead;
+            unsigned tail = __atomic_load_n(s_ring.cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail && count < kMaxCompletions; ++head, ++count) {
+                const io_uring_cqe & cqe = s_ring.cqes[head & s_ring.cqMask];
+                completions[count].key      = cqe.user_data;
+                completions[count].result   = cqe.res;
+            }
+            __atomic_store_n(s_ring.cqHead, head, __ATOMIC_RELEASE);
+        }
+        if (!count)
+            break;
+
+        for (unsigned i = 0; i < count; ++i)
+            IUxSocketCompleteWrite((UxObject *) (uintptr_t) completions[i].key, completions[i].result);
+    }
+}
+
+} using namespace Ux;
+
+#endif // HS_BUILD_FOR_LINUX
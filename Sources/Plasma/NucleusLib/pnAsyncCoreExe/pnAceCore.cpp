@@ -78,14 +78,13 @@ static void IAsyncInitUseNt () {
 #ifdef HS_BUILD_FOR_WIN32
     NtGetApi(&g_api);
 #else
-    ErrorAssert("Nt I/O Not supported on this platform");
+    ErrorAssert(__LINE__, __FILE__, "Nt I/O Not supported on this platform");
 #endif
 }
 
 //===========================================================================
 static void IAsyncInitUseUnix () {
-#ifdef HS_BUILD_FOR_UNIX
-    #error Unix I/O not implemented yet
+#ifdef HS_BUILD_FOR_LINUX
     UxGetApi(&g_api);
 #else
     ErrorAssert(__LINE__, __FILE__, "Unix I/O Not supported on this platform");
@@ -99,7 +98,7 @@ static void IAsyncInit () {
 #elif HS_BUILD_FOR_UNIX
     IAsyncInitUseUnix();
 #else
-    ErrorAssert("AsyncCore: No default implementation for this platform");
+    ErrorAssert(__LINE__, __FILE__, "AsyncCore: No default implementation for this platform");
 #endif    
 }
 
@@ -63,7 +63,11 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 ***/
 
 //===========================================================================
+#ifdef HS_BUILD_FOR_WIN32
 static unsigned CALLBACK CreateThreadProc (LPVOID param) {
+#else
+static unsigned CreateThreadProc (void * param) {
+#endif
 
 #ifdef USE_VLD
     VLDEnable();
@@ -120,6 +124,7 @@ void * AsyncThreadCreate (
     thread->workTimeMs      = kAsyncTimeInfinite;
     StrCopy(thread->name, name, std::size(thread->name));
     
+#ifdef HS_BUILD_FOR_WIN32
     // Create thread suspended
     unsigned threadId;
     HANDLE handle = (HANDLE) _beginthreadex(
@@ -136,5 +141,14 @@ void * AsyncThreadCreate (
     }
 
     thread->handle = handle;
+#else
+    // Async threads are never joined, so the handle only identifies the
+    // thread; it can't be waited on. The thread owns (and frees) its
+    // AsyncThread record, so don't touch it once the thread is running.
+    std::thread newThread(CreateThreadProc, thread);
+    void * handle = (void *) (uintptr_t) newThread.native_handle();
+    newThread.detach();
+#endif
+
     return handle;
 }
@@ -64,10 +64,11 @@ struct AsyncTimer {
 };
 
 static std::recursive_mutex s_timerCrit;
-static FAsyncTimerProc      s_timerCurr;
-static HANDLE               s_timerThread;
-static HANDLE               s_timerEvent;
-static bool                 s_running;
+static std::atomic<FAsyncTimerProc> s_timerCurr;
+static void *               s_timerThread;
+static hsEvent              s_timerEvent;
+static hsEvent              s_timerExited;
+static std::atomic<bool>    s_running;
 
 static PRIQDECL(
     AsyncTimer,
@@ -114,7 +115,7 @@ static unsigned CallTimerProc (AsyncTimer * t, FAsyncTimerProc timerProc) {
 
     // Leave critical section to make timer callback
     hsUnlockGuard(s_timerCrit);
-    unsigned sleepMs = s_timerCurr(t->param);
+    unsigned sleepMs = timerProc(t->param);
     s_timerCurr = nil;
 
     return sleepMs;
@@ -135,7 +136,7 @@ static inline unsigned RunTimers () {
         // Get first timer to run
         AsyncTimer * t = s_timerProcs.Root();
         if (!t)
-            return INFINITE;
+            return kAsyncTimeInfinite;
 
         // If it isn't time to run this timer then exit
         unsigned sleepMs;
@@ -167,8 +168,13 @@ static unsigned THREADCALL TimerThreadProc (AsyncThread *) {
             sleepMs = RunTimers();
         }
 
-        WaitForSingleObject(s_timerEvent, sleepMs);
+        if (sleepMs == kAsyncTimeInfinite)
+            s_timerEvent.Wait();
+        else
+            s_timerEvent.Wait(std::chrono::milliseconds(sleepMs));
     } while (s_running);
+
+    s_timerExited.Signal();
     return 0;
 }
 
@@ -178,16 +184,7 @@ static inline void InitializeTimer () {
     if (!s_timerThread) {
         s_running = true;
 
-        s_timerEvent = CreateEvent(
-            (LPSECURITY_ATTRIBUTES) nil,
-            false,                  // auto-reset event
-            false,                  // initial state = off
-            (LPCTSTR) nil
-        );
-        if (!s_timerEvent)
-            ErrorAssert(__LINE__, __FILE__, "CreateEvent %u", GetLastError());
-
-        s_timerThread = (HANDLE) AsyncThreadCreate(
+        s_timerThread = AsyncThreadCreate(
             TimerThreadProc,
             nil,
             L"AsyncTimerThread"
@@ -207,17 +204,14 @@ void TimerDestroy (unsigned exitThreadWaitMs) {
     s_running = false;
 
     if (s_timerThread) {
-        SetEvent(s_timerEvent);
-        WaitForSingleObject(s_timerThread, exitThreadWaitMs);
+        s_timerEvent.Signal();
+        s_timerExited.Wait(std::chrono::milliseconds(exitThreadWaitMs));
+#ifdef HS_BUILD_FOR_WIN32
         CloseHandle(s_timerThread);
+#endif
         s_timerThread = nil;
     }
 
-    if (s_timerEvent) {
-        CloseHandle(s_timerEvent);
-        s_timerEvent = nil;
-    }
-
     // Cleanup any timers that have been stopped but not deleted
     {
         hsLockGuard(s_timerCrit);
@@ -276,7 +270,7 @@ void AsyncTimerCreate (
     }
 
     if (setEvent)
-        SetEvent(s_timerEvent);
+        s_timerEvent.Signal();
 }
 
 //===========================================================================
@@ -307,7 +301,7 @@ void AsyncTimerDelete (
     if (timerProc) {
 
         while (s_timerCurr == timerProc)
-            Sleep(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 }
 
@@ -329,7 +323,7 @@ void AsyncTimerDeleteCallback (
 
     // Force the timer thread to wake up and perform the deletion
     if (destroyProc)
-        SetEvent(s_timerEvent);
+        s_timerEvent.Signal();
 }
 
 //===========================================================================
@@ -357,5 +351,5 @@ void AsyncTimerUpdate (
     }
 
     if (setEvent)
-        SetEvent(s_timerEvent);
+        s_timerEvent.Signal();
 }
@@ -41,6 +41,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 *==LICENSE==*/
 
 #include "HeadSpin.h"
+#include <algorithm>
+#include <vector>
 #include "hsResMgr.h"
 #include "plDispatch.h"
 #define PLMESSAGE_PRIVATE
@@ -49,6 +51,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsTimer.h"
 #include "pnMessage/plTimeMsg.h"
 #include "pnKeyedObject/plKey.h"
+#include "pnKeyedObject/plKeyImp.h"
 #include "plDispatchLogBase.h"
 #include "pnNetCommon/plNetApp.h"
 #include "pnNetCommon/plSynchedObject.h"
@@ -62,30 +65,132 @@ plProfile_CreateTimer("  EvalMsg", "Update", EvalMsg);
 plProfile_CreateTimer("  TransformMsg", "Update", TransformMsg);
 plProfile_CreateTimer("  CameraMsg", "Update", CameraMsg);
 
+static const int kMaxBroadcastRun = 16;
+
 class plMsgWrap
 {
 public:
     plMsgWrap**                     fBack;
     plMsgWrap*                      fNext;
-    hsTArray<plKey>                 fReceivers;
+    std::vector<plKey>              fReceivers;
 
     plMessage*                      fMsg;
 
-    plMsgWrap(plMessage* msg)
-        : fMsg(msg), fNext(), fBack()
-    { hsRefCnt_SafeRef(msg); }
-    virtual ~plMsgWrap() { hsRefCnt_SafeUnRef(fMsg); }
+    // Set for broadcasts instead of copying the filter's receivers
+    plTypeFilterRef                 fBroadcast;
+
+    plMsgWrap()
+        : fBack(), fNext(), fMsg()
+    { }
+    ~plMsgWrap() { hsRefCnt_SafeUnRef(fMsg); }
+
+    // Wraps are recycled through a fixed-size pool and keep their receiver
+    // storage between messages, so use these rather than new and delete.
+    // Both are safe to call from any thread.
+    static plMsgWrap*               Acquire(plMessage* msg);
+    static void                     Release(plMsgWrap* wrap);
 
-    plMsgWrap&                      ClearReceivers() { fReceivers.SetCount(0); return *this; }
+    plMsgWrap&                      ClearReceivers() { fReceivers.clear(); return *this; }
     plMsgWrap&                      AddReceiver(const plKey& rcv) 
                                     { 
                                         hsAssert(rcv, "Trying to send mail to nil receiver");
-                                        fReceivers.Append(rcv); return *this;
+                                        fReceivers.push_back(rcv); return *this;
                                     }
     const plKey&                    GetReceiver(int i) const { return fReceivers[i]; }
-    uint32_t                          GetNumReceivers() const { return fReceivers.GetCount(); }
+    uint32_t                          GetNumReceivers() const { return (uint32_t)fReceivers.size(); }
+};
+
+// Lock-free free list over a fixed array of wraps. The head packs a change
+// count into the high word to guard against ABA; the low word is the index
+// of the first free wrap plus one, or zero when the pool is exhausted.
+class plMsgWrapPool
+{
+    static constexpr uint32_t   kCapacity = 1024;
+
+    plMsgWrap                   fWraps[kCapacity];
+    std::atomic<uint32_t>       fNextFree[kCapacity];
+    std::atomic<uint64_t>       fFreeHead;
+
+    static uint64_t IMakeHead(uint64_t prev, uint32_t first)
+    {
+        return (((prev >> 32) + 1) << 32) | first;
+    }
+
+public:
+    plMsgWrapPool()
+    {
+        for (uint32_t i = 0; i < kCapacity; i++)
+            fNextFree[i].store(i + 1 < kCapacity ? i + 2 : 0, std::memory_order_relaxed);
+        fFreeHead.store(1, std::memory_order_release);
+    }
+
+    static plMsgWrapPool& Instance()
+    {
+        static plMsgWrapPool pool;
+        return pool;
+    }
+
+    bool Owns(const plMsgWrap* wrap) const
+    {
+        return wrap >= fWraps && wrap < fWraps + kCapacity;
+    }
+
+    plMsgWrap* Pop()
+    {
+        uint64_t head = fFreeHead.load(std::memory_order_acquire);
+        for (;;)
+        {
+            uint32_t first = uint32_t(head);
+            if (!first)
+                return nil;
+
+            uint32_t next = fNextFree[first - 1].load(std::memory_order_relaxed);
+            if (fFreeHead.compare_exchange_weak(head, IMakeHead(head, next),
+                                                std::memory_order_acquire,
+                                                std::memory_order_acquire))
+                return &fWraps[first - 1];
+        }
+    }
+
+    void Push(plMsgWrap* wrap)
+    {
+        uint32_t idx = uint32_t(wrap - fWraps);
+        uint64_t head = fFreeHead.load(std::memory_order_relaxed);
+        do
+            fNextFree[idx].store(uint32_t(head), std::memory_order_relaxed);
+        while (!fFreeHead.compare_exchange_weak(head, IMakeHead(head, idx + 1),
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+    }
 };
 
+plMsgWrap* plMsgWrap::Acquire(plMessage* msg)
+{
+    plMsgWrap* wrap = plMsgWrapPool::Instance().Pop();
+    if (!wrap)
+        wrap = new plMsgWrap;
+
+    wrap->fBack = nil;
+    wrap->fNext = nil;
+    wrap->fMsg = msg;
+    hsRefCnt_SafeRef(msg);
+    return wrap;
+}
+
+void plMsgWrap::Release(plMsgWrap* wrap)
+{
+    hsRefCnt_SafeUnRef(wrap->fMsg);
+    wrap->fMsg = nil;
+    wrap->fReceivers.clear();
+    wrap->fBroadcast.reset();
+
+    plMsgWrapPool& pool = plMsgWrapPool::Instance();
+    if (pool.Owns(wrap))
+        pool.Push(wrap);
+    else
+        delete wrap;
+}
+
 int32_t                 plDispatch::fNumBufferReq = 0;
 bool                    plDispatch::fMsgActive = false;
 plMsgWrap*              plDispatch::fMsgCurrent = nil;
@@ -99,21 +204,19 @@ std::mutex              plDispatch::fMsgDispatchLock; // mutex for IMsgDispatch
 
 
 plDispatch::plDispatch()
-: fOwner(nil), fFutureMsgQueue(nil), fQueuedMsgOn(true)
+: fOwner(nil), fFutureMsgQueue(nil), fQueuedMsgHead(nil), fQueuedMsgOn(true)
 {
 }
 
 plDispatch::~plDispatch()
 {
-    hsAssert(fRegisteredExactTypes.GetCount() == 0, "registered type after Dispatch shutdown");
+    hsAssert(fRegisteredExactTypes.empty(), "registered type after Dispatch shutdown");
     ITrashUndelivered();
 }
 
 void plDispatch::BeginShutdown()
 {
-    for (int i = 0; i < fRegisteredExactTypes.Count(); ++i)
-        delete fRegisteredExactTypes[i];
-    fRegisteredExactTypes.Reset();
+    fRegisteredExactTypes.clear();
     ITrashUndelivered();
 }
 
@@ -124,7 +227,16 @@ void plDispatch::ITrashUndelivered()
         plMsgWrap* nuke = fFutureMsgQueue;
         fFutureMsgQueue = fFutureMsgQueue->fNext;
         hsRefCnt_SafeUnRef(nuke->fMsg);
-        delete nuke;
+        plMsgWrap::Release(nuke);
+    }
+
+    // The wrap holds the only ref to a message queued by another thread
+    plMsgWrap* queued = fQueuedMsgHead.exchange(nil, std::memory_order_acquire);
+    while (queued)
+    {
+        plMsgWrap* nuke = queued;
+        queued = queued->fNext;
+        plMsgWrap::Release(nuke);
     }
 
     // If we're the main dispatch, any unsent messages at this
@@ -137,8 +249,8 @@ void plDispatch::ITrashUndelivered()
         {
             plMsgWrap* nuke = fMsgHead;
             fMsgHead = fMsgHead->fNext;
-            // hsRefCnt_SafeUnRef(nuke->fMsg);      // MOOSE - done in plMsgWrap dtor
-            delete nuke;
+            // hsRefCnt_SafeUnRef(nuke->fMsg);      // MOOSE - done in plMsgWrap::Release
+            plMsgWrap::Release(nuke);
         }
 
         // reset static members which we just deleted - MOOSE
@@ -174,7 +286,7 @@ plMsgWrap* plDispatch::IDequeue(plMsgWrap** head, plMsgWrap** tail)
 
 bool plDispatch::ISortToDeferred(plMessage* msg)
 {
-    plMsgWrap* msgWrap = new plMsgWrap(msg);
+    plMsgWrap* msgWrap = plMsgWrap::Acquire(msg);
     if( !fFutureMsgQueue )
     {
         if( IGetOwner() )
@@ -203,7 +315,7 @@ void plDispatch::ICheckDeferred(double secs)
     {
         plMsgWrap* send = IDequeue(&fFutureMsgQueue, nil);
         MsgSend(send->fMsg);
-        delete send;
+        plMsgWrap::Release(send);
     }
 
     int timeIdx = plTimeMsg::Index();
@@ -211,7 +323,7 @@ void plDispatch::ICheckDeferred(double secs)
         && !fFutureMsgQueue 
         && 
             ( 
-                (timeIdx >= fRegisteredExactTypes.GetCount()) 
+                (timeIdx >= fRegisteredExactTypes.size()) 
                 || 
                 !fRegisteredExactTypes[plTimeMsg::Index()]
             )
@@ -272,6 +384,148 @@ bool plDispatch::SetMsgBuffering(bool on)
     return true;
 }
 
+// Runs of these are delivered receiver by receiver rather than message by
+// message. Nothing depends on the interleaving of their delivery across
+// receivers, only on each receiver seeing them in order.
+static bool IIsBatchedBroadcast(plMsgWrap* msgWrap)
+{
+    if (!msgWrap->fBroadcast || !msgWrap->fMsg)
+        return false;
+
+    uint16_t msgClass = msgWrap->fMsg->ClassIndex();
+    return msgClass == plTimeMsg::Index()
+        || msgClass == plEvalMsg::Index()
+        || msgClass == plTransformMsg::Index();
+}
+
+static bool ICanJoinRun(plMsgWrap* head, plMsgWrap* next)
+{
+    // Messages generated while the run is delivered inherit their net
+    // flags from the head, so those must match too
+    const uint32_t kCascadeFlags = plMessage::kNetSent | plMessage::kNetNonLocal;
+    return next->fBroadcast == head->fBroadcast
+        && next->fMsg
+        && next->fMsg->ClassIndex() == head->fMsg->ClassIndex()
+        && (next->fMsg->GetAllBCastFlags() & kCascadeFlags) == (head->fMsg->GetAllBCastFlags() & kCascadeFlags);
+}
+
+static void IResolveReceiver(plTypeFilter* filt, size_t i)
+{
+    plKeyImp* rcvKey = filt->fReceivers[i];
+    filt->fResolved[i] = rcvKey ? plReceiver::ConvertNoRef(rcvKey->ObjectIsLoaded()) : nil;
+    filt->fResolvedEpochs[i] = rcvKey ? rcvKey->GetObjectEpoch() : 0;
+}
+
+void plDispatch::IResolveReceivers(plTypeFilter* filt)
+{
+    // Only registration changes clear the cache; loads and unloads are caught
+    // per key by IGetResolvedReceiver
+    if (filt->fResolved.size() == filt->fReceivers.size())
+        return;
+
+    filt->fResolved.resize(filt->fReceivers.size());
+    filt->fResolvedEpochs.resize(filt->fReceivers.size());
+    for (size_t i = 0; i < filt->fReceivers.size(); i++)
+        IResolveReceiver(filt, i);
+}
+
+plReceiver* plDispatch::IGetResolvedReceiver(plTypeFilter* filt, size_t i)
+{
+    // An earlier receiver may have loaded or unloaded this one
+    plKeyImp* rcvKey = filt->fReceivers[i];
+    if (rcvKey && rcvKey->GetObjectEpoch() != filt->fResolvedEpochs[i])
+        IResolveReceiver(filt, i);
+    return filt->fResolved[i];
+}
+
+bool plDispatch::IDeliver(plReceiver* rcv, plMessage* msg)
+{
+    if (msg && msg->HasBCastFlag(plMessage::kNetNonLocal))
+    {
+        // localOnly objects should not get remote messages
+        plSynchedObject* synchedObj = plSynchedObject::ConvertNoRef(rcv);
+        if (synchedObj && !synchedObj->IsNetSynched() )
+        {
+            return false;
+        }
+
+        if (plNetObjectDebuggerBase::GetInstance())
+        {   // log net msg if this is a debug object
+            hsKeyedObject* ko = hsKeyedObject::ConvertNoRef(rcv);
+            if (plNetObjectDebuggerBase::GetInstance()->IsDebugObject(ko))
+            {
+                hsLogEntry(plNetObjectDebuggerBase::GetInstance()->LogMsg(
+                    ST::format("<RCV> object:{}, GameMessage {} st={.3f} rt={.3f}",
+                    ko->GetKeyName(), msg->ClassName(), hsTimer::GetSysSeconds(),
+                    hsTimer::GetSeconds()).c_str()));
+            }
+        }
+    }
+
+#ifndef PLASMA_EXTERNAL_RELEASE
+    uint64_t rcvTicks = hsTimer::GetTicks();
+
+    // Object could be deleted by this message, so we need to log this stuff now
+    ST::string keyname = ST_LITERAL("(unknown)");
+    const char* className = "(unknown)";
+    uint32_t clonePlayerID = 0;
+    if (plDispatchLogBase::IsLoggingLong())
+    {
+        hsKeyedObject* ko = hsKeyedObject::ConvertNoRef(rcv);
+        if (ko)
+        {
+            keyname = ko->GetKeyName();
+            clonePlayerID = ko->GetKey()->GetUoid().GetClonePlayerID();
+            className = ko->ClassName();
+        }
+    }
+#endif // PLASMA_EXTERNAL_RELEASE
+
+    #ifdef HS_DEBUGGING
+    if (msg->GetBreakBeforeDispatch())
+        DebugBreakIfDebuggerPresent();
+    #endif
+        
+    plProfile_BeginTiming(MsgReceive);
+    rcv->MsgReceive(msg);
+    plProfile_EndTiming(MsgReceive);
+
+#ifndef PLASMA_EXTERNAL_RELEASE
+    if (plDispatchLogBase::IsLoggingLong())
+    {
+        rcvTicks = hsTimer::GetTicks() - rcvTicks;
+
+        float rcvTime = hsTimer::GetMilliSeconds<float>(rcvTicks);
+        // If the receiver takes more than 5 ms to process its message, log it
+        if (rcvTime > 5.f)
+            plDispatchLogBase::GetInstance()->LogLongReceive(keyname.c_str(), className, clonePlayerID, msg, rcvTime);
+    }
+#endif // PLASMA_EXTERNAL_RELEASE
+
+    if (fMsgRecieveCallback != nil)
+        fMsgRecieveCallback();
+
+    return true;
+}
+
+int plDispatch::IDeliverBroadcast(plMsgWrap* run[], int runLength)
+{
+    plTypeFilter* filt = run[0]->fBroadcast.get();
+    int numReceivers = 0;
+
+    IResolveReceivers(filt);
+    for (size_t i = 0; fMsgCurrent && i < filt->fReceivers.size(); i++)
+    {
+        for (int j = 0; fMsgCurrent && j < runLength; j++)
+        {
+            plReceiver* rcv = IGetResolvedReceiver(filt, i);
+            if (rcv && IDeliver(rcv, run[j]->fMsg))
+                numReceivers++;
+        }
+    }
+    return numReceivers;
+}
+
 void plDispatch::IMsgDispatch()
 {
     std::unique_lock<std::mutex> dispatchLock(fMsgDispatchLock, std::try_to_lock);
@@ -290,19 +544,32 @@ void plDispatch::IMsgDispatch()
     while((fMsgCurrent = fMsgHead))
     {
         IDequeue(&fMsgHead, &fMsgTail);
+
+        // Pick up the broadcasts queued right behind this one, so each
+        // receiver gets the whole run in one visit
+        plMsgWrap* run[kMaxBroadcastRun];
+        int runLength = 0;
+        run[runLength++] = fMsgCurrent;
+        if (IIsBatchedBroadcast(fMsgCurrent))
+        {
+            while (runLength < kMaxBroadcastRun && fMsgHead && ICanJoinRun(fMsgCurrent, fMsgHead))
+                run[runLength++] = IDequeue(&fMsgHead, &fMsgTail);
+        }
         msgCurrentLock.unlock();
 
         plMessage* msg = fMsgCurrent->fMsg;
-        bool nonLocalMsg = msg && msg->HasBCastFlag(plMessage::kNetNonLocal);
 
 #ifdef HS_DEBUGGING
-        int watchIdx = fMsgWatch.Find(msg);
-        if( fMsgWatch.kMissingIndex != watchIdx )
+        for (int r = 0; r < runLength; r++)
         {
-            fMsgWatch.Remove(watchIdx);
+            int watchIdx = fMsgWatch.Find(run[r]->fMsg);
+            if( fMsgWatch.kMissingIndex != watchIdx )
+            {
+                fMsgWatch.Remove(watchIdx);
 #if HS_BUILD_FOR_WIN32
-            __debugbreak();
+                __debugbreak();
 #endif // HS_BUILD_FOR_WIN32
+            }
         }
 #endif // HS_DEBUGGING
 
@@ -310,79 +577,19 @@ void plDispatch::IMsgDispatch()
         if (plDispatchLogBase::IsLogging())
             startTicks = hsTimer::GetTicks();
 
-        int i, numReceivers=0;
-        for( i = 0; fMsgCurrent && i < fMsgCurrent->GetNumReceivers(); i++ )
+        int numReceivers=0;
+        if (fMsgCurrent->fBroadcast)
+        {
+            numReceivers = IDeliverBroadcast(run, runLength);
+        }
+        else
         {
-            const plKey& rcvKey = fMsgCurrent->GetReceiver(i);
-            plReceiver* rcv = rcvKey ? plReceiver::ConvertNoRef(rcvKey->ObjectIsLoaded()) : nil;
-            if( rcv )
+            for( int i = 0; fMsgCurrent && i < fMsgCurrent->GetNumReceivers(); i++ )
             {
-                if (nonLocalMsg)
-                {
-                    // localOnly objects should not get remote messages
-                    plSynchedObject* synchedObj = plSynchedObject::ConvertNoRef(rcv);
-                    if (synchedObj && !synchedObj->IsNetSynched() )
-                    {
-                        continue;
-                    }
-
-                    if (plNetObjectDebuggerBase::GetInstance())
-                    {   // log net msg if this is a debug object
-                        hsKeyedObject* ko = hsKeyedObject::ConvertNoRef(rcv);
-                        if (plNetObjectDebuggerBase::GetInstance()->IsDebugObject(ko))
-                        {
-                            hsLogEntry(plNetObjectDebuggerBase::GetInstance()->LogMsg(
-                                ST::format("<RCV> object:{}, GameMessage {} st={.3f} rt={.3f}",
-                                ko->GetKeyName(), msg->ClassName(), hsTimer::GetSysSeconds(),
-                                hsTimer::GetSeconds()).c_str()));
-                        }
-                    }
-                }
-
-#ifndef PLASMA_EXTERNAL_RELEASE
-                uint64_t rcvTicks = hsTimer::GetTicks();
-
-                // Object could be deleted by this message, so we need to log this stuff now
-                ST::string keyname = ST_LITERAL("(unknown)");
-                const char* className = "(unknown)";
-                uint32_t clonePlayerID = 0;
-                if (plDispatchLogBase::IsLoggingLong())
-                {
-                    hsKeyedObject* ko = hsKeyedObject::ConvertNoRef(rcv);
-                    if (ko)
-                    {
-                        keyname = ko->GetKeyName();
-                        clonePlayerID = ko->GetKey()->GetUoid().GetClonePlayerID();
-                        className = ko->ClassName();
-                    }
-                }
-#endif // PLASMA_EXTERNAL_RELEASE
-
-                #ifdef HS_DEBUGGING
-                if (msg->GetBreakBeforeDispatch())
-                    DebugBreakIfDebuggerPresent();
-                #endif
-                    
-                plProfile_BeginTiming(MsgReceive);
-                rcv->MsgReceive(msg);
-                plProfile_EndTiming(MsgReceive);
-
-#ifndef PLASMA_EXTERNAL_RELEASE
-                if (plDispatchLogBase::IsLoggingLong())
-                {
-                    rcvTicks = hsTimer::GetTicks() - rcvTicks;
-
-                    float rcvTime = hsTimer::GetMilliSeconds<float>(rcvTicks);
-                    // If the receiver takes more than 5 ms to process its message, log it
-                    if (rcvTime > 5.f)
-                        plDispatchLogBase::GetInstance()->LogLongReceive(keyname.c_str(), className, clonePlayerID, msg, rcvTime);
-                }
-#endif // PLASMA_EXTERNAL_RELEASE
-
-                numReceivers++;
-
-                if (fMsgRecieveCallback != nil)
-                    fMsgRecieveCallback();
+                const plKey& rcvKey = fMsgCurrent->GetReceiver(i);
+                plReceiver* rcv = rcvKey ? plReceiver::ConvertNoRef(rcvKey->ObjectIsLoaded()) : nil;
+                if( rcv && IDeliver(rcv, msg) )
+                    numReceivers++;
             }
         }
 
@@ -401,7 +608,8 @@ void plDispatch::IMsgDispatch()
 
         msgCurrentLock.lock();
 
-        delete fMsgCurrent;
+        for (int r = 0; r < runLength; r++)
+            plMsgWrap::Release(run[r]);
         // TEMP
         fMsgCurrent = (class plMsgWrap *)0xdeadc0de;
     }
@@ -463,36 +671,25 @@ bool plDispatch::MsgSend(plMessage* msg, bool async)
     else if((timeMsg = plTimeMsg::ConvertNoRef(msg)))
         ICheckDeferred(timeMsg->DSeconds());
 
-    plMsgWrap* msgWrap = new plMsgWrap(msg);
+    plMsgWrap* msgWrap = plMsgWrap::Acquire(msg);
     hsRefCnt_SafeUnRef(msg);
 
     // broadcast
     if( msg->HasBCastFlag(plMessage::kBCastByExactType) | msg->HasBCastFlag(plMessage::kBCastByType) )
     {
         int idx = msg->ClassIndex();
-        if( idx < fRegisteredExactTypes.GetCount() )
+        if( idx < fRegisteredExactTypes.size() && fRegisteredExactTypes[idx] )
         {
-            plTypeFilter* filt = fRegisteredExactTypes[idx];
-            if( filt )
-            {
-                int j;
-                for( j = 0; j < filt->fReceivers.GetCount(); j++ )
-                {
-                    msgWrap->AddReceiver(filt->fReceivers[j]);
-                }
-                if( msg->HasBCastFlag(plMessage::kClearAfterBCast) )
-                {
-                    delete filt;
-                    fRegisteredExactTypes[idx] = nil;
-                }
-            }
+            msgWrap->fBroadcast = fRegisteredExactTypes[idx];
+            if( msg->HasBCastFlag(plMessage::kClearAfterBCast) )
+                fRegisteredExactTypes[idx].reset();
         }
     }
     // Direct communique
     else
     if( msg->GetNumReceivers() )
     {
-        msgWrap->fReceivers = msg->fReceivers;
+        msgWrap->fReceivers.assign(msg->fReceivers.FirstIter(), msg->fReceivers.StopIter());
     }
     IMsgEnqueue(msgWrap, async);
 
@@ -506,9 +703,18 @@ void plDispatch::MsgQueue(plMessage* msg)
 {
     if (fQueuedMsgOn)
     {
-        hsLockGuard(fQueuedMsgListMutex);
         hsAssert(msg,"Message missing");
-        fQueuedMsgList.push_back(msg);
+
+        // The wrap takes over the caller's ref, and its link is used to
+        // push it onto the queue without taking a lock
+        plMsgWrap* msgWrap = plMsgWrap::Acquire(msg);
+        hsRefCnt_SafeUnRef(msg);
+
+        msgWrap->fNext = fQueuedMsgHead.load(std::memory_order_relaxed);
+        while (!fQueuedMsgHead.compare_exchange_weak(msgWrap->fNext, msgWrap,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed))
+            ;
     }
     else
         MsgSend(msg, false);
@@ -516,23 +722,36 @@ void plDispatch::MsgQueue(plMessage* msg)
 
 void plDispatch::MsgQueueProcess()
 {
-    // Process all messages on Queue, unlock while sending them
-    // this would allow other threads to put new messages on the list while we send()
-    bool empty = false;
-    while (!empty)
+    // Only this thread takes messages off the queue, so it can grab
+    // everything queued so far in one go. Messages queued while these are
+    // being sent are picked up by the next pass.
+    for (;;)
     {
-        plMessage * pMsg = nullptr;
+        plMsgWrap* batch = fQueuedMsgHead.exchange(nil, std::memory_order_acquire);
+        if (!batch)
+            break;
+
+        // The stack is newest first; reverse it to send in queue order
+        plMsgWrap* ordered = nil;
+        while (batch)
         {
-            hsLockGuard(fQueuedMsgListMutex);
-            empty = fQueuedMsgList.empty();
-            if (!empty)
-            {
-                pMsg = fQueuedMsgList.front();
-                fQueuedMsgList.pop_front();
-            }
+            plMsgWrap* next = batch->fNext;
+            batch->fNext = ordered;
+            ordered = batch;
+            batch = next;
+        }
+
+        while (ordered)
+        {
+            plMsgWrap* msgWrap = ordered;
+            ordered = ordered->fNext;
+
+            // hand the queue's ref on to MsgSend
+            plMessage* msg = msgWrap->fMsg;
+            hsRefCnt_SafeRef(msg);
+            plMsgWrap::Release(msgWrap);
+            MsgSend(msg, false);
         }
-        if (pMsg)
-            MsgSend(pMsg, false);
     }
 }
 
@@ -546,26 +765,38 @@ void plDispatch::RegisterForType(uint16_t hClass, const plKey& receiver)
     }
 }
 
+plTypeFilter* plDispatch::IEditFilter(int idx)
+{
+    // Queued broadcasts keep the receivers they were sent to
+    plTypeFilterRef& filt = fRegisteredExactTypes[idx];
+    if (filt.use_count() > 1)
+        filt = std::make_shared<plTypeFilter>(*filt);
+
+    filt->fResolved.clear();
+    filt->fResolvedEpochs.clear();
+    return filt.get();
+}
+
 void plDispatch::RegisterForExactType(uint16_t hClass, const plKey& receiver)
 {
     int idx = hClass;
-    fRegisteredExactTypes.ExpandAndZero(idx+1);
-    plTypeFilter* filt = fRegisteredExactTypes[idx];
-    if( !filt )
+    if (idx >= fRegisteredExactTypes.size())
+        fRegisteredExactTypes.resize(idx+1);
+    if( !fRegisteredExactTypes[idx] )
     {
-        filt = new plTypeFilter;
-        fRegisteredExactTypes[idx] = filt;
-        filt->fHClass = hClass;
+        fRegisteredExactTypes[idx] = std::make_shared<plTypeFilter>();
+        fRegisteredExactTypes[idx]->fHClass = hClass;
     }
 
-    if( filt->fReceivers.kMissingIndex == filt->fReceivers.Find(receiver) )
-        filt->fReceivers.Append(receiver);
+    const std::vector<plKey>& receivers = fRegisteredExactTypes[idx]->fReceivers;
+    if( std::find(receivers.begin(), receivers.end(), receiver) == receivers.end() )
+        IEditFilter(idx)->fReceivers.push_back(receiver);
 }
 
 void plDispatch::UnRegisterForType(uint16_t hClass, const plKey& receiver)
 {
     int i;
-    for( i = 0; i < fRegisteredExactTypes.GetCount(); i++ )
+    for( i = 0; i < fRegisteredExactTypes.size(); i++ )
     {
         if( plFactory::DerivesFrom(hClass, i) )
             IUnRegisterForExactType(i , receiver);
@@ -575,30 +806,25 @@ void plDispatch::UnRegisterForType(uint16_t hClass, const plKey& receiver)
 
 bool plDispatch::IUnRegisterForExactType(int idx, const plKey& receiver)
 {
-    hsAssert(idx < fRegisteredExactTypes.GetCount(), "Out of range should be filtered before call to internal");
-    plTypeFilter* filt = fRegisteredExactTypes[idx];
+    hsAssert(idx < fRegisteredExactTypes.size(), "Out of range should be filtered before call to internal");
+    plTypeFilter* filt = fRegisteredExactTypes[idx].get();
     if (!filt)
         return false;
-    int j;
-    for( j = 0; j < filt->fReceivers.GetCount(); j++ )
-    {
-        if( receiver == filt->fReceivers[j] )
-        {
-            if( filt->fReceivers.GetCount() > 1 )
-            {
-                if( j < filt->fReceivers.GetCount() - 1 )
-                    filt->fReceivers[j] = filt->fReceivers[filt->fReceivers.GetCount() - 1];
-                filt->fReceivers[filt->fReceivers.GetCount()-1] = nil;
-                filt->fReceivers.SetCount(filt->fReceivers.GetCount()-1);
-            }
-            else
-            {
-                delete filt;
-                fRegisteredExactTypes[idx] = nil;
-            }
 
-            break;
-        }
+    auto it = std::find(filt->fReceivers.begin(), filt->fReceivers.end(), receiver);
+    if (it == filt->fReceivers.end())
+        return false;
+
+    if( filt->fReceivers.size() > 1 )
+    {
+        size_t j = it - filt->fReceivers.begin();
+        filt = IEditFilter(idx);
+        filt->fReceivers[j] = filt->fReceivers.back();
+        filt->fReceivers.pop_back();
+    }
+    else
+    {
+        fRegisteredExactTypes[idx].reset();
     }
     return false;
 }
@@ -606,38 +832,16 @@ bool plDispatch::IUnRegisterForExactType(int idx, const plKey& receiver)
 void plDispatch::UnRegisterAll(const plKey& receiver)
 {
     int i;
-    for( i = 0; i < fRegisteredExactTypes.GetCount(); i++ )
-    {
-        plTypeFilter* filt = fRegisteredExactTypes[i];
-        if( filt )
-        {
-            int idx = filt->fReceivers.Find(receiver);
-            if( idx != filt->fReceivers.kMissingIndex )
-            {
-                if( filt->fReceivers.GetCount() > 1 )
-                {
-                    if( idx < filt->fReceivers.GetCount() - 1 )
-                        filt->fReceivers[idx] = filt->fReceivers[filt->fReceivers.GetCount() - 1];
-                    filt->fReceivers[filt->fReceivers.GetCount()-1] = nil;
-                    filt->fReceivers.SetCount(filt->fReceivers.GetCount()-1);
-                }
-                else
-                {
-                    delete filt;
-                    fRegisteredExactTypes[i] = nil;
-                }
-            }
-        }
-    }
+    for( i = 0; i < fRegisteredExactTypes.size(); i++ )
+        IUnRegisterForExactType(i, receiver);
 }
 
 void plDispatch::UnRegisterForExactType(uint16_t hClass, const plKey& receiver)
 {
     int idx = hClass;
-    if( idx >= fRegisteredExactTypes.GetCount() )
+    if( idx >= fRegisteredExactTypes.size() )
         return;
-    plTypeFilter* filt = fRegisteredExactTypes[idx];
-    if( !filt )
+    if( !fRegisteredExactTypes[idx] )
         return;
 
     IUnRegisterForExactType(idx, receiver);
@@ -43,8 +43,10 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef plDispatch_inc
 #define plDispatch_inc
 
-#include <list>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <vector>
 #include "hsTemplates.h"
 #include "plgDispatch.h"
 #include "hsThread.h"
@@ -53,16 +55,28 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 class hsResMgr;
 class plMessage;
 class plKey;
+class plReceiver;
 
+// Receivers registered for one exact class. Broadcasts hold on to the filter
+// they were sent through rather than copying its keys, so a filter that is
+// still referenced by a queued message is replaced, not edited, when the
+// registrations change.
 class plTypeFilter
 {
 public:
     plTypeFilter() : fHClass(0) {}
 
-    uint16_t              fHClass;
-    hsTArray<plKey>     fReceivers;
+    uint16_t                    fHClass;
+    std::vector<plKey>          fReceivers;
+
+    // Loaded receivers parallel to fReceivers, along with the object epoch
+    // of each key when it was looked up
+    std::vector<plReceiver*>    fResolved;
+    std::vector<uint32_t>       fResolvedEpochs;
 };
 
+typedef std::shared_ptr<plTypeFilter> plTypeFilterRef;
+
 class plMsgWrap;
 
 typedef void (*MsgRecieveCallback)();
@@ -84,9 +98,8 @@ protected:
     static hsTArray<plMessage*>     fMsgWatch;
     static MsgRecieveCallback       fMsgRecieveCallback;
 
-    hsTArray<plTypeFilter*>         fRegisteredExactTypes;
-    std::list<plMessage*>           fQueuedMsgList;
-    std::mutex                      fQueuedMsgListMutex; // mutex for above
+    std::vector<plTypeFilterRef>    fRegisteredExactTypes;
+    std::atomic<plMsgWrap*>         fQueuedMsgHead;     // lock-free stack, newest first
     bool                            fQueuedMsgOn;       // Turns on or off Queued Messages, Plugins need them off
 
     hsKeyedObject*                  IGetOwner() { return fOwner; }
@@ -100,6 +113,12 @@ protected:
 
     bool                            IMsgNetPropagate(plMessage* msg);
 
+    plTypeFilter*                   IEditFilter(int idx);
+    static void                     IResolveReceivers(plTypeFilter* filt);
+    static plReceiver*              IGetResolvedReceiver(plTypeFilter* filt, size_t i);
+    static bool                     IDeliver(plReceiver* rcv, plMessage* msg);
+    static int                      IDeliverBroadcast(plMsgWrap* run[], int runLength);
+
     static void                     IMsgDispatch();
     static void                     IMsgEnqueue(plMsgWrap* msgWrap, bool async);
 
@@ -80,6 +80,7 @@ hsKeyedObject* plKeyImp::SafeGetObject(const plKeyImp* key) {
 
 plKeyImp::plKeyImp() :
     fObjectPtr(nil),
+    fObjectEpoch(0),
     fStartPos(-1),
     fDataLen(-1),
     fNumActiveRefs(0),
@@ -94,6 +95,7 @@ plKeyImp::plKeyImp() :
 plKeyImp::plKeyImp(plUoid u, uint32_t pos,uint32_t len):
     fUoid(u),
     fObjectPtr(nil),
+    fObjectEpoch(0),
     fStartPos(pos),
     fDataLen(len),
     fNumActiveRefs(0),
@@ -167,6 +169,7 @@ hsKeyedObject* plKeyImp::ObjectIsLoaded() const
 void plKeyImp::CopyForClone(const plKeyImp *p, uint32_t playerID, uint32_t cloneID)
 {
     fObjectPtr = nil;               // the clone object start as nil
+    IBumpObjectEpoch();
     fUoid = p->GetUoid();           // we will set the UOID the same to start
 
 #ifdef HS_DEBUGGING
@@ -248,6 +251,7 @@ void plKeyImp::UnRegister()     // called from plRegistry
     {
         INotifyDestroyed();
         fObjectPtr = nil;
+        IBumpObjectEpoch();
         fNumActiveRefs = 0;
 
         hsRefCnt_SafeUnRef(ko);
@@ -321,13 +325,18 @@ hsKeyedObject* plKeyImp::SetObjectPtr(hsKeyedObject* p)
         hsAssert(!fObjectPtr, "Setting an ObjectPtr thats already Set!");
 
         retVal = fObjectPtr = p;
+        IBumpObjectEpoch();
     }
     else
     {
         if (fObjectPtr)
             UnRegister();
 
-        fObjectPtr = nil;
+        if (fObjectPtr)
+        {
+            fObjectPtr = nil;
+            IBumpObjectEpoch();
+        }
         retVal = nil;
     }
 
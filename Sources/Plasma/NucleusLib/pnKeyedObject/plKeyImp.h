@@ -106,6 +106,10 @@ public:
     // hsKeyedObject use only!
     hsKeyedObject* SetObjectPtr(hsKeyedObject* p);
 
+    // Changes whenever this key's object is set or cleared, so anything caching
+    // a pointer to the loaded object knows when to look it up again.
+    uint32_t GetObjectEpoch() const { return fObjectEpoch; }
+
     ////////////////////////////////////////////////////////////////////////////
     // ResManager/Registry use only!
     //
@@ -159,7 +163,10 @@ protected:
 
     void IRelease(plKeyImp* keyImp);
 
+    void IBumpObjectEpoch() { ++fObjectEpoch; }
+
     hsKeyedObject* fObjectPtr;
+    uint32_t fObjectEpoch;
 
     // These fields are the ones actually saved to disk
     plUoid fUoid;
@@ -61,6 +61,36 @@ namespace pnNetCli {
 
 struct NetMsgChannel;
 
+// Receive messages are compiled from their NetMsgField definitions when the
+// protocol is registered. Adjacent fixed-size fields are merged so each run
+// is read with a single copy.
+enum ENetMsgDecodeOp {
+    kNetMsgDecodeFixed,     // run of fixed-size fields
+    kNetMsgDecodeString,    // length-prefixed string, padded to the full field size
+    kNetMsgDecodeVarData,   // data sized by the var count ending the previous run
+};
+
+struct NetMsgDecodeSwap {
+    uint32_t        offset;         // from the start of the run
+    uint32_t        count;
+    uint32_t        size;           // element size in bytes
+};
+
+struct NetMsgDecodeStep {
+    ENetMsgDecodeOp op;
+    uint32_t        bytes;          // run size, or field size for strings
+    uint32_t        varElemSize;    // nonzero if the run ends with a var count
+    uint32_t        swapBegin;      // range of NetMsgRecvDecoder::swaps for the run
+    uint32_t        swapEnd;
+};
+
+struct NetMsgRecvDecoder {
+    NetMsgInitRecv                  init;
+    uint32_t                        fixedBytes; // decoded size less var data
+    std::vector<NetMsgDecodeStep>   steps;
+    std::vector<NetMsgDecodeSwap>   swaps;      // only needed on big-endian hosts
+};
+
 NetMsgChannel * NetMsgChannelLock (
     unsigned        protocol,
     bool            server,
@@ -69,7 +99,7 @@ NetMsgChannel * NetMsgChannelLock (
 void NetMsgChannelUnlock (
     NetMsgChannel * channel
 );
-const NetMsgInitRecv * NetMsgChannelFindRecvMessage (
+const NetMsgRecvDecoder * NetMsgChannelFindRecvMessage (
     NetMsgChannel * channel,
     unsigned        messageId
 );
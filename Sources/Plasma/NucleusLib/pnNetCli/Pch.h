@@ -56,6 +56,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pnAsyncCore/pnAsyncCore.h"
 #include "pnEncryption/plBigNum.h"
 
+#include <vector>
+
 #include "pnNetCli.h"
 #include "Intern.h"
 
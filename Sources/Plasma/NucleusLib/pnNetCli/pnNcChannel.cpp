@@ -90,7 +90,7 @@ struct NetMsgChannel : hsRefCnt {
     // Message definitions
     uint32_t                m_largestRecv;
     TArray<NetMsgInitSend>  m_sendMsgs;
-    TArray<NetMsgInitRecv>  m_recvMsgs;
+    std::vector<NetMsgRecvDecoder> m_recvMsgs;
 
     // Diffie-Hellman constants
     uint32_t                m_dh_g;
@@ -198,6 +198,82 @@ static unsigned ValidateMsg (const NetMsg & msg) {
 }
 
 
+//===========================================================================
+static void CompileRecvMsg (NetMsgRecvDecoder * decoder) {
+    const NetMsg & msg = *decoder->init.msg;
+
+    decoder->fixedBytes = 0;
+    decoder->steps.clear();
+    decoder->swaps.clear();
+
+    // index of the fixed-size run being extended, if any
+    size_t run = (size_t)-1;
+
+    for (unsigned i = 0; i < msg.count; i++) {
+        const NetMsgField & field = msg.fields[i];
+
+        uint32_t bytes;
+        switch (field.type) {
+            case kNetMsgFieldInteger:
+            case kNetMsgFieldReal:
+                bytes = (field.count ? field.count : 1) * field.size;
+            break;
+
+            case kNetMsgFieldData:
+            case kNetMsgFieldRawData:
+                bytes = field.count * field.size;
+            break;
+
+            case kNetMsgFieldVarCount:
+                bytes = sizeof(uint32_t);
+            break;
+
+            case kNetMsgFieldString: {
+                NetMsgDecodeStep step = { kNetMsgDecodeString, field.count * field.size };
+                decoder->steps.push_back(step);
+                decoder->fixedBytes += step.bytes;
+                run = (size_t)-1;
+            }
+            continue;
+
+            case kNetMsgFieldVarPtr:
+            case kNetMsgFieldRawVarPtr: {
+                NetMsgDecodeStep step = { kNetMsgDecodeVarData };
+                decoder->steps.push_back(step);
+                run = (size_t)-1;
+            }
+            continue;
+
+            default:
+                // pointer fields are never received
+            continue;
+        }
+
+        if (run == (size_t)-1) {
+            run = decoder->steps.size();
+            const uint32_t swapIndex = (uint32_t)decoder->swaps.size();
+            NetMsgDecodeStep step = { kNetMsgDecodeFixed, 0, 0, swapIndex, swapIndex };
+            decoder->steps.push_back(step);
+        }
+
+        NetMsgDecodeStep & step = decoder->steps[run];
+        if (!LITTLE_ENDIAN && field.type == kNetMsgFieldInteger && field.size > 1) {
+            NetMsgDecodeSwap swap = { step.bytes, bytes / field.size, field.size };
+            decoder->swaps.push_back(swap);
+            step.swapEnd = (uint32_t)decoder->swaps.size();
+        }
+        step.bytes += bytes;
+        decoder->fixedBytes += bytes;
+
+        // the var data that follows is sized by this field, so the
+        // run must end here
+        if (field.type == kNetMsgFieldVarCount) {
+            step.varElemSize = field.size;
+            run = (size_t)-1;
+        }
+    }
+}
+
 //===========================================================================
 template<class T>
 static unsigned MaxMsgId (const T msgs[], unsigned count) {
@@ -235,20 +311,24 @@ static void AddRecvMsgs_CS (
     const NetMsgInitRecv    src[],
     unsigned                count
 ) {
-    channel->m_recvMsgs.GrowToFit(MaxMsgId(src, count), true);
+    const size_t size = MaxMsgId(src, count) + 1;
+    if (channel->m_recvMsgs.size() < size)
+        channel->m_recvMsgs.resize(size, {});
 
     for (const NetMsgInitRecv * term = src + count; src < term; ++src) {
         ASSERT(src->recv);
-        NetMsgInitRecv * const dst = &channel->m_recvMsgs[src[0].msg->messageId];
+        NetMsgRecvDecoder * const dst = &channel->m_recvMsgs[src[0].msg->messageId];
 
         // check to ensure that the message id isn't already used
-        ASSERT(!dst->msg);
+        ASSERT(!dst->init.msg);
 
         // copy the message handler
-        *dst = *src;
+        dst->init = *src;
 
-        const uint32_t bytes = ValidateMsg(*dst->msg);
+        const uint32_t bytes = ValidateMsg(*dst->init.msg);
         channel->m_largestRecv = std::max(channel->m_largestRecv, bytes);
+
+        CompileRecvMsg(dst);
     }
 }
 
@@ -322,17 +402,17 @@ void NetMsgChannelUnlock (
 }
 
 //============================================================================
-const NetMsgInitRecv * NetMsgChannelFindRecvMessage (
+const NetMsgRecvDecoder * NetMsgChannelFindRecvMessage (
     NetMsgChannel * channel,
     unsigned        messageId
 ) {
     // Is message in range?
-    if (messageId >= channel->m_recvMsgs.Count())
+    if (messageId >= channel->m_recvMsgs.size())
         return nil;
 
     // Is message defined?
-    const NetMsgInitRecv * recvMsg = &channel->m_recvMsgs[messageId];
-    if (!recvMsg->msg->count)
+    const NetMsgRecvDecoder * recvMsg = &channel->m_recvMsgs[messageId];
+    if (!recvMsg->init.msg || !recvMsg->init.msg->count)
         return nil;
 
     // Success!
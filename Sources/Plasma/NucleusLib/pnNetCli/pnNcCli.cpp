@@ -127,8 +127,8 @@ struct NetCli {
     NetCliQueue *           queue;
 
     // message send/recv
-    const NetMsgInitRecv *  recvMsg;
-    const NetMsgField *     recvField;
+    const NetMsgRecvDecoder * recvMsg;
+    const NetMsgDecodeStep *  recvStep;
     unsigned                recvFieldBytes;
     bool                    recvDispatch;
     uint8_t *               sendCurr;       // points into sendBuffer
@@ -148,7 +148,7 @@ struct NetCli {
 
     NetCli()
         : sock(nil), protocol((ENetProtocol)0), channel(nil), server(false)
-        , queue(nil), recvMsg(nil), recvField(nil), recvFieldBytes(0)
+        , queue(nil), recvMsg(nil), recvStep(nil), recvFieldBytes(0)
         , recvDispatch(false), sendCurr(nil), mode((ENetCliMode)0)
         , encryptFcn(nil), cryptIn(nil), cryptOut(nil), encryptParam(nil)
     {
@@ -181,10 +181,12 @@ namespace pnNetCli {
 ***/
 
 //============================================================================
-static void PutBufferOnWire (NetCli * cli, void * data, unsigned bytes) {
-
-    uint8_t * temp = NULL;
+static inline bool IsEncrypting (const NetCli * cli) {
+    return cli->mode == kNetCliModeEncrypted && cli->cryptOut;
+}
 
+//============================================================================
+static void LogBufferOnWire (NetCli * cli, const void * data, unsigned bytes) {
 #if !defined(PLASMA_EXTERNAL_RELEASE) && defined(HS_BUILD_FOR_WIN32)
     // Write to the netlog
     if (s_netlog) {
@@ -200,19 +202,19 @@ static void PutBufferOnWire (NetCli * cli, void * data, unsigned bytes) {
         WriteFile(s_netlog, data, bytes, &bytesWritten, NULL);
     }
 #endif // PLASMA_EXTERNAL_RELEASE
+}
 
-    if (cli->mode == kNetCliModeEncrypted && cli->cryptOut) {
-        temp = (uint8_t *)malloc(bytes);
-
-        memcpy(temp, data, bytes);
-        CryptEncrypt(cli->cryptOut, bytes, temp);
-        data = temp;
-    }
+//============================================================================
+// The data is encrypted in place, so it must be a buffer owned by the
+// connection. AsyncSocketSend copies whatever the socket can't take right
+// away, so the buffer may be refilled as soon as this returns.
+static void PutBufferOnWire (NetCli * cli, uint8_t * data, unsigned bytes) {
+    LogBufferOnWire(cli, data, bytes);
+
+    if (IsEncrypting(cli))
+        CryptEncrypt(cli->cryptOut, bytes, data);
     if (cli->sock)
         AsyncSocketSend(cli->sock, data, bytes);
-        
-    // free heap buffer (if any)
-    free(temp);
 }
 
 //============================================================================
@@ -231,36 +233,38 @@ static void AddToSendBuffer (
 ) {
     uint8_t const * src = (uint8_t const *) data;
 
-    if (bytes > std::size(cli->sendBuffer)) {
-        // Let the OS fragment oversize buffers
+    if (bytes > std::size(cli->sendBuffer) && !IsEncrypting(cli)) {
+        // Let the OS fragment oversize buffers; plaintext goes out
+        // straight from the caller's memory
         FlushSendBuffer(cli);
-        void * heap = malloc(bytes);
-        memcpy(heap, data, bytes);
-        PutBufferOnWire(cli, heap, bytes);
-        free(heap);
+        LogBufferOnWire(cli, src, bytes);
+        if (cli->sock)
+            AsyncSocketSend(cli->sock, src, bytes);
+        return;
     }
-    else {
-        for (;;) {
-            // calculate the space left in the output buffer and use it
-            // to determine the maximum number of bytes that will fit
-            unsigned const left = &cli->sendBuffer[std::size(cli->sendBuffer)] - cli->sendCurr;
-            unsigned const copy = std::min(bytes, left);
-
-            // copy the data into the buffer
-            for (unsigned i = 0; i < copy; ++i)
-                cli->sendCurr[i] = src[i];
-            cli->sendCurr += copy;
-            ASSERT(cli->sendCurr - cli->sendBuffer <= sizeof(cli->sendBuffer));
-
-            // if we copied all the data then bail
-            if (copy < left)
-                break;
 
-            src   += copy;
-            bytes -= copy;
+    // Everything else is staged in the send buffer, where it can be
+    // encrypted in place; oversize encrypted data goes out in
+    // buffer-sized pieces, which the stream cipher doesn't mind.
+    for (;;) {
+        // calculate the space left in the output buffer and use it
+        // to determine the maximum number of bytes that will fit
+        unsigned const left = &cli->sendBuffer[std::size(cli->sendBuffer)] - cli->sendCurr;
+        unsigned const copy = std::min(bytes, left);
+
+        // copy the data into the buffer
+        memcpy(cli->sendCurr, src, copy);
+        cli->sendCurr += copy;
+        ASSERT(cli->sendCurr - cli->sendBuffer <= sizeof(cli->sendBuffer));
+
+        // if we copied all the data then bail
+        if (copy < left)
+            break;
 
-            FlushSendBuffer(cli);
-        }
+        src   += copy;
+        bytes -= copy;
+
+        FlushSendBuffer(cli);
     }
 }
 
@@ -302,7 +306,9 @@ static void BufferedSendData (
             case kNetMsgFieldInteger: {
                 const unsigned count = cmd->count ? cmd->count : 1;
                 const unsigned bytes = cmd->size * count;
-                void * temp = malloc(bytes);
+                // single values are converted on the stack
+                uint64_t value;
+                void * temp = (count == 1) ? &value : malloc(bytes);
                 
                 if (count == 1)
                 {
@@ -336,7 +342,8 @@ static void BufferedSendData (
                 // Write values to send buffer
                 AddToSendBuffer(cli, bytes, temp);
 
-                free(temp);
+                if (temp != &value)
+                    free(temp);
             }
             break;
 
@@ -410,6 +417,49 @@ static void BufferedSendData (
         cli->queue->list.Link(cli);
 }
 
+//===========================================================================
+// Only big-endian hosts have any swaps to do; see CompileRecvMsg
+static void SwapIntegers (
+    const NetMsgRecvDecoder *   decoder,
+    const NetMsgDecodeStep &    step,
+    uint8_t                     data[]
+) {
+    for (uint32_t i = step.swapBegin; i < step.swapEnd; ++i) {
+        const NetMsgDecodeSwap & swap = decoder->swaps[i];
+        uint8_t * elem = data + swap.offset;
+
+        // fields are packed, so elements may not be aligned
+        switch (swap.size) {
+            case sizeof(uint16_t):
+                for (uint32_t j = 0; j < swap.count; ++j, elem += sizeof(uint16_t)) {
+                    uint16_t value;
+                    memcpy(&value, elem, sizeof(value));
+                    value = hsSwapEndian16(value);
+                    memcpy(elem, &value, sizeof(value));
+                }
+            break;
+
+            case sizeof(uint32_t):
+                for (uint32_t j = 0; j < swap.count; ++j, elem += sizeof(uint32_t)) {
+                    uint32_t value;
+                    memcpy(&value, elem, sizeof(value));
+                    value = hsSwapEndian32(value);
+                    memcpy(elem, &value, sizeof(value));
+                }
+            break;
+
+            case sizeof(uint64_t):
+                for (uint32_t j = 0; j < swap.count; ++j, elem += sizeof(uint64_t)) {
+                    uint64_t value;
+                    memcpy(&value, elem, sizeof(value));
+                    value = hsSwapEndian64(value);
+                    memcpy(elem, &value, sizeof(value));
+                }
+            break;
+        }
+    }
+}
+
 //===========================================================================
 static bool DispatchData (NetCli * cli, void * param) {
 
@@ -426,12 +476,13 @@ static bool DispatchData (NetCli * cli, void * param) {
             if (nil == (cli->recvMsg = NetMsgChannelFindRecvMessage(cli->channel, msgId)))
                 goto ERR_NO_HANDLER;
 
-            // prepare to start decompressing new fields
-            ASSERT(!cli->recvField);
+            // prepare to start decompressing new fields; everything but
+            // var data fits in a single reservation
+            ASSERT(!cli->recvStep);
             ASSERT(!cli->recvFieldBytes);
-            cli->recvField = cli->recvMsg->msg->fields;
+            cli->recvStep = cli->recvMsg->steps.data();
             cli->recvBuffer.ZeroCount();
-            cli->recvBuffer.Reserve(kAsyncSocketBufferSize);
+            cli->recvBuffer.Reserve(std::max<unsigned>(kAsyncSocketBufferSize, sizeof(uint32_t) + cli->recvMsg->fixedBytes));
 
             // store the message id as uint32_t into the destination buffer
             uint32_t * recvMsgId = (uint32_t *) cli->recvBuffer.New(sizeof(uint32_t));
@@ -439,94 +490,34 @@ static bool DispatchData (NetCli * cli, void * param) {
         }
 
         for (
-            const NetMsgField * end = cli->recvMsg->msg->fields + cli->recvMsg->msg->count;
-            cli->recvField < end;
-            ++cli->recvField
+            const NetMsgDecodeStep * end = cli->recvMsg->steps.data() + cli->recvMsg->steps.size();
+            cli->recvStep < end;
+            ++cli->recvStep
         ) {
-            switch (cli->recvField->type) {
-                case kNetMsgFieldInteger: {
-                    const unsigned count
-                        = cli->recvField->count
-                        ? cli->recvField->count
-                        : 1;
-
-                    // Get integer values
-                    const unsigned bytes = count * cli->recvField->size;
-                    uint8_t * data = cli->recvBuffer.New(bytes);
-                    if (!cli->input.Get(bytes, data)) {
-                        cli->recvBuffer.ShrinkBy(bytes);
-                        goto NEED_MORE_DATA;
-                    }
-
-                    // byte-swap integers
-                    // This is so screwed up >.<
-                    for (size_t i = 0; i < count; i++) {
-                        if (cli->recvField->size == sizeof(uint16_t)) {
-                            ((uint16_t*)data)[i] = hsToLE16(((uint16_t*)data)[i]);
-                        } else if (cli->recvField->size == sizeof(uint32_t)) {
-                            ((uint32_t*)data)[i] = hsToLE32(((uint32_t*)data)[i]);
-                        } else if (cli->recvField->size == sizeof(uint64_t)) {
-                            ((uint64_t*)data)[i] = hsToLE64(((uint64_t*)data)[i]);
-                        }
-                    }
-
-                    // Field complete
-                }
-                break;
-
-                case kNetMsgFieldReal: {
-                    const unsigned count
-                        = cli->recvField->count
-                        ? cli->recvField->count
-                        : 1;
-
-                    // Get float values
-                    const unsigned bytes = count * cli->recvField->size;
-                    uint8_t * data = cli->recvBuffer.New(bytes);
-                    if (!cli->input.Get(bytes, data)) {
-                        cli->recvBuffer.ShrinkBy(bytes);
-                        goto NEED_MORE_DATA;
-                    }
-
-                    // Field complete
-                }
-                break;
-
-                case kNetMsgFieldData:
-                case kNetMsgFieldRawData: {
-                    // Read fixed-length data into destination buffer
-                    const unsigned bytes = cli->recvField->count * cli->recvField->size;
-                    uint8_t * data = cli->recvBuffer.New(bytes);
-                    if (!cli->input.Get(bytes, data)) {
-                        cli->recvBuffer.ShrinkBy(bytes);
-                        goto NEED_MORE_DATA;
-                    }
-
-                    // Field complete
-                }
-                break;
-
-                case kNetMsgFieldVarCount: {
-                    // Read var count field into destination buffer
-                    const unsigned bytes = sizeof(uint32_t);
-                    uint8_t * data = cli->recvBuffer.New(bytes);
-                    if (!cli->input.Get(bytes, data)) {
-                        cli->recvBuffer.ShrinkBy(bytes);
+            const NetMsgDecodeStep & step = *cli->recvStep;
+            switch (step.op) {
+                case kNetMsgDecodeFixed: {
+                    // Read the whole run of fixed-size fields at once
+                    uint8_t * data = cli->recvBuffer.New(step.bytes);
+                    if (!cli->input.Get(step.bytes, data)) {
+                        cli->recvBuffer.ShrinkBy(step.bytes);
                         goto NEED_MORE_DATA;
                     }
 
-                    // byte-swap value
-                    uint32_t val = hsToLE32(*(uint32_t*)data);
+                    SwapIntegers(cli->recvMsg, step, data);
 
                     // Prepare to read var-length field
-                    cli->recvFieldBytes = val * cli->recvField->size;
+                    if (step.varElemSize) {
+                        uint32_t count;
+                        memcpy(&count, data + step.bytes - sizeof(count), sizeof(count));
+                        cli->recvFieldBytes = hsToLE32(count) * step.varElemSize;
+                    }
 
-                    // Field complete
+                    // Fields complete
                 }
                 break;
 
-                case kNetMsgFieldVarPtr:
-                case kNetMsgFieldRawVarPtr: {
+                case kNetMsgDecodeVarData: {
                     // Read var-length data into destination buffer
                     const unsigned bytes = cli->recvFieldBytes;
                     uint8_t * data = cli->recvBuffer.New(bytes);
@@ -540,7 +531,7 @@ static bool DispatchData (NetCli * cli, void * param) {
                 }
                 break;
 
-                case kNetMsgFieldString: {
+                case kNetMsgDecodeString: {
                     if (!cli->recvFieldBytes) {
                         // Read string length
                         uint16_t length;
@@ -549,15 +540,14 @@ static bool DispatchData (NetCli * cli, void * param) {
                         cli->recvFieldBytes = hsToLE16(length) * sizeof(wchar_t);
 
                         // Validate size. Use >= instead of > to leave room for the NULL terminator.
-                        if (cli->recvFieldBytes >= cli->recvField->count * cli->recvField->size)
+                        if (cli->recvFieldBytes >= step.bytes)
                             goto ERR_BAD_COUNT;
                     }
 
-                    const unsigned bytes = cli->recvField->count * cli->recvField->size;
-                    uint8_t * data = cli->recvBuffer.New(bytes);
+                    uint8_t * data = cli->recvBuffer.New(step.bytes);
                     // Read compressed string data (less than full field length)
                     if (!cli->input.Get(cli->recvFieldBytes, data)) {
-                        cli->recvBuffer.ShrinkBy(bytes);
+                        cli->recvBuffer.ShrinkBy(step.bytes);
                         goto NEED_MORE_DATA;
                     }
 
@@ -574,13 +564,13 @@ static bool DispatchData (NetCli * cli, void * param) {
         }
 
         // dispatch message to handler function
-        NCCLI_LOG(kLogPerf, "pnNetCli: Dispatching. msg: {}. cli: {#x}", cli->recvMsg ? cli->recvMsg->msg->name : "(unknown)", (uintptr_t)cli);
-        if (!cli->recvMsg->recv(cli->recvBuffer.Ptr(), cli->recvBuffer.Count(), param))
+        NCCLI_LOG(kLogPerf, "pnNetCli: Dispatching. msg: {}. cli: {#x}", cli->recvMsg ? cli->recvMsg->init.msg->name : "(unknown)", (uintptr_t)cli);
+        if (!cli->recvMsg->init.recv(cli->recvBuffer.Ptr(), cli->recvBuffer.Count(), param))
             goto ERR_DISPATCH_FAILED;
         
         // prepare to start next message
         cli->recvMsg        = nil;
-        cli->recvField      = 0;
+        cli->recvStep       = nil;
         cli->recvFieldBytes = 0;
 
         // Release oversize message buffer
@@ -592,19 +582,19 @@ static bool DispatchData (NetCli * cli, void * param) {
 
 // these are used for convenience in setting breakpoints
 NEED_MORE_DATA:
-    NCCLI_LOG(kLogPerf, "pnNetCli: NEED_MORE_DATA. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->msg->name : "(unknown)", msgId, (uintptr_t)cli);
+    NCCLI_LOG(kLogPerf, "pnNetCli: NEED_MORE_DATA. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->init.msg->name : "(unknown)", msgId, (uintptr_t)cli);
     return true;
 
 ERR_BAD_COUNT:
-    LogMsg(kLogError, "pnNetCli: ERR_BAD_COUNT. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->msg->name : "(unknown)", msgId, (uintptr_t)cli);
+    LogMsg(kLogError, "pnNetCli: ERR_BAD_COUNT. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->init.msg->name : "(unknown)", msgId, (uintptr_t)cli);
     return false;
 
 ERR_NO_HANDLER:
-    LogMsg(kLogError, "pnNetCli: ERR_NO_HANDLER. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->msg->name : "(unknown)", msgId, (uintptr_t)cli);
+    LogMsg(kLogError, "pnNetCli: ERR_NO_HANDLER. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->init.msg->name : "(unknown)", msgId, (uintptr_t)cli);
     return false;
 
 ERR_DISPATCH_FAILED:
-    LogMsg(kLogError, "pnNetCli: ERR_DISPATCH_FAILED. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->msg->name : "(unknown)", msgId, (uintptr_t)cli);
+    LogMsg(kLogError, "pnNetCli: ERR_DISPATCH_FAILED. msg: {} ({}). cli: {#x}", cli->recvMsg ? cli->recvMsg->init.msg->name : "(unknown)", msgId, (uintptr_t)cli);
     return false;
 }
 
@@ -877,7 +867,7 @@ static unsigned DispatchPacket (
 //===========================================================================
 static void ResetSendRecv (NetCli * cli) {
     cli->recvMsg            = nil;
-    cli->recvField          = nil;
+    cli->recvStep           = nil;
     cli->recvFieldBytes     = 0;
     cli->recvDispatch       = true;
     cli->sendCurr           = cli->sendBuffer;
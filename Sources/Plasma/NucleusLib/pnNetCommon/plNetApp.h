@@ -201,6 +201,7 @@ public:
         kDemoMode,                          // set if this is a demo - limited play
         kNeedInitialAgeStateCount,          // the server must tell us how many age states to expect
         kLinkingToOfflineAge,               // set if we're linking to the startup age
+        kSDLDeltaEncoding,                  // set if the game server accepts delta encoded SDL state
     };
 
     CLASSNAME_REGISTER(plNetClientApp);
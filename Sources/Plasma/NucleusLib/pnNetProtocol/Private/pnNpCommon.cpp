@@ -346,6 +346,7 @@ void NetVaultNode::Clear()
     fUsedFields = 0;
     fDirtyFields = 0;
     fRevision = kNilUuid;
+    IIndexKeysChanged();
 }
 
 //============================================================================
@@ -421,6 +422,8 @@ void NetVaultNode::CopyFrom(const NetVaultNode* node)
     COPYORZERO(Blob_2);
 
 #undef COPYORZERO
+
+    IIndexKeysChanged();
 }
 
 //============================================================================
@@ -557,6 +560,7 @@ void NetVaultNode::Read(const uint8_t* buf, size_t size)
 #undef READ
 
     fDirtyFields = 0;
+    IIndexKeysChanged();
 }
 
 //============================================================================
@@ -639,6 +643,19 @@ void NetVaultNode::Write(TArray<uint8_t>* buf, uint32_t ioFlags)
         fDirtyFields = 0;
 }
 
+//============================================================================
+NetVaultNode::IndexKeys NetVaultNode::GetIndexKeys() const
+{
+    IndexKeys keys;
+    keys.nodeType = (fUsedFields & kNodeType) ? fNodeType : 0;
+    keys.creatorId = (fUsedFields & kCreatorId) ? fCreatorId : 0;
+    if (fUsedFields & kString64_1)
+        keys.string64_1 = fString64_1;
+    if (fUsedFields & kUuid_1)
+        keys.uuid_1 = fUuid_1;
+    return keys;
+}
+
 //============================================================================
 void NetVaultNode::ISetVaultBlob(uint64_t bits, NetVaultNode::Blob& blob, const uint8_t* buf, size_t size)
 {
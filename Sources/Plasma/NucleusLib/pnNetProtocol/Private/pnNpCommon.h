@@ -196,7 +196,9 @@ protected:
                         kInt32_4 | kUInt32_1 | kUInt32_2 | kUInt32_3 | kUInt32_3 | kUInt32_4 |
                         kUuid_1 | kUuid_2 | kUuid_3 | kUuid_4 | kString64_1 | kString64_2 |
                         kString64_3 | kString64_4 | kString64_5 | kString64_6 | kIString64_1 |
-                        kIString64_2 | kText_1 | kText_2 | kBlob_1 | kBlob_2)
+                        kIString64_2 | kText_1 | kText_2 | kBlob_1 | kBlob_2),
+
+        kIndexFields = (kNodeType | kCreatorId | kString64_1 | kUuid_1)
     };
 
 public:
@@ -266,6 +268,8 @@ private:
         field = value;
         fUsedFields |= bits;
         fDirtyFields |= bits;
+        if (bits & kIndexFields)
+            IIndexKeysChanged();
     }
 
     template<typename T>
@@ -273,10 +277,16 @@ private:
     {
         field = value;
         fUsedFields |= bits;
+        if (bits & kIndexFields)
+            IIndexKeysChanged();
     }
 
     void ISetVaultBlob(uint64_t bits, Blob& blob, const uint8_t* buf, size_t size);
 
+protected:
+    /** Called after any of the fields in IndexKeys has been set, copied or cleared */
+    virtual void IIndexKeysChanged() { }
+
 public:
     enum IOFlags
     {
@@ -318,6 +328,16 @@ public:
     bool IsDirty() const { return fDirtyFields != 0; }
     bool IsUsed() const { return fUsedFields != 0; }
 
+    /** The fields the client vault indexes nodes by.  Unused ones are left zero or empty. */
+    struct IndexKeys
+    {
+        uint32_t nodeType;
+        uint32_t creatorId;
+        ST::string string64_1;
+        plUUID uuid_1;
+    };
+    IndexKeys GetIndexKeys() const;
+
     plUUID GetRevision() const { return fRevision; }
     void GenerateRevision() { fRevision = plUUID::Generate(); }
 
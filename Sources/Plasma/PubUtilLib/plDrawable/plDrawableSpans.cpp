@@ -102,6 +102,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plStatusLog/plStatusLog.h"
 
 #include <algorithm>
+#include <cstdlib>
 
 //// Local Konstants /////////////////////////////////////////////////////////
 
@@ -1535,13 +1536,13 @@ void    plDrawableSpans::SortSpan( uint32_t index, plPipeline *pipe )
     uint32_t              numTris;
     int                 i;
     hsMatrix44          w2cMatrix = pipe->GetWorldToCamera() * pipe->GetLocalToWorld();
-    float            dist;
 
     ICheckSpanForSortable(index);
 
-    static hsTArray<hsRadixSort::Elem>  sortList;
+    static hsTArray<float>              sortDepths;
+    static hsTArray<plGBufferTriangle>  sortedTris;
     static hsTArray<uint16_t>             tempTriList;
-    hsRadixSort::Elem                   *elem;
+    static hsRadixSortArray             rad;
 
 
     /// Get some stuff
@@ -1553,9 +1554,9 @@ void    plDrawableSpans::SortSpan( uint32_t index, plPipeline *pipe )
     hsAssert( numTris > 0, "How could we start sorting no triangles??" );
 
     /// Sort the triangles in "list"
-    sortList.SetCount( numTris );
+    sortDepths.SetCount( numTris );
+    sortedTris.SetCount( numTris );
     tempTriList.SetCount( numTris * 3 );
-    elem = sortList.AcquireArray();
 
     plProfile_EndLap(FaceSort, "0");
     plProfile_BeginLap(FaceSort, "1");
@@ -1563,34 +1564,29 @@ void    plDrawableSpans::SortSpan( uint32_t index, plPipeline *pipe )
     hsVector3 vec(w2cMatrix.fMap[2][0], w2cMatrix.fMap[2][1], w2cMatrix.fMap[2][2]);
     float trans = w2cMatrix.fMap[2][3];
 
-    // Fill out the radix sort elements with our data
+    float* depths = sortDepths.AcquireArray();
     for( i = 0; i < numTris; i++ )
-    {
-        dist = vec.InnerProduct(list[ i ].fCenter) + trans;
-        elem[ i ].fKey.fFloat = dist;
-        elem[ i ].fBody = &list[ i ];
-        elem[ i ].fNext = elem + i + 1;
-    }
-    elem[ i - 1 ].fNext = nil;
+        depths[ i ] = vec.InnerProduct(list[ i ].fCenter) + trans;
 
     plProfile_EndLap(FaceSort, "1");
     plProfile_BeginLap(FaceSort, "2");
 
-    // Do da sort thingy
-    hsRadixSort         rad;
-    hsRadixSort::Elem   *sortedList = rad.Sort( elem, 0 );
+    // Do da sort thingy. The list was left in last call's order, so unless
+    // the view has jumped around it should need little more than a check.
+    const uint32_t* order = rad.SortNearlySorted( depths, numTris );
 
     plProfile_EndLap(FaceSort, "2");
     plProfile_BeginLap(FaceSort, "3");
 
     uint16_t* indices = tempTriList.AcquireArray();
     // Stuff into the temp array
-    for( i = 0, elem = sortedList; i < numTris; i++ )
+    for( i = 0; i < numTris; i++ )
     {
-        *indices++ = ((plGBufferTriangle *)elem->fBody)->fIndex1;
-        *indices++ = ((plGBufferTriangle *)elem->fBody)->fIndex2;
-        *indices++ = ((plGBufferTriangle *)elem->fBody)->fIndex3;
-        elem = elem->fNext;
+        const plGBufferTriangle& tri = list[ order[ i ] ];
+        *indices++ = tri.fIndex1;
+        *indices++ = tri.fIndex2;
+        *indices++ = tri.fIndex3;
+        sortedTris[ i ] = tri;
     }
 
     plProfile_EndLap(FaceSort, "3");
@@ -1600,12 +1596,10 @@ void    plDrawableSpans::SortSpan( uint32_t index, plPipeline *pipe )
     fGroups[ span->fGroupIdx ]->StuffFromTriList( span->fIBufferIdx, span->fIStartIdx, 
                                                   numTris, tempTriList.AcquireArray() );
 
-    /// Optional step in a way: copy back our new, sorted list to our original
-    /// array. This lets us do less sorting next call, since the order should
-    /// remain largely unchanged from the last call. If this turns out NOT to
-    /// be the case, or if the sorting step takes less time than this copy,
-    /// take this out!
-//  memcpy( list, tempTriList.AcquireArray(), numTris * sizeof( plGBufferTriangle ) );
+    /// Copy back our new, sorted list to our original array. This lets us do
+    /// less sorting next call, since the order should remain largely unchanged
+    /// from the last call.
+    memcpy( list, sortedTris.AcquireArray(), numTris * sizeof( plGBufferTriangle ) );
 
     /// All done! (force buffer groups to refresh during next render call)
     fReadyToRender = false;
@@ -1821,10 +1815,14 @@ void plDrawableSpans::SortVisibleSpans(const hsTArray<int16_t>& visList, plPipel
 
     plProfile_BeginTiming(FaceSort);
 
-    static std::vector<hsRadixSort::Elem> sortScratch;
+    static std::vector<float> sortDepths;
+    static std::vector<plGBufferTriangle*> sortTris;
+    static std::vector<plGBufferTriangle> sortedTris;
     static std::vector<uint16_t> triList;
     static std::vector<int32_t> counters;
     static std::vector<uint32_t> startIndex;
+    static std::vector<uint32_t> chunkIndex;
+    static hsRadixSortArray rad;
     
     int i;
     
@@ -1861,6 +1859,7 @@ void plDrawableSpans::SortVisibleSpans(const hsTArray<int16_t>& visList, plPipel
     plProfile_BeginLap(FaceSort, "0");
 
     startIndex.resize(fSpans.GetCount());
+    chunkIndex.resize(fSpans.GetCount());
 
     // First figure out the total number of tris to deal with.
     int totTris = 0;
@@ -1884,11 +1883,11 @@ void plDrawableSpans::SortVisibleSpans(const hsTArray<int16_t>& visList, plPipel
 
     plProfile_IncCount(FacesSorted, totTris);
 
-    sortScratch.resize(totTris);
+    sortDepths.resize(totTris);
+    sortTris.resize(totTris);
+    sortedTris.resize(totTris);
     triList.resize(3 * totTris);
 
-    hsRadixSort::Elem* elem = sortScratch.data();
-
     plProfile_EndLap(FaceSort, "0");
 
     int iVis = 0;
@@ -1902,6 +1901,8 @@ void plDrawableSpans::SortVisibleSpans(const hsTArray<int16_t>& visList, plPipel
         // Oops, I already did.
         const int kTriCutoff = 4000;
         int cnt = 0;
+        int iFirst = iVis;
+        float* depths = sortDepths.data();
         while( (iVis < visList.GetCount()) && (cnt < kTriCutoff) )
         {
             plIcicle* span = (plIcicle*)fSpans[visList[iVis]];
@@ -1910,38 +1911,47 @@ void plDrawableSpans::SortVisibleSpans(const hsTArray<int16_t>& visList, plPipel
 
             hsPoint3 viewPos = span->fWorldToLocal * pipe->GetViewPositionWorld();
 
+            chunkIndex[visList[iVis]] = cnt;
+
             plGBufferTriangle*      list = span->fSortData;
             int j;
             for( j = 0; j < nTris; j++ )
             {
-                float dist = -(viewPos - list[j].fCenter).MagnitudeSquared();
-                elem[cnt].fKey.fFloat = dist;
-                elem[cnt].fBody = &list[j];
-                elem[cnt].fNext = elem + cnt + 1;
+                depths[cnt] = -(viewPos - list[j].fCenter).MagnitudeSquared();
+                sortTris[cnt] = &list[j];
 
                 cnt++;
             }
             iVis++;
         }
-        elem[cnt-1].fNext = nil;
 
         plProfile_EndLap(FaceSort, "1");
         plProfile_BeginLap(FaceSort, "2");
 
-        // Actual sort
-        hsRadixSort         rad;
-        hsRadixSort::Elem* sortedList = rad.Sort( elem, 0 );
+        // Actual sort. Spans are left in their own sorted order below, so
+        // a chunk that's all one span (a big water or foliage mesh, say)
+        // should be most of the way there already.
+        const uint32_t* order;
+        if( iVis - iFirst == 1 )
+            order = rad.SortNearlySorted( depths, cnt );
+        else
+            order = rad.Sort( depths, cnt );
 
         plProfile_EndLap(FaceSort, "2");
         plProfile_BeginLap(FaceSort, "3");
 
         counters.assign(fSpans.GetCount(), 0);
 
-        while( sortedList )
+        for( i = 0; i < cnt; i++ )
         {
-            plGBufferTriangle* data = (plGBufferTriangle*)sortedList->fBody;
+            plGBufferTriangle* data = sortTris[order[i]];
             plIcicle* span = (plIcicle*)fSpans[data->fSpanIndex];
 
+            // Counters step by 3 either way, so this is how many of the
+            // span's tris we've placed so far.
+            int32_t placed = std::abs(counters[data->fSpanIndex]) / 3;
+            sortedTris[chunkIndex[data->fSpanIndex] + placed] = *data;
+
             uint16_t* idx = &triList[startIndex[data->fSpanIndex] + counters[data->fSpanIndex]];
             *idx++ = data->fIndex1;
             *idx++ = data->fIndex2;
@@ -1950,8 +1960,13 @@ void plDrawableSpans::SortVisibleSpans(const hsTArray<int16_t>& visList, plPipel
                 counters[data->fSpanIndex] -= 3;
             else
                 counters[data->fSpanIndex] += 3;
-            
-            sortedList = sortedList->fNext;
+        }
+
+        // Leave each span's sort data in this frame's order for next time
+        for( i = iFirst; i < iVis; i++ )
+        {
+            plIcicle* span = (plIcicle*)fSpans[visList[i]];
+            memcpy(span->fSortData, &sortedTris[chunkIndex[visList[i]]], (span->fILength / 3) * sizeof(plGBufferTriangle));
         }
 
         plProfile_EndLap(FaceSort, "3");
@@ -1990,34 +2005,16 @@ void plDrawableSpans::SortVisibleSpans(const hsTArray<int16_t>& visList, plPipel
 #endif // MF_CHUNKSORT
 }
 
-struct buffTriCmpBackToFront
-{
-    hsPoint3 fViewPos;
-    buffTriCmpBackToFront(const hsPoint3& p) : fViewPos(p) {}
-
-    bool operator()( const plGBufferTriangle& lhs, const plGBufferTriangle& rhs) const
-    {
-        return hsVector3(&fViewPos, &lhs.fCenter).MagnitudeSquared() > hsVector3(&fViewPos, &rhs.fCenter).MagnitudeSquared();
-    }
-};
-
-struct buffTriCmpFrontToBack
-{
-    hsPoint3 fViewPos;
-    buffTriCmpFrontToBack(const hsPoint3& p) : fViewPos(p) {}
-
-    bool operator()( const plGBufferTriangle& lhs, const plGBufferTriangle& rhs) const
-    {
-        return hsVector3(&fViewPos, &lhs.fCenter).MagnitudeSquared() < hsVector3(&fViewPos, &rhs.fCenter).MagnitudeSquared();
-    }
-};
-
 void plDrawableSpans::SortVisibleSpansPartial(const hsTArray<int16_t>& visList, plPipeline* pipe)
 {
     plProfile_Inc(FaceSortCalls);
 
     plProfile_BeginTiming(FaceSort);
 
+    static std::vector<float> sortDepths;
+    static std::vector<plGBufferTriangle> sortedTris;
+    static hsRadixSortArray rad;
+
     int i;
     for( i = 0; i < visList.GetCount(); i++ )
     {
@@ -2033,8 +2030,18 @@ void plDrawableSpans::SortVisibleSpansPartial(const hsTArray<int16_t>& visList,
 
             const hsPoint3 viewPos = span->fWorldToLocal * pipe->GetViewPositionWorld();
 
+            // Sorting the sort data in place means it's nearly sorted already
+            // next time around.
             const int numTris = span->fILength/3;
-            std::sort(span->fSortData, span->fSortData+numTris, buffTriCmpBackToFront(viewPos));
+            sortDepths.resize(numTris);
+            sortedTris.resize(numTris);
+            for( int j = 0; j < numTris; j++ )
+                sortDepths[j] = -hsVector3(&viewPos, &span->fSortData[j].fCenter).MagnitudeSquared();
+
+            const uint32_t* order = rad.SortNearlySorted(sortDepths.data(), numTris);
+            for( int j = 0; j < numTris; j++ )
+                sortedTris[j] = span->fSortData[order[j]];
+            std::copy(sortedTris.begin(), sortedTris.end(), span->fSortData);
 
             uint16_t* idx = fGroups[span->fGroupIdx]->GetIndexBufferData(span->fIBufferIdx) + span->fIStartIdx;
             plGBufferTriangle* iter = span->fSortData;
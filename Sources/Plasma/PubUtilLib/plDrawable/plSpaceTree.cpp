@@ -55,6 +55,7 @@ static hsTArray<int16_t> scratchList;
 static hsTArray<hsRadixSort::Elem> scratchSort;
 
 plProfile_CreateCounter("Harvest Leaves", "Draw", HarvestLeaves);
+plProfile_CreateTimer("SpaceTree Update", "Draw", SpaceTreeUpdate);
 
 void plSpaceTreeNode::Read(hsStream* s)
 {
@@ -112,17 +113,369 @@ void plSpaceTree::IRefreshRecur(int16_t which)
             sub.fWorldBounds.Union(&fTree[sub.fChildren[0]].fWorldBounds);
         if( !(fTree[sub.fChildren[1]].fFlags & plSpaceTreeNode::kDisabled) )
             sub.fWorldBounds.Union(&fTree[sub.fChildren[1]].fWorldBounds);
+        IUpdateFlatBounds(which);
 
         sub.fFlags &= ~plSpaceTreeNode::kDirty;
     }
 }
 
+void plSpaceTree::IBuildFlatBounds()
+{
+    fFlatBounds.clear();
+    fFlatBounds.resize((fTree.GetCount() + 3) >> 2);
+
+    int i;
+    for( i = 0; i < fTree.GetCount(); i++ )
+        IUpdateFlatBounds(i);
+}
+
+void plSpaceTree::IUpdateFlatBounds(int16_t which)
+{
+    plSpaceTreeFlatBounds& block = fFlatBounds[which >> 2];
+    int lane = which & 3;
+
+    const hsBounds3Ext& bnd = fTree[which].fWorldBounds;
+    if( bnd.GetType() != kBoundsNormal )
+    {
+        for( int j = 0; j < 3; j++ )
+            block.fCenter[j][lane] = block.fExtent[j][lane] = 0;
+        return;
+    }
+
+    const hsPoint3& mins = bnd.GetMins();
+    const hsPoint3& maxs = bnd.GetMaxs();
+    for( int j = 0; j < 3; j++ )
+    {
+        block.fCenter[j][lane] = (maxs[j] + mins[j]) * 0.5f;
+        block.fExtent[j][lane] = (maxs[j] - mins[j]) * 0.5f;
+    }
+}
+
 void plSpaceTree::Refresh()
 {
     if( !IsEmpty() )
         IRefreshRecur(fRoot);
 }
 
+//////////////////////////////////////////////////////////////////////
+// Dynamic updates.
+// Inserting a leaf picks the sibling that grows the tree's total surface
+// area least, puts a new interior node above the two of them, and refits
+// back up to the root. Removing a leaf lifts its sibling into the parent's
+// place. On the way up, each node swaps a child with a grandchild if that
+// shrinks things (tree rotations), to keep the tree from degrading over
+// lots of inserts and removes.
+//
+// Leaves always occupy the first GetNumLeaves() slots with node index ==
+// leaf index, as plSpaceTreeMaker builds them, so interior nodes get moved
+// out of the way as needed.
+//////////////////////////////////////////////////////////////////////
+
+static float ISurfaceArea(const hsPoint3& mins, const hsPoint3& maxs)
+{
+    hsVector3 del(&maxs, &mins);
+    return del.fX * del.fY + del.fY * del.fZ + del.fZ * del.fX;
+}
+
+static float ISurfaceArea(const hsBounds3Ext& bnd)
+{
+    return bnd.GetType() == kBoundsNormal ? ISurfaceArea(bnd.GetMins(), bnd.GetMaxs()) : 0;
+}
+
+static float IUnionArea(const hsBounds3Ext& a, const hsBounds3Ext& b)
+{
+    if( a.GetType() != kBoundsNormal )
+        return ISurfaceArea(b);
+    if( b.GetType() != kBoundsNormal )
+        return ISurfaceArea(a);
+
+    hsPoint3 mins, maxs;
+    for( int i = 0; i < 3; i++ )
+    {
+        mins[i] = std::min(a.GetMins()[i], b.GetMins()[i]);
+        maxs[i] = std::max(a.GetMaxs()[i], b.GetMaxs()[i]);
+    }
+    return ISurfaceArea(mins, maxs);
+}
+
+int16_t plSpaceTree::IFindInsertSibling(const hsBounds3Ext& bnd) const
+{
+    int16_t idx = fRoot;
+    while( !fTree[idx].IsLeaf() )
+    {
+        const plSpaceTreeNode& node = fTree[idx];
+
+        float area = ISurfaceArea(node.fWorldBounds);
+        float combinedArea = IUnionArea(node.fWorldBounds, bnd);
+
+        // Cost of making a new parent for us and this node right here
+        float cost = 2.f * combinedArea;
+
+        // Cost every node below here pays for growing this one to fit us
+        float inheritCost = 2.f * (combinedArea - area);
+
+        float childCost[2];
+        for( int i = 0; i < 2; i++ )
+        {
+            const hsBounds3Ext& childBnd = fTree[node.fChildren[i]].fWorldBounds;
+            childCost[i] = IUnionArea(childBnd, bnd) + inheritCost;
+            if( !fTree[node.fChildren[i]].IsLeaf() )
+                childCost[i] -= ISurfaceArea(childBnd);
+        }
+
+        if( cost < childCost[0] && cost < childCost[1] )
+            break;
+
+        idx = childCost[0] < childCost[1] ? node.fChildren[0] : node.fChildren[1];
+    }
+    return idx;
+}
+
+void plSpaceTree::IMoveNode(int16_t from, int16_t to)
+{
+    fTree[to] = fTree[from];
+    plSpaceTreeNode& node = fTree[to];
+
+    if( node.fParent == kRootParent )
+        fRoot = to;
+    else
+    {
+        plSpaceTreeNode& parent = fTree[node.fParent];
+        if( parent.fChildren[0] == from )
+            parent.fChildren[0] = to;
+        else
+            parent.fChildren[1] = to;
+    }
+
+    if( node.fFlags & plSpaceTreeNode::kIsLeaf )
+        node.fLeafIndex = to;
+    else
+    {
+        fTree[node.fChildren[0]].fParent = to;
+        fTree[node.fChildren[1]].fParent = to;
+    }
+
+    IUpdateFlatBounds(to);
+}
+
+// Nothing may still refer to which
+void plSpaceTree::IFreeNode(int16_t which)
+{
+    int16_t last = fTree.GetCount() - 1;
+    if( which != last )
+        IMoveNode(last, which);
+    fTree.SetCount(last);
+}
+
+void plSpaceTree::IRefitNode(int16_t which)
+{
+    plSpaceTreeNode& sub = fTree[which];
+    const plSpaceTreeNode& child0 = fTree[sub.fChildren[0]];
+    const plSpaceTreeNode& child1 = fTree[sub.fChildren[1]];
+
+    sub.fWorldBounds.MakeEmpty();
+    if( !(child0.fFlags & plSpaceTreeNode::kDisabled) )
+        sub.fWorldBounds.Union(&child0.fWorldBounds);
+    if( !(child1.fFlags & plSpaceTreeNode::kDisabled) )
+        sub.fWorldBounds.Union(&child1.fWorldBounds);
+
+    if( child0.fFlags & child1.fFlags & plSpaceTreeNode::kDisabled )
+        sub.fFlags |= plSpaceTreeNode::kDisabled;
+    else
+        sub.fFlags &= ~plSpaceTreeNode::kDisabled;
+
+    IUpdateFlatBounds(which);
+}
+
+void plSpaceTree::IRotateNode(int16_t which)
+{
+    // Try swapping each child with each of its sibling's children, and keep
+    // whichever swap shrinks the sibling the most. Disabled nodes stay put,
+    // they don't contribute to the bounds anyway.
+    float bestSaving = 0;
+    int16_t bestChild = -1, bestOther = -1, bestGrandChild = -1;
+
+    for( int i = 0; i < 2; i++ )
+    {
+        int16_t child = fTree[which].fChildren[i];
+        int16_t other = fTree[which].fChildren[!i];
+        const plSpaceTreeNode& otherNode = fTree[other];
+        if( otherNode.IsLeaf() || (fTree[child].fFlags & plSpaceTreeNode::kDisabled) )
+            continue;
+
+        float area = ISurfaceArea(otherNode.fWorldBounds);
+        for( int j = 0; j < 2; j++ )
+        {
+            int16_t grandChild = otherNode.fChildren[j];
+            int16_t keep = otherNode.fChildren[!j];
+            if( fTree[grandChild].fFlags & plSpaceTreeNode::kDisabled )
+                continue;
+
+            float saving = area - IUnionArea(fTree[child].fWorldBounds, fTree[keep].fWorldBounds);
+            if( saving > bestSaving )
+            {
+                bestSaving = saving;
+                bestChild = child;
+                bestOther = other;
+                bestGrandChild = grandChild;
+            }
+        }
+    }
+
+    if( bestChild < 0 )
+        return;
+
+    plSpaceTreeNode& node = fTree[which];
+    node.fChildren[node.fChildren[0] == bestChild ? 0 : 1] = bestGrandChild;
+    fTree[bestGrandChild].fParent = which;
+
+    plSpaceTreeNode& otherNode = fTree[bestOther];
+    otherNode.fChildren[otherNode.fChildren[0] == bestGrandChild ? 0 : 1] = bestChild;
+    fTree[bestChild].fParent = bestOther;
+
+    IRefitNode(bestOther);
+}
+
+void plSpaceTree::IRefitUp(int16_t which)
+{
+    while( which != kRootParent )
+    {
+        IRotateNode(which);
+        IRefitNode(which);
+        which = fTree[which].fParent;
+    }
+}
+
+void plSpaceTree::IMakeEmpty()
+{
+    fTree.SetCount(1);
+    hsPoint3 zero;
+    fTree[0].fWorldBounds.Reset(&zero);
+    fTree[0].fFlags = plSpaceTreeNode::kEmpty;
+    fTree[0].fParent = kRootParent;
+    fRoot = 0;
+    fNumLeaves = 0;
+
+    IBuildFlatBounds();
+}
+
+int16_t plSpaceTree::InsertLeaf(const hsBounds3Ext& bnd, bool disabled)
+{
+    hsAssert(!fCache, "Can't restructure a space tree with a vis cache");
+    hsAssert(fTree.GetCount() < 0x7ffd, "Space tree is full");
+
+    plProfile_BeginTiming(SpaceTreeUpdate);
+
+    int16_t leafIdx = fNumLeaves;
+    uint16_t leafFlags = plSpaceTreeNode::kIsLeaf | (disabled ? plSpaceTreeNode::kDisabled : 0);
+
+    if( IsEmpty() )
+    {
+        // The empty tree's lone node just becomes our leaf
+        fTree[0].fWorldBounds = bnd;
+        fTree[0].fFlags = leafFlags;
+        fTree[0].fParent = kRootParent;
+        fTree[0].fLeafIndex = 0;
+        fNumLeaves = 1;
+        IUpdateFlatBounds(0);
+
+        plProfile_EndTiming(SpaceTreeUpdate);
+        return leafIdx;
+    }
+
+    // Bring the bounds we're going to search up to date
+    Refresh();
+
+    // Two new slots, one for the leaf and one for its new parent. The leaf's
+    // slot is right after the last leaf, so whatever interior node was there
+    // moves to the first new slot.
+    int16_t oldCount = fTree.GetCount();
+    fTree.Push();
+    fTree.Push();
+    fFlatBounds.resize((fTree.GetCount() + 3) >> 2);
+    if( leafIdx < oldCount )
+        IMoveNode(leafIdx, oldCount);
+    int16_t parentIdx = oldCount + 1;
+
+    int16_t sibling = IFindInsertSibling(bnd);
+    int16_t oldParent = fTree[sibling].fParent;
+
+    plSpaceTreeNode& leaf = fTree[leafIdx];
+    leaf.fWorldBounds = bnd;
+    leaf.fFlags = leafFlags;
+    leaf.fParent = parentIdx;
+    leaf.fLeafIndex = leafIdx;
+    IUpdateFlatBounds(leafIdx);
+
+    plSpaceTreeNode& parent = fTree[parentIdx];
+    parent.fFlags = plSpaceTreeNode::kNone;
+    parent.fParent = oldParent;
+    parent.fChildren[0] = sibling;
+    parent.fChildren[1] = leafIdx;
+    fTree[sibling].fParent = parentIdx;
+
+    if( oldParent == kRootParent )
+        fRoot = parentIdx;
+    else
+    {
+        plSpaceTreeNode& grand = fTree[oldParent];
+        grand.fChildren[grand.fChildren[0] == sibling ? 0 : 1] = parentIdx;
+    }
+
+    fNumLeaves++;
+    IRefitUp(parentIdx);
+
+    plProfile_EndTiming(SpaceTreeUpdate);
+    return leafIdx;
+}
+
+void plSpaceTree::RemoveLeaf(int16_t idx)
+{
+    hsAssert(!fCache, "Can't restructure a space tree with a vis cache");
+    hsAssert(idx >= 0 && idx < fNumLeaves, "Removing a bogus leaf");
+
+    plProfile_BeginTiming(SpaceTreeUpdate);
+
+    if( fNumLeaves == 1 )
+    {
+        IMakeEmpty();
+        plProfile_EndTiming(SpaceTreeUpdate);
+        return;
+    }
+
+    Refresh();
+
+    // Lift our sibling into our parent's place
+    int16_t parentIdx = fTree[idx].fParent;
+    const plSpaceTreeNode& parent = fTree[parentIdx];
+    int16_t sibling = parent.fChildren[0] == idx ? parent.fChildren[1] : parent.fChildren[0];
+    int16_t grandIdx = parent.fParent;
+
+    fTree[sibling].fParent = grandIdx;
+    if( grandIdx == kRootParent )
+        fRoot = sibling;
+    else
+    {
+        plSpaceTreeNode& grand = fTree[grandIdx];
+        grand.fChildren[grand.fChildren[0] == parentIdx ? 0 : 1] = sibling;
+        IRefitUp(grandIdx);
+    }
+
+    // Now nobody refers to our slot or our parent's. Slide the later leaves
+    // down over ours, then give the two free slots back.
+    int16_t i;
+    for( i = idx + 1; i < fNumLeaves; i++ )
+        IMoveNode(i, i - 1);
+    fNumLeaves--;
+
+    // Our parent was an interior node, so it's past all the leaves
+    IFreeNode(parentIdx);
+    IFreeNode(fNumLeaves);
+    fFlatBounds.resize((fTree.GetCount() + 3) >> 2);
+
+    plProfile_EndTiming(SpaceTreeUpdate);
+}
+
 void plSpaceTree::SetTreeFlag(uint16_t f, bool on)
 {
     if( IsEmpty() )
@@ -326,6 +679,7 @@ void plSpaceTree::MoveLeaf(int16_t idx, const hsBounds3Ext& bnd)
     hsAssert(idx == fTree[idx].fLeafIndex, "Some scrambling of indices");
 
     fTree[idx].fWorldBounds = bnd;
+    IUpdateFlatBounds(idx);
 
     while( idx != kRootParent )
     {
@@ -556,6 +910,8 @@ void plSpaceTree::Read(hsStream* s, hsResMgr* mgr)
     int i;
     for( i = 0; i < n; i++ )
         fTree[i].Read(s);
+
+    IBuildFlatBounds();
 }
 
 void plSpaceTree::Write(hsStream* s, hsResMgr* mgr)
@@ -48,6 +48,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "pnFactory/plCreatable.h"
 #include "hsBitVector.h"
 
+#include <vector>
+
 class hsStream;
 class hsResMgr;
 class plVolumeIsect;
@@ -86,6 +88,17 @@ public:
 };
 
 
+// Copy of the node bounds as center and half-extent, four nodes to a block
+// laid out so one SIMD register holds the same component for all four.
+// Node i lives in block i >> 2, lane i & 3. Lets the cullers test several
+// nodes against a plane at once without touching the (much fatter) nodes.
+// Nodes whose bounds aren't kBoundsNormal are left zeroed here.
+struct alignas(16) plSpaceTreeFlatBounds
+{
+    float   fCenter[3][4];
+    float   fExtent[3][4];
+};
+
 class plSpaceTree : public plCreatable
 {
 public:
@@ -99,6 +112,7 @@ public:
     };
 private:
     hsTArray<plSpaceTreeNode>       fTree;
+    std::vector<plSpaceTreeFlatBounds> fFlatBounds;
     const hsBitVector*              fCache;
 
     int16_t                           fRoot;
@@ -111,6 +125,18 @@ private:
     hsPoint3                        fViewPos;
 
     void        IRefreshRecur(int16_t which);
+
+    void        IBuildFlatBounds();
+    void        IUpdateFlatBounds(int16_t which);
+
+    // Dynamic updates
+    int16_t     IFindInsertSibling(const hsBounds3Ext& bnd) const;
+    void        IMoveNode(int16_t from, int16_t to);
+    void        IFreeNode(int16_t which);
+    void        IRefitNode(int16_t which);
+    void        IRotateNode(int16_t which);
+    void        IRefitUp(int16_t which);
+    void        IMakeEmpty();
     
     void        IHarvestAndCullLeaves(const plSpaceTreeNode& subRoot, hsTArray<int16_t>& list) const;
     void        IHarvestLeaves(const plSpaceTreeNode& subRoot, hsTArray<int16_t>& list) const;
@@ -140,6 +166,7 @@ public:
     int16_t                   GetRoot() const { return fRoot; }
     bool                    IsRoot(int16_t w) const { return fRoot == w; }
     bool                    IsLeaf(int16_t w) const { return GetNode(w).IsLeaf(); }
+    const plSpaceTreeFlatBounds* GetFlatBounds() const { return fFlatBounds.data(); }
 
     void HarvestLeaves(hsBitVector& totList, hsBitVector& list) const;
     void HarvestLeaves(hsBitVector& list) const;
@@ -174,6 +201,13 @@ public:
 
     void MoveLeaf(int16_t idx, const hsBounds3Ext& newWorldBnd);
     void Refresh();
+
+    // Add or remove a leaf without rebuilding the tree. InsertLeaf() appends,
+    // returning the new leaf's index (always the old GetNumLeaves()).
+    // RemoveLeaf() shifts every later leaf down one, the same as erasing from
+    // the owner's list. Not for trees being harvested with a cache (SetCache()).
+    int16_t InsertLeaf(const hsBounds3Ext& worldBnd, bool disabled=false);
+    void    RemoveLeaf(int16_t idx);
     bool IsEmpty() const { return 0 != (GetNode(GetRoot()).fFlags & plSpaceTreeNode::kEmpty); }
     bool IsDirty() const { return 0 != (GetNode(GetRoot()).fFlags & plSpaceTreeNode::kDirty); }
     void MakeDirty() { fTree[GetRoot()].fFlags |= plSpaceTreeNode::kDirty; }
@@ -558,6 +558,8 @@ plSpaceTree* plSpaceTreeMaker::IMakeEmptyTree()
 
     Cleanup();
 
+    tree->IBuildFlatBounds();
+
     return tree;
 }
 
@@ -579,6 +581,8 @@ plSpaceTree* plSpaceTreeMaker::IMakeDegenerateTree()
 
     Cleanup();
 
+    tree->IBuildFlatBounds();
+
     return tree;
 }
 
@@ -624,6 +628,8 @@ plSpaceTree* plSpaceTreeMaker::IMakeSpaceTree()
 
     StopTimer(kMakeSpaceTree);
 
+    tree->IBuildFlatBounds();
+
     return tree;
 }
 
@@ -0,0 +1,328 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include "HeadSpin.h"
+#include "plLightGrid.h"
+
+#include "hsBounds.h"
+#include "plLightInfo.h"
+
+#include <algorithm>
+
+plLightGrid::plLightGrid()
+:   fStamp(0)
+{
+    Reset();
+}
+
+void plLightGrid::Reset()
+{
+    fLights.clear();
+    fUnbinned.clear();
+    fCellStarts.clear();
+    fCellLights.clear();
+
+    int i;
+    for( i = 0; i < 3; i++ )
+    {
+        fOrigin[i] = 0;
+        fInvCellSize[i] = 0;
+        fRes[i] = 1;
+    }
+}
+
+void plLightGrid::AddLight(plLightInfo* light, bool vis)
+{
+    LightEntry entry;
+    entry.fLight = light;
+    entry.fVis = vis;
+
+    // This is also where each light gets refreshed for the render, so
+    // the per-span Refresh() calls later on find it already clean.
+    light->Refresh();
+
+    hsBounds3Ext bnd;
+    entry.fBounded = light->GetInfluenceBounds(bnd) && (bnd.GetType() == kBoundsNormal);
+    int i;
+    for( i = 0; i < 3; i++ )
+    {
+        entry.fMins[i] = entry.fBounded ? bnd.GetMins()[i] : 0;
+        entry.fMaxs[i] = entry.fBounded ? bnd.GetMaxs()[i] : 0;
+    }
+
+    fLights.push_back(entry);
+}
+
+void plLightGrid::ICellRange(const float* mins, const float* maxs, int* lo, int* hi) const
+{
+    int i;
+    for( i = 0; i < 3; i++ )
+    {
+        float a = (mins[i] - fOrigin[i]) * fInvCellSize[i];
+        float b = (maxs[i] - fOrigin[i]) * fInvCellSize[i];
+        lo[i] = a <= 0 ? 0 : (a >= fRes[i] - 1 ? fRes[i] - 1 : int(a));
+        hi[i] = b <= 0 ? 0 : (b >= fRes[i] - 1 ? fRes[i] - 1 : int(b));
+    }
+}
+
+void plLightGrid::Build()
+{
+    uint32_t numLights = uint32_t(fLights.size());
+
+    fStamps.assign(numLights, 0);
+    fStamp = 0;
+
+    // Size the grid to the world the bounded lights cover, with cells
+    // about as big as the average light.
+    float mins[3], maxs[3], avg[3];
+    uint32_t numBounded = 0;
+    uint32_t i;
+    int j;
+    for( i = 0; i < numLights; i++ )
+    {
+        const LightEntry& entry = fLights[i];
+        if( !entry.fBounded )
+            continue;
+        for( j = 0; j < 3; j++ )
+        {
+            if( !numBounded || (entry.fMins[j] < mins[j]) )
+                mins[j] = entry.fMins[j];
+            if( !numBounded || (entry.fMaxs[j] > maxs[j]) )
+                maxs[j] = entry.fMaxs[j];
+            avg[j] = (numBounded ? avg[j] : 0) + entry.fMaxs[j] - entry.fMins[j];
+        }
+        numBounded++;
+    }
+
+    if( numBounded < kMinGridLights )
+    {
+        for( i = 0; i < numLights; i++ )
+            fUnbinned.push_back(i);
+        return;
+    }
+
+    int numCells = 1;
+    for( j = 0; j < 3; j++ )
+    {
+        float size = maxs[j] - mins[j];
+        avg[j] /= float(numBounded);
+
+        fRes[j] = 1;
+        if( (size > 0) && (avg[j] > 0) )
+        {
+            float res = size / avg[j];
+            fRes[j] = res >= kMaxRes ? kMaxRes : (res <= 1.f ? 1 : int(res));
+        }
+        numCells *= fRes[j];
+    }
+    // Don't let the cells get way out of proportion to the lights in them.
+    while( numCells > int(numBounded * kCellsPerLight) )
+    {
+        int big = 0;
+        for( j = 1; j < 3; j++ )
+        {
+            if( fRes[j] > fRes[big] )
+                big = j;
+        }
+        numCells /= fRes[big];
+        fRes[big] = (fRes[big] + 1) / 2;
+        numCells *= fRes[big];
+    }
+    for( j = 0; j < 3; j++ )
+    {
+        float size = maxs[j] - mins[j];
+        fOrigin[j] = mins[j];
+        fInvCellSize[j] = size > 0 ? float(fRes[j]) / size : 0;
+    }
+
+    // Count up how many lights land in each cell, then lay the runs out
+    // end to end and go back through to fill them in.
+    fCellStarts.assign(numCells + 1, 0);
+    int lo[3], hi[3];
+    for( i = 0; i < numLights; i++ )
+    {
+        LightEntry& entry = fLights[i];
+        if( !entry.fBounded )
+        {
+            fUnbinned.push_back(i);
+            continue;
+        }
+
+        ICellRange(entry.fMins, entry.fMaxs, lo, hi);
+
+        // Something covering most of the world would just be copied into
+        // most of the cells. It'll get checked for every search anyway.
+        int covered = (hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+        if( (numCells > 1) && (covered * 2 > numCells) )
+        {
+            fUnbinned.push_back(i);
+            continue;
+        }
+
+        int x, y, z;
+        for( z = lo[2]; z <= hi[2]; z++ )
+        {
+            for( y = lo[1]; y <= hi[1]; y++ )
+            {
+                for( x = lo[0]; x <= hi[0]; x++ )
+                    fCellStarts[(z * fRes[1] + y) * fRes[0] + x + 1]++;
+            }
+        }
+    }
+    for( j = 0; j < numCells; j++ )
+        fCellStarts[j + 1] += fCellStarts[j];
+
+    fCellLights.resize(fCellStarts[numCells]);
+    std::vector<uint32_t> fill(fCellStarts.begin(), fCellStarts.end() - 1);
+    for( i = 0; i < numLights; i++ )
+    {
+        const LightEntry& entry = fLights[i];
+        if( !entry.fBounded )
+            continue;
+
+        ICellRange(entry.fMins, entry.fMaxs, lo, hi);
+        int covered = (hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+        if( (numCells > 1) && (covered * 2 > numCells) )
+            continue;
+
+        int x, y, z;
+        for( z = lo[2]; z <= hi[2]; z++ )
+        {
+            for( y = lo[1]; y <= hi[1]; y++ )
+            {
+                for( x = lo[0]; x <= hi[0]; x++ )
+                    fCellLights[fill[(z * fRes[1] + y) * fRes[0] + x]++] = i;
+            }
+        }
+    }
+}
+
+bool plLightGrid::IOverlaps(const LightEntry& entry, const float* mins, const float* maxs) const
+{
+    if( !entry.fBounded )
+        return true;
+
+    int i;
+    for( i = 0; i < 3; i++ )
+    {
+        if( (entry.fMins[i] > maxs[i]) || (entry.fMaxs[i] < mins[i]) )
+            return false;
+    }
+    return true;
+}
+
+void plLightGrid::ITestLight(uint32_t idx, bool chars, const float* mins, const float* maxs)
+{
+    // A light big enough to span several cells shows up in each of them,
+    // so only look at it the first time this search runs into it.
+    if( fStamps[idx] == fStamp )
+        return;
+    fStamps[idx] = fStamp;
+
+    const LightEntry& entry = fLights[idx];
+    if( !chars && !entry.fVis )
+        return;
+    if( IOverlaps(entry, mins, maxs) )
+        fFound.push_back(idx);
+}
+
+void plLightGrid::Harvest(const hsBounds3Ext& bnd, bool chars, hsTArray<plLightInfo*>& lightList)
+{
+    uint32_t numLights = uint32_t(fLights.size());
+    uint32_t i;
+
+    // Nothing to bin an odd bounds by, so just hand back everything
+    // and let AffectsBound() sort it out.
+    if( bnd.GetType() != kBoundsNormal )
+    {
+        for( i = 0; i < numLights; i++ )
+        {
+            if( chars || fLights[i].fVis )
+                lightList.Append(fLights[i].fLight);
+        }
+        return;
+    }
+
+    if( !++fStamp )
+    {
+        std::fill(fStamps.begin(), fStamps.end(), 0);
+        fStamp = 1;
+    }
+
+    float mins[3], maxs[3];
+    int j;
+    for( j = 0; j < 3; j++ )
+    {
+        mins[j] = bnd.GetMins()[j];
+        maxs[j] = bnd.GetMaxs()[j];
+    }
+
+    fFound.clear();
+    for( i = 0; i < fUnbinned.size(); i++ )
+        ITestLight(fUnbinned[i], chars, mins, maxs);
+
+    if( !fCellStarts.empty() )
+    {
+        int lo[3], hi[3];
+        ICellRange(mins, maxs, lo, hi);
+
+        int x, y, z;
+        for( z = lo[2]; z <= hi[2]; z++ )
+        {
+            for( y = lo[1]; y <= hi[1]; y++ )
+            {
+                for( x = lo[0]; x <= hi[0]; x++ )
+                {
+                    int cell = (z * fRes[1] + y) * fRes[0] + x;
+                    uint32_t k;
+                    for( k = fCellStarts[cell]; k < fCellStarts[cell + 1]; k++ )
+                        ITestLight(fCellLights[k], chars, mins, maxs);
+                }
+            }
+        }
+    }
+
+    // Hand them back in the order they came in, same as walking the whole list would.
+    std::sort(fFound.begin(), fFound.end());
+    for( i = 0; i < fFound.size(); i++ )
+        lightList.Append(fLights[fFound[i]].fLight);
+}
@@ -0,0 +1,115 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#ifndef plLightGrid_inc
+#define plLightGrid_inc
+
+#include "hsTemplates.h"
+
+#include <vector>
+
+class hsBounds3Ext;
+class plLightInfo;
+
+// A uniform grid over the world bounds of the lights in the scene, so
+// finding the lights that might reach a drawable only looks at the lights
+// binned near it, instead of every light there is. Built once per render
+// from the lights the pipeline has picked out, then searched once per
+// drawable. Lights that reach everywhere (or cover most of the grid) are
+// kept off to the side and always come back as candidates.
+// The grid only narrows down the candidates, the caller still needs to
+// check AffectsBound() on what comes back.
+class plLightGrid
+{
+protected:
+    enum
+    {
+        kMaxRes         = 32,   // Cells per axis
+        kCellsPerLight  = 8,    // Keep total cells down to about this many per light
+        kMinGridLights  = 8     // Don't bother splitting space up for fewer than this
+    };
+
+    class LightEntry
+    {
+    public:
+        plLightInfo*    fLight;
+        float           fMins[3];
+        float           fMaxs[3];
+        bool            fBounded;
+        bool            fVis;
+    };
+
+    std::vector<LightEntry> fLights;
+    std::vector<uint32_t>   fUnbinned;      // Checked for every search
+    std::vector<uint32_t>   fCellStarts;    // Where each cell's run starts in fCellLights (one extra at the end)
+    std::vector<uint32_t>   fCellLights;
+    std::vector<uint32_t>   fStamps;        // Last search that looked at each light
+    std::vector<uint32_t>   fFound;
+    uint32_t                fStamp;
+
+    float                   fOrigin[3];
+    float                   fInvCellSize[3];
+    int                     fRes[3];
+
+    void    ICellRange(const float* mins, const float* maxs, int* lo, int* hi) const;
+    bool    IOverlaps(const LightEntry& entry, const float* mins, const float* maxs) const;
+    void    ITestLight(uint32_t idx, bool chars, const float* mins, const float* maxs);
+
+public:
+    plLightGrid();
+
+    // Empties the grid out, keeping the memory around for next time.
+    void    Reset();
+
+    // Lights come back out of a search in the order they were added.
+    // Vis lights are returned for every search, the rest only to
+    // searches for characters.
+    void    AddLight(plLightInfo* light, bool vis);
+    void    Build();
+
+    uint32_t GetNumLights() const { return uint32_t(fLights.size()); }
+
+    // Appends the lights whose influence might overlap bnd.
+    void    Harvest(const hsBounds3Ext& bnd, bool chars, hsTArray<plLightInfo*>& lightList);
+};
+
+#endif // plLightGrid_inc
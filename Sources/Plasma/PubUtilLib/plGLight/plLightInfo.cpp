@@ -647,6 +647,26 @@ void plLimitedDirLightInfo::GetStrengthAndScale(const hsBounds3Ext& bnd, float&
     plLightInfo::GetStrengthAndScale(bnd, strength, scale);
 }
 
+bool plLimitedDirLightInfo::GetInfluenceBounds(hsBounds3Ext& bnd)
+{
+    Refresh();
+
+    // The box between the parallel planes, out into world space.
+    int i;
+    for( i = 0; i < 8; i++ )
+    {
+        hsPoint3 corner((i & 1) ? fWidth * 0.5f : -fWidth * 0.5f,
+                        (i & 2) ? fHeight * 0.5f : -fHeight * 0.5f,
+                        (i & 4) ? -fDepth : 0);
+        corner = fLightToWorld * corner;
+        if( i )
+            bnd.Union(&corner);
+        else
+            bnd.Reset(&corner);
+    }
+    return true;
+}
+
 void plLimitedDirLightInfo::Read(hsStream* s, hsResMgr* mgr)
 {
     plDirectionalLightInfo::Read(s, mgr);
@@ -815,6 +835,23 @@ void plOmniLightInfo::IRefresh()
     }
 }
 
+bool plOmniLightInfo::GetInfluenceBounds(hsBounds3Ext& bnd)
+{
+    Refresh();
+
+    // Unattenuated, it lights the whole world.
+    if( !fSphere )
+        return false;
+
+    hsPoint3 pos = GetWorldPosition();
+    float rad = fSphere->GetRadius();
+    hsPoint3 corner(pos.fX - rad, pos.fY - rad, pos.fZ - rad);
+    bnd.Reset(&corner);
+    corner.Set(pos.fX + rad, pos.fY + rad, pos.fZ + rad);
+    bnd.Union(&corner);
+    return true;
+}
+
 hsVector3 plOmniLightInfo::GetNegativeWorldDirection(const hsPoint3& pos) const
 {
     hsPoint3 wpos = GetWorldPosition();
@@ -892,6 +929,30 @@ void plSpotLightInfo::GetStrengthAndScale(const hsBounds3Ext& bnd, float& streng
         strength *= (dot - cosOuter) / (cosInner - cosOuter);
 }
 
+bool plSpotLightInfo::GetInfluenceBounds(hsBounds3Ext& bnd)
+{
+    Refresh();
+
+    // An uncapped cone goes on forever.
+    float len = fCone ? fCone->GetLength() : 0;
+    if( len <= 0 )
+        return false;
+
+    // The capped cone fits in the sphere around the tip reaching out to the
+    // rim of the cap. Good enough to bin by, the cone test does the rest.
+    float cosOuter = cos(fCone->GetAngle());
+    if( cosOuter < 0.01f )
+        return false;
+    float rad = len / cosOuter;
+
+    hsPoint3 pos = GetWorldPosition();
+    hsPoint3 corner(pos.fX - rad, pos.fY - rad, pos.fZ - rad);
+    bnd.Reset(&corner);
+    corner.Set(pos.fX + rad, pos.fY + rad, pos.fZ + rad);
+    bnd.Union(&corner);
+    return true;
+}
+
 void plSpotLightInfo::IMakeIsect()
 {
     fCone = new plConeIsect;
@@ -186,6 +186,9 @@ public:
     virtual void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const;
 
     bool AffectsBound(const hsBounds3Ext& bnd) { return IGetIsect() ? IGetIsect()->Test(bnd) != kVolumeCulled : true; }
+    // World box around everything the light can reach (a superset of AffectsBound).
+    // Returns false if the light reaches everywhere.
+    virtual bool GetInfluenceBounds(hsBounds3Ext& bnd) { return false; }
     void GetAffectedForced(const plSpaceTree* space, hsBitVector& list, bool charac);
     void GetAffected(const plSpaceTree* space, hsBitVector& list, bool charac);
     const hsTArray<int16_t>& GetAffected(plSpaceTree* space, const hsTArray<int16_t>& visList, hsTArray<int16_t>& litList, bool charac);
@@ -292,6 +295,8 @@ public:
 
     virtual void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const;
 
+    virtual bool GetInfluenceBounds(hsBounds3Ext& bnd);
+
     float GetWidth() const { return fWidth; }
     float GetHeight() const { return fHeight; }
     float GetDepth() const { return fDepth; }
@@ -335,6 +340,8 @@ public:
 
     virtual hsVector3 GetNegativeWorldDirection(const hsPoint3& pos) const;
 
+    virtual bool GetInfluenceBounds(hsBounds3Ext& bnd);
+
     bool        IsAttenuated() const { return (fAttenLinear != 0)||(fAttenQuadratic != 0) || ( fAttenCutoff != 0 ); }
     float    GetRadius() const;
 
@@ -390,6 +397,8 @@ public:
 
     virtual void GetStrengthAndScale(const hsBounds3Ext& bnd, float& strength, float& scale) const;
 
+    virtual bool GetInfluenceBounds(hsBounds3Ext& bnd);
+
     hsVector3 GetWorldDirection() const;
     virtual hsVector3 GetNegativeWorldDirection(const hsPoint3& pos) const { return -GetWorldDirection(); }
 
@@ -43,6 +43,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "HeadSpin.h"
 #include "hsMemory.h"
 #include "hsRadixSort.h"
+#include "hsCpuID.h"
+
+#include <cstring>
+
+#ifdef HS_SIMD_INCLUDE
+#  include HS_SIMD_INCLUDE
+#endif
 
 hsRadixSort::hsRadixSort() : fList()
 {
@@ -179,3 +186,175 @@ hsRadixSort::Elem* hsRadixSort::Sort(Elem* inList, uint32_t flags)
 
     return fList;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// hsRadixSortArray
+
+// Flipping the sign bit of positive floats and all the bits of negative
+// ones gives unsigned ints that sort in the same order as the floats.
+static void IFloatsToKeys_fpu(const float* in, uint32_t* out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t bits;
+        memcpy(&bits, in + i, sizeof(bits));
+        out[i] = bits ^ (uint32_t(int32_t(bits) >> 31) | 0x80000000);
+    }
+}
+
+static void IFloatsToKeys_sse2(const float* in, uint32_t* out, uint32_t count)
+{
+    uint32_t i = 0;
+#ifdef HS_SSE2
+    const __m128i signBit = _mm_set1_epi32(0x80000000);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i bits = _mm_castps_si128(_mm_loadu_ps(in + i));
+        __m128i flip = _mm_or_si128(_mm_srai_epi32(bits, 31), signBit);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(bits, flip));
+    }
+#endif // HS_SSE2
+
+    if (i < count)
+        IFloatsToKeys_fpu(in + i, out + i, count - i);
+}
+
+typedef void(*floats_to_keys_ptr)(const float*, uint32_t*, uint32_t);
+static hsCpuFunctionDispatcher<floats_to_keys_ptr> IFloatsToKeys {
+    &IFloatsToKeys_fpu,
+    nullptr,            // SSE1
+    &IFloatsToKeys_sse2
+};
+
+// SortNearlySorted() gives up on the insertion sort once it's shifted
+// this many elements per key, or if more than 1 in kMaxDescents adjacent
+// pairs are out of order to begin with.
+static const uint32_t kMaxShiftsPerKey = 4;
+static const uint32_t kMaxDescents = 16;
+
+void hsRadixSortArray::ISetup(const float* keys, uint32_t count)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        fKeys[i].resize(count);
+        fOrder[i].resize(count);
+    }
+
+    IFloatsToKeys.call(keys, fKeys[0].data(), count);
+
+    uint32_t* order = fOrder[0].data();
+    for (uint32_t i = 0; i < count; i++)
+        order[i] = i;
+}
+
+bool hsRadixSortArray::IInsertionSort(uint32_t count)
+{
+    uint32_t* keys = fKeys[0].data();
+    uint32_t* order = fOrder[0].data();
+
+    uint32_t descents = 0;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        if (keys[i] < keys[i-1])
+            descents++;
+    }
+    if (!descents)
+        return true;
+    if (descents > count / kMaxDescents)
+        return false;
+
+    // Bailing out part way is fine, the keys and order still match up and
+    // equal keys are still in their original order for the radix sort.
+    uint32_t budget = count * kMaxShiftsPerKey;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint32_t key = keys[i];
+        if (key >= keys[i-1])
+            continue;
+
+        uint32_t idx = order[i];
+        uint32_t j = i;
+        do
+        {
+            if (!budget--)
+            {
+                keys[j] = key;
+                order[j] = idx;
+                return false;
+            }
+            keys[j] = keys[j-1];
+            order[j] = order[j-1];
+            --j;
+        } while (j > 0 && keys[j-1] > key);
+
+        keys[j] = key;
+        order[j] = idx;
+    }
+    return true;
+}
+
+const uint32_t* hsRadixSortArray::IRadixSort(uint32_t count)
+{
+    uint32_t counts[4][256];
+    memset(counts, 0, sizeof(counts));
+
+    const uint32_t* keys = fKeys[0].data();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t key = keys[i];
+        counts[0][key & 0xff]++;
+        counts[1][(key >> 8) & 0xff]++;
+        counts[2][(key >> 16) & 0xff]++;
+        counts[3][key >> 24]++;
+    }
+
+    int src = 0;
+    for (int pass = 0; pass < 4; pass++)
+    {
+        int shift = pass * 8;
+
+        // Every key has the same byte here, nothing to do.
+        if (counts[pass][(fKeys[src][0] >> shift) & 0xff] == count)
+            continue;
+
+        uint32_t offsets[256];
+        uint32_t total = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            offsets[i] = total;
+            total += counts[pass][i];
+        }
+
+        const uint32_t* srcKeys = fKeys[src].data();
+        const uint32_t* srcOrder = fOrder[src].data();
+        uint32_t* dstKeys = fKeys[src ^ 1].data();
+        uint32_t* dstOrder = fOrder[src ^ 1].data();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t pos = offsets[(srcKeys[i] >> shift) & 0xff]++;
+            dstKeys[pos] = srcKeys[i];
+            dstOrder[pos] = srcOrder[i];
+        }
+        src ^= 1;
+    }
+
+    return fOrder[src].data();
+}
+
+const uint32_t* hsRadixSortArray::Sort(const float* keys, uint32_t count)
+{
+    ISetup(keys, count);
+    if (count < 2)
+        return fOrder[0].data();
+
+    return IRadixSort(count);
+}
+
+const uint32_t* hsRadixSortArray::SortNearlySorted(const float* keys, uint32_t count)
+{
+    ISetup(keys, count);
+    if (count < 2 || IInsertionSort(count))
+        return fOrder[0].data();
+
+    return IRadixSort(count);
+}
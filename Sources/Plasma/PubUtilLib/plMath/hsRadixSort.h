@@ -43,6 +43,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef hsRadixSort_inc
 #define hsRadixSort_inc
 
+#include <vector>
+
 class hsRadixSortElem 
 {
 public:
@@ -88,4 +90,28 @@ public:
 
 };
 
+// Sorts an array of float keys without any linked lists. The keys are
+// flipped into unsigned ints that sort the same way, then bucketed a byte
+// at a time, with all four byte histograms counted in a single pass up front.
+// Both return the indices of the keys in ascending order (stable), in an
+// array owned by the sorter that's good until the next sort.
+class hsRadixSortArray
+{
+protected:
+    std::vector<uint32_t>   fKeys[2];
+    std::vector<uint32_t>   fOrder[2];
+
+    void            ISetup(const float* keys, uint32_t count);
+    bool            IInsertionSort(uint32_t count);
+    const uint32_t* IRadixSort(uint32_t count);
+
+public:
+    const uint32_t* Sort(const float* keys, uint32_t count);
+
+    // For keys that are mostly in order already, like a list that was left in
+    // last frame's sorted order. Patches up the order in place, falling back
+    // on the full sort if that turns out to be too much work.
+    const uint32_t* SortNearlySorted(const float* keys, uint32_t count);
+};
+
 #endif // hsRadixSort_inc
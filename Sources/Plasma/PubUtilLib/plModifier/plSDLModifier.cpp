@@ -99,6 +99,16 @@ void plSDLModifier::ISendNetMsg(plStateDataRecord*& state, plKey senderKey, uint
 
     writeOptions |= plSDL::kTimeStampOnRead;
 
+    // only send deltas of state the server has already seen, and only if it understands them.
+    // state that isn't persisted or only goes to some players may not be what the receivers
+    // last saw, so it always goes out whole.
+    const uint32_t kNoDeltaFlags = plSynchedObject::kNewState | plSynchedObject::kUseRelevanceRegions |
+        plSynchedObject::kDontPersistOnServer;
+    bool deltaEncode = dirtyOnly && (sendFlags & kNoDeltaFlags) == 0 &&
+        (state->GetFlags() & plStateDataRecord::kVolatile) == 0 &&
+        plNetClientApp::GetInstance()->GetFlagsBit(plNetClientApp::kSDLDeltaEncoding);
+    if (deltaEncode)
+        writeOptions |= plSDL::kDeltaEncode;
 
     // send to server
     plNetMsgSDLState* msg = state->PrepNetMsg(0, writeOptions);
@@ -117,6 +127,9 @@ void plSDLModifier::ISendNetMsg(plStateDataRecord*& state, plKey senderKey, uint
     if (sendFlags & plSynchedObject::kIsAvatarState)
         msg->SetIsAvatarState(true);
 
+    if (deltaEncode)
+        msg->SetIsDeltaState(true);
+
     if (broadcast && plNetClientApp::GetInstance())
     {
         msg->SetPlayerID(plNetClientApp::GetInstance()->GetPlayerID());
@@ -128,6 +141,20 @@ void plSDLModifier::ISendNetMsg(plStateDataRecord*& state, plKey senderKey, uint
     fSentOrRecvdState = true;
 }
 
+//
+// we got element deltas we can't apply, so have the server send the whole state
+//
+void plSDLModifier::IRequestFullState()
+{
+    plNetClientApp::GetInstance()->DebugMsg("\tRequesting full SDL state after unresolved deltas: type {}, object {}",
+        GetSDLName(), GetStateOwnerKey()->GetName());
+
+    plNetMsgObjStateRequest msg;
+    msg.SetNetProtocol(kNetProtocolCli2Game);
+    msg.ObjectInfo()->SetUoid(GetStateOwnerKey()->GetUoid());
+    plNetClientApp::GetInstance()->SendMsg(&msg);
+}
+
 //
 // Process SDL msgs to send and recv state
 //
@@ -206,6 +233,9 @@ void plSDLModifier::SendState(uint32_t sendFlags)
             gMooseDump=false;
         }
 
+        // the change masks only said what to send, curState holds whole values
+        curState->ClearElementDeltas();
+
         // cache current state, send notifications if necessary
         fStateCache->UpdateFrom(*curState, dirtyOnly);  // update local copy of state
 
@@ -217,7 +247,7 @@ void plSDLModifier::SendState(uint32_t sendFlags)
         plNetObjectDebugger::GetInstance()->SetDebugging(false);
 }
 
-void plSDLModifier::ReceiveState(const plStateDataRecord* srcState)
+void plSDLModifier::ReceiveState(plStateDataRecord* srcState)
 {
     hsAssert(fStateCache, "nil stateCache");
 
@@ -231,6 +261,12 @@ void plSDLModifier::ReceiveState(const plStateDataRecord* srcState)
         gMooseDump=false;
     }
 
+    // delta encoded arrays only carry their changed elements, fill in the rest from our copy.
+    // if our copy isn't what the sender diffed against, those vars are dropped and we ask
+    // for the whole state again.
+    if (srcState->HasElementDeltas() && !srcState->ResolveElementDeltas(*fStateCache))
+        IRequestFullState();
+
     if (srcState->IsUsed())
     {
         plSynchEnabler ps(false);   // disable dirty tracking while we are receiving/applying state
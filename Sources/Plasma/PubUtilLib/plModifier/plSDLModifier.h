@@ -57,6 +57,7 @@ protected:
     bool    fSentOrRecvdState;
     
     void ISendNetMsg(plStateDataRecord*& state, plKey senderKey, uint32_t sendFlags);     // transmit net msg 
+    void IRequestFullState();       // ask the server for all of our state
     virtual void IPutCurrentStateIn(plStateDataRecord* dstState) = 0;
     virtual void ISetCurrentStateFrom(const plStateDataRecord* srcState) = 0;
     virtual void ISentState(const plStateDataRecord* sentState) {}
@@ -73,7 +74,7 @@ public:
 
     bool MsgReceive(plMessage* msg);
     void SendState(uint32_t sendFlags);       // send a state update
-    void ReceiveState(const plStateDataRecord* srcState);   // recv a state update
+    void ReceiveState(plStateDataRecord* srcState);   // recv a state update, resolving any element deltas in place
     virtual const char* GetSDLName() const = 0; // return the string name of the type of state descriptor you handle
     virtual plKey GetStateOwnerKey() const;
     
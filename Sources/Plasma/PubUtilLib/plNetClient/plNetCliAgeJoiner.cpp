@@ -223,6 +223,7 @@ void plNCAgeJoiner::Start () {
     nc->fNumInitialSDLStates            = 0;
     nc->SetFlagsBit(plNetClientApp::kNeedInitialAgeStateCount);
     nc->SetFlagsBit(plNetClientApp::kLoadingInitialAgeState);
+    nc->SetFlagsBit(plNetClientApp::kSDLDeltaEncoding, false);
 
     // if we're linking to startup then set the OfflineAge flag
     // so we by-pass the game server
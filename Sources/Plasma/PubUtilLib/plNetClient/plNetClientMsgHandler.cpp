@@ -217,6 +217,10 @@ MSG_HANDLER_DEFN(plNetClientMsgHandler,plNetMsgSDLState)
     {
         nc->IncNumInitialSDLStates();
         rwFlags |= plSDL::kMakeDirty;   // if initial state, we want all vars.
+
+        // initial state is always sent in full, the delta flag says we may send deltas back
+        if ( m->IsDeltaState() )
+            nc->SetFlagsBit( plNetClientApp::kSDLDeltaEncoding );
     }
     else if ( nc->GetFlagsBit( plNetClientApp::kLoadingInitialAgeState ) )
     {
@@ -232,6 +236,9 @@ MSG_HANDLER_DEFN(plNetClientMsgHandler,plNetMsgSDLState)
         }
         hsLogEntry( nc->DebugMsg( "We are still joining age, but have all initial states. Accepting this state (risky?)." ) );
     }
+
+    if ( m->IsDeltaState() && !m->IsInitialState() )
+        rwFlags |= plSDL::kDeltaEncode;
     
 
     // extract stateDataRecord from msg
@@ -342,8 +342,13 @@ void plNetClientStreamRecorder::ILogMsg(plNetMessage* msg, const char* preText)
 
             int i;
 
+            // delta encoded states only carry changed array elements, which is all we list here
+            uint32_t readOptions = 0;
+            if (sdlMsg->IsDeltaState() && !sdlMsg->IsInitialState())
+                readOptions |= plSDL::kDeltaEncode;
+
             plStateDataRecord sdRec(descName, ver);
-            sdRec.Read(&stream, 0);
+            sdRec.Read(&stream, 0, readOptions);
             plStateDataRecord::SimpleVarsList vars;
             sdRec.GetDirtyVars(&vars);
             for (i = 0; i < vars.size(); i++)
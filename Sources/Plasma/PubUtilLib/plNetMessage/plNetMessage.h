@@ -151,6 +151,7 @@ public:
         kIsSystemMessage    = 0x20000,
         kNeedsReliableSend  = 0x40000,
         kRouteToAllPlayers  = 0x80000,  // send this message to all online players.
+        kDeltaSDLState      = 0x100000, // SDL state stream is delta encoded. On initial state, the server accepts delta encoded state.
     };
     enum PeekOptions        // options for partial peeking
     {
@@ -405,6 +406,9 @@ public:
 
     bool IsAvatarState() const { return fIsAvatarState != 0; }
     void SetIsAvatarState(bool b) { fIsAvatarState = b; }
+
+    bool IsDeltaState() const { return IsBitSet(kDeltaSDLState); }
+    void SetIsDeltaState(bool b) { SetBit(kDeltaSDLState, b); }
     
     // debug
     ST::string AsString() const override;
@@ -291,11 +291,14 @@ void pl3DPipeline::BeginVisMgr(plVisMgr* visMgr)
     // been explicitly told which objects it affects, so they don't
     // need to be in the search lists.
     // These lists are only constructed once per render, but searched
-    // multiple times
+    // multiple times, so they also go into a grid by the bounds of
+    // where each light reaches, letting each drawable look at only the
+    // lights near it.
 
     plProfile_BeginTiming(FindSceneLights);
     fCharLights.SetCount(0);
     fVisLights.SetCount(0);
+    fLightGrid.Reset();
     if (visMgr)
     {
         const hsBitVector& visSet = visMgr->GetVisSet();
@@ -311,12 +314,16 @@ void pl3DPipeline::BeginVisMgr(plVisMgr* visMgr)
                 if (light->GetProperty(plLightInfo::kLPHasIncludes))
                 {
                     if (light->GetProperty(plLightInfo::kLPIncludesChars))
+                    {
                         fCharLights.Append(light);
+                        fLightGrid.AddLight(light, false);
+                    }
                 }
                 else
                 {
                     fVisLights.Append(light);
                     fCharLights.Append(light);
+                    fLightGrid.AddLight(light, true);
                 }
             }
         }
@@ -333,16 +340,21 @@ void pl3DPipeline::BeginVisMgr(plVisMgr* visMgr)
                 if (light->GetProperty(plLightInfo::kLPHasIncludes))
                 {
                     if (light->GetProperty(plLightInfo::kLPIncludesChars))
+                    {
                         fCharLights.Append(light);
+                        fLightGrid.AddLight(light, false);
+                    }
                 }
                 else
                 {
                     fVisLights.Append(light);
                     fCharLights.Append(light);
+                    fLightGrid.AddLight(light, true);
                 }
             }
         }
     }
+    fLightGrid.Build();
     plProfile_IncCount(LightVis, fVisLights.GetCount());
     plProfile_IncCount(LightChar, fCharLights.GetCount());
 
@@ -354,6 +366,7 @@ void pl3DPipeline::EndVisMgr(plVisMgr* visMgr)
 {
     fCharLights.SetCount(0);
     fVisLights.SetCount(0);
+    fLightGrid.Reset();
 }
 
 
@@ -773,26 +786,20 @@ void pl3DPipeline::ICheckLighting(plDrawableSpans* drawable, hsTArray<int16_t>&
     // based on the drawables bounds and properties.
     // If the drawable has the PropCharacter property, it is affected by lights
     // in fCharLights, else only by the smaller list of fVisLights.
+    // Only the lights binned near the drawable are worth testing.
 
     plProfile_BeginTiming(FindActiveLights);
+    static hsTArray<plLightInfo*> candidates;
     static hsTArray<plLightInfo*> lightList;
+    candidates.SetCount(0);
     lightList.SetCount(0);
 
-    if (drawable->GetNativeProperty(plDrawable::kPropCharacter))
+    const hsBounds3Ext& worldBnd = drawable->GetSpaceTree()->GetWorldBounds();
+    fLightGrid.Harvest(worldBnd, drawable->GetNativeProperty(plDrawable::kPropCharacter), candidates);
+    for (size_t i = 0; i < candidates.GetCount(); i++)
     {
-        for (size_t i = 0; i < fCharLights.GetCount(); i++)
-        {
-            if (fCharLights[i]->AffectsBound(drawable->GetSpaceTree()->GetWorldBounds()))
-                lightList.Append(fCharLights[i]);
-        }
-    }
-    else
-    {
-        for (size_t i = 0; i < fVisLights.GetCount(); i++)
-        {
-            if (fVisLights[i]->AffectsBound(drawable->GetSpaceTree()->GetWorldBounds()))
-                lightList.Append(fVisLights[i]);
-        }
+        if (candidates[i]->AffectsBound(worldBnd))
+            lightList.Append(candidates[i]);
     }
     plProfile_EndTiming(FindActiveLights);
 
@@ -50,6 +50,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "hsG3DDeviceSelector.h"
 
 #include "plSurface/plLayerInterface.h"
+#include "plGLight/plLightGrid.h"
 
 
 class hsGMaterial;
@@ -118,6 +119,7 @@ protected:
     plLightInfo*                        fActiveLights;
     hsTArray<plLightInfo*>              fCharLights;
     hsTArray<plLightInfo*>              fVisLights;
+    plLightGrid                         fLightGrid;     // Both of the above, binned by where they reach
 
     hsTArray<plShadowSlave*>            fShadows;
 
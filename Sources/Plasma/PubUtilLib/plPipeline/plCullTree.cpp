@@ -43,12 +43,18 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "HeadSpin.h"
 #include "plCullTree.h"
 #include "plDrawable/plSpaceTree.h"
+#include "hsCpuID.h"
 #include "hsFastMath.h"
 #include "hsColorRGBA.h"
+#include "hsJobSystem.h"
 #include "plProfile.h"
 
 #include "plTweak.h"
 
+#ifdef HS_SIMD_INCLUDE
+#  include HS_SIMD_INCLUDE
+#endif
+
 #define MF_DEBUG_NORM
 #ifdef MF_DEBUG_NORM
 
@@ -381,6 +387,208 @@ void plCullNode::IHarvest(const plSpaceTree* space, hsTArray<int16_t>& outList)
     ScratchCulled().SetCount(0);
 }
 
+//////////////////////////////////////////////////////////////////////
+// Frustum only harvest.
+// With no occluders, every cull node has only an outer child, so the
+// tree is a chain of planes and a space tree node is visible unless one
+// of the planes culls it. Then we can skip the per node recursion above
+// and test a whole level's worth of space tree nodes against all the
+// planes at once, several at a time, using the space tree's flat bounds.
+//////////////////////////////////////////////////////////////////////
+
+struct plCullPlanes
+{
+    enum { kMaxPlanes = 8 };
+
+    float   fNorm[kMaxPlanes][3];
+    float   fAbsNorm[kMaxPlanes][3];
+    float   fDist[kMaxPlanes];
+    int     fNumPlanes;
+};
+
+// Same as the safety distance in plCullNode::TestBounds()
+static const float kCullSafetyDist = -0.1f;
+
+// Below this many nodes in a level it's not worth farming them out
+static const size_t kParallelCullNodes = 1024;
+
+static void IClassifyNodes_fpu(const plSpaceTreeFlatBounds* bounds, const int16_t* nodes, size_t count,
+                               const plCullPlanes& planes, uint8_t* status)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const plSpaceTreeFlatBounds& block = bounds[nodes[i] >> 2];
+        int lane = nodes[i] & 3;
+
+        uint8_t stat = plCullNode::kClear;
+        for (int p = 0; p < planes.fNumPlanes; p++)
+        {
+            float dist = planes.fDist[p];
+            float rad = 0;
+            for (int j = 0; j < 3; j++)
+            {
+                dist += planes.fNorm[p][j] * block.fCenter[j][lane];
+                rad += planes.fAbsNorm[p][j] * block.fExtent[j][lane];
+            }
+            if (dist + rad < kCullSafetyDist)
+            {
+                stat = plCullNode::kCulled;
+                break;
+            }
+            if (dist - rad < 0)
+                stat = plCullNode::kSplit;
+        }
+        status[i] = stat;
+    }
+}
+
+static void IClassifyNodes_sse2(const plSpaceTreeFlatBounds* bounds, const int16_t* nodes, size_t count,
+                                const plCullPlanes& planes, uint8_t* status)
+{
+    size_t i = 0;
+#ifdef HS_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 safety = _mm_set1_ps(kCullSafetyDist);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const plSpaceTreeFlatBounds& b0 = bounds[nodes[i] >> 2];
+        const plSpaceTreeFlatBounds& b1 = bounds[nodes[i+1] >> 2];
+        const plSpaceTreeFlatBounds& b2 = bounds[nodes[i+2] >> 2];
+        const plSpaceTreeFlatBounds& b3 = bounds[nodes[i+3] >> 2];
+        int l0 = nodes[i] & 3, l1 = nodes[i+1] & 3, l2 = nodes[i+2] & 3, l3 = nodes[i+3] & 3;
+
+        __m128 center[3], extent[3];
+        for (int j = 0; j < 3; j++)
+        {
+            center[j] = _mm_setr_ps(b0.fCenter[j][l0], b1.fCenter[j][l1], b2.fCenter[j][l2], b3.fCenter[j][l3]);
+            extent[j] = _mm_setr_ps(b0.fExtent[j][l0], b1.fExtent[j][l1], b2.fExtent[j][l2], b3.fExtent[j][l3]);
+        }
+
+        __m128 culled = zero;
+        __m128 split = zero;
+        for (int p = 0; p < planes.fNumPlanes; p++)
+        {
+            __m128 dist = _mm_set1_ps(planes.fDist[p]);
+            __m128 rad = zero;
+            for (int j = 0; j < 3; j++)
+            {
+                dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes.fNorm[p][j]), center[j]));
+                rad = _mm_add_ps(rad, _mm_mul_ps(_mm_set1_ps(planes.fAbsNorm[p][j]), extent[j]));
+            }
+            culled = _mm_or_ps(culled, _mm_cmplt_ps(_mm_add_ps(dist, rad), safety));
+            split = _mm_or_ps(split, _mm_cmplt_ps(_mm_sub_ps(dist, rad), zero));
+        }
+
+        int culledMask = _mm_movemask_ps(culled);
+        int splitMask = _mm_movemask_ps(split);
+        for (int k = 0; k < 4; k++)
+        {
+            if (culledMask & (1 << k))
+                status[i + k] = plCullNode::kCulled;
+            else if (splitMask & (1 << k))
+                status[i + k] = plCullNode::kSplit;
+            else
+                status[i + k] = plCullNode::kClear;
+        }
+    }
+#endif // HS_SSE2
+
+    // Stragglers
+    if (i < count)
+        IClassifyNodes_fpu(bounds, nodes + i, count - i, planes, status + i);
+}
+
+typedef void(*classify_nodes_ptr)(const plSpaceTreeFlatBounds*, const int16_t*, size_t,
+                                  const plCullPlanes&, uint8_t*);
+static hsCpuFunctionDispatcher<classify_nodes_ptr> IClassifyNodes {
+    &IClassifyNodes_fpu,
+    nullptr,            // SSE1
+    &IClassifyNodes_sse2
+};
+
+bool plCullTree::IIsPlaneChain() const
+{
+    int numPlanes = 0;
+    for (plCullNode* node = IGetRoot(); node; node = IGetNode(node->fOuterChild))
+    {
+        if (node->fInnerChild >= 0 || ++numPlanes > plCullPlanes::kMaxPlanes)
+            return false;
+    }
+    return numPlanes > 0;
+}
+
+void plCullTree::IHarvestPlaneChain(const plSpaceTree* space, hsTArray<int16_t>& outList) const
+{
+    plCullPlanes planes;
+    planes.fNumPlanes = 0;
+    for (plCullNode* node = IGetRoot(); node; node = IGetNode(node->fOuterChild))
+    {
+        int p = planes.fNumPlanes++;
+        for (int j = 0; j < 3; j++)
+        {
+            planes.fNorm[p][j] = node->fNorm[j];
+            planes.fAbsNorm[p][j] = fabsf(node->fNorm[j]);
+        }
+        planes.fDist[p] = node->fDist;
+    }
+
+    const plSpaceTreeFlatBounds* bounds = space->GetFlatBounds();
+
+    std::vector<int16_t>& frontier = fScratchFrontier;
+    std::vector<int16_t>& next = fScratchNextFrontier;
+    std::vector<uint8_t>& status = fScratchStatus;
+
+    auto pushNode = [space](std::vector<int16_t>& list, int16_t who)
+    {
+        if (!space->IsDisabled(who) && space->GetNode(who).fWorldBounds.GetType() == kBoundsNormal)
+            list.push_back(who);
+    };
+
+    frontier.clear();
+    pushNode(frontier, space->GetRoot());
+
+    // One level of the space tree per pass. Culled nodes drop out, clear ones
+    // get harvested whole, and split interior nodes send their children on.
+    while (!frontier.empty())
+    {
+        status.resize(frontier.size());
+        if (frontier.size() >= kParallelCullNodes)
+        {
+            hsJobSystem::ParallelFor(0, frontier.size(), kParallelCullNodes / 4,
+                [&](size_t begin, size_t end) {
+                    IClassifyNodes.call(bounds, frontier.data() + begin, end - begin, planes, status.data() + begin);
+                });
+        }
+        else
+            IClassifyNodes.call(bounds, frontier.data(), frontier.size(), planes, status.data());
+
+        next.clear();
+        for (size_t i = 0; i < frontier.size(); i++)
+        {
+            int16_t who = frontier[i];
+            if (status[i] == plCullNode::kCulled)
+                continue;
+
+            const plSpaceTreeNode& node = space->GetNode(who);
+            if (status[i] == plCullNode::kSplit && !node.IsLeaf())
+            {
+                pushNode(next, node.GetChild(0));
+                pushNode(next, node.GetChild(1));
+                continue;
+            }
+
+            plProfile_Inc(HarvestNodes);
+            space->HarvestLeaves(who, ScratchTotVec(), ScratchBitVec());
+        }
+        frontier.swap(next);
+    }
+
+    space->BitVectorToList(outList, ScratchBitVec());
+    ScratchBitVec().Clear();
+    ScratchTotVec().Clear();
+}
+
 //////////////////////////////////////////////////////////////////////
 // This section builds the tree from the input cullpoly's
 //////////////////////////////////////////////////////////////////////
@@ -1064,7 +1272,12 @@ void plCullTree::SetViewPos(const hsPoint3& p)
 void plCullTree::Harvest(const plSpaceTree* space, hsTArray<int16_t>& outList) const
 {
     outList.SetCount(0);
-    if (!space->IsEmpty())
+    if (space->IsEmpty())
+        return;
+
+    if (IIsPlaneChain())
+        IHarvestPlaneChain(space, outList);
+    else
         IGetRoot()->IHarvest(space, outList);
 
 }
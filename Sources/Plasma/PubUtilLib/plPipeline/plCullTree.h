@@ -49,6 +49,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plCuller.h"
 #include "plScene/plCullPoly.h"
 
+#include <vector>
+
 #ifdef HS_DEBUGGING
 #define DEBUG_POINTERS
 #endif // HS_DEBUGGING
@@ -79,6 +81,9 @@ protected:
     mutable hsLargeArray<int16_t>     fScratchCulled;
     mutable hsBitVector             fScratchBitVec;
     mutable hsBitVector             fScratchTotVec;
+    mutable std::vector<int16_t>    fScratchFrontier;
+    mutable std::vector<int16_t>    fScratchNextFrontier;
+    mutable std::vector<uint8_t>    fScratchStatus;
 
     void        IVisPolyShape(const plCullPoly& poly, bool dark) const;
     void        IVisPolyEdge(const hsPoint3& p0, const hsPoint3& p1, bool dark) const;
@@ -95,6 +100,10 @@ protected:
     void                ITestNode(const plSpaceTree* space, int16_t who, hsTArray<int16_t>& outList) const; // Appends to outlist
     void                ITestList(const plSpaceTree* space, const hsTArray<int16_t>& inList, hsTArray<int16_t>& outList) const;
 
+    // Fast path for when there are no occluders and the tree is just the frustum
+    bool                IIsPlaneChain() const;
+    void                IHarvestPlaneChain(const plSpaceTree* space, hsTArray<int16_t>& outList) const;
+
     int16_t               IAddPolyRecur(const plCullPoly& poly, int16_t iNode);
     int16_t               IMakeHoleSubTree(const plCullPoly& poly) const;
     int16_t               IMakePolySubTree(const plCullPoly& poly) const;
@@ -117,11 +117,14 @@ void    plStatusLogDrawer::Draw(plStatusLog* curLog, plStatusLog* firstLog)
                        x + width - 8,      y + ( lineHt << 1 ) + 2, 127, 127, 255, 255 );
 
     y += lineHt * 2;
-    for( i = 0; i < IGetMaxNumLines( curLog ); i++ )
     {
-        if( IGetLines( curLog )[ i ] != nil )
-            drawText.DrawString( x + 4, y, IGetLines( curLog )[ i ], IGetColors( curLog )[ i ] );
-        y += lineHt;
+        std::lock_guard<std::mutex> lock(IGetLinesMutex(curLog));
+        for( i = 0; i < IGetMaxNumLines( curLog ); i++ )
+        {
+            if( IGetLines( curLog )[ i ] != nil )
+                drawText.DrawString( x + 4, y, IGetLines( curLog )[ i ], IGetColors( curLog )[ i ] );
+            y += lineHt;
+        }
     }
 
     if (firstLog)
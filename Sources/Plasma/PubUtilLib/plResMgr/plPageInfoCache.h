@@ -0,0 +1,94 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plPageInfoCache_h_inc
+#define plPageInfoCache_h_inc
+
+#include "HeadSpin.h"
+#include "plFileSystem.h"
+#include "plPageInfo.h"
+
+#include <map>
+
+//
+// Remembers the header of every page file we've seen, along with the file's
+// size and modification time.  At startup the resManager checks each .prp
+// against the cache and only opens the ones that have changed, instead of
+// doing a small random read from every page in the data directory.
+//
+class plPageInfoCache
+{
+protected:
+    struct Entry
+    {
+        uint64_t    fModifyTime;
+        int64_t     fFileSize;
+        plPageInfo  fPageInfo;
+        bool        fSeen;      // Still on disk this run
+
+        Entry() : fModifyTime(0), fFileSize(-1), fSeen(false) { }
+    };
+
+    typedef std::map<ST::string, Entry> EntryMap;
+    EntryMap    fEntries;
+    bool        fDirty;
+
+public:
+    plPageInfoCache() : fDirty(false) { }
+
+    // Loads the cache, throwing it away if it's for a different data path
+    // or doesn't look right.  Returns false if nothing was loaded.
+    bool Read(const plFileName& cacheFile, const plFileName& dataPath);
+    // Saves every entry that was looked up or added since Read()
+    bool Write(const plFileName& cacheFile, const plFileName& dataPath);
+
+    // Returns the cached header for a page if the file hasn't changed since
+    // it was cached, nil otherwise
+    const plPageInfo* Find(const plFileInfo& file);
+    void Update(const plFileInfo& file, const plPageInfo& pageInfo);
+
+    // True if the cache on disk no longer matches what we found
+    bool IsDirty() const;
+
+    static plFileName GetDefaultPath();
+};
+
+#endif // plPageInfoCache_h_inc
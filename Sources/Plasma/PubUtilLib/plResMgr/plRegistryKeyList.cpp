@@ -56,13 +56,32 @@ plRegistryKeyList::~plRegistryKeyList()
     );
 }
 
+void plRegistryKeyList::IIndexKey(plKeyImp* key) const
+{
+    auto result = fKeysByName.emplace(key->GetName(), key);
+
+    // Duplicate names find the key nearest the front of the list
+    if (!result.second && key->GetUoid().GetObjectID() < result.first->second->GetUoid().GetObjectID())
+        result.first->second = key;
+}
+
 plKeyImp* plRegistryKeyList::FindKey(const ST::string& keyName) const
 {
-    auto it = std::find_if(fKeys.begin(), fKeys.end(),
-        [&] (plKeyImp* key) { return key->GetName().compare_i(keyName) == 0; }
-    );
-    if (it != fKeys.end())
-        return *it;
+    if (!fKeysByNameValid)
+    {
+        fKeysByName.clear();
+        fKeysByName.reserve(fKeys.size());
+        for (plKeyImp* key : fKeys)
+        {
+            if (key)
+                IIndexKey(key);
+        }
+        fKeysByNameValid = true;
+    }
+
+    auto it = fKeysByName.find(keyName);
+    if (it != fKeysByName.end())
+        return it->second;
     else
         return nullptr;
 }
@@ -120,6 +139,15 @@ bool plRegistryKeyList::IterateKeys(plRegistryKeyIterator* iterator)
     return true;
 }
 
+void plRegistryKeyList::GetUnloadedRanges(std::vector<std::pair<uint32_t, uint32_t>>& ranges) const
+{
+    for (plKeyImp* key : fKeys)
+    {
+        if (key && key->GetDataLen() > 0 && !key->ObjectIsLoaded())
+            ranges.emplace_back(key->GetStartPos(), key->GetDataLen());
+    }
+}
+
 void plRegistryKeyList::AddKey(plKeyImp* key, LoadStatus& loadStatusChange)
 {
     loadStatusChange = kNoChange;
@@ -145,8 +173,15 @@ void plRegistryKeyList::AddKey(plKeyImp* key, LoadStatus& loadStatusChange)
             uint32_t id = key->GetUoid().GetObjectID();
             if (fKeys.size() < id)
                 fKeys.resize(id);
+
+            // Replacing a key leaves it in the name index, so start over
+            if (fKeys[id - 1])
+                fKeysByNameValid = false;
             fKeys[id - 1] = key;
         }
+
+        if (fKeysByNameValid)
+            IIndexKey(key);
         ++fReffedKeys;
     }
 }
@@ -205,6 +240,7 @@ void plRegistryKeyList::Read(hsStream* s)
 
     uint32_t numKeys = s->ReadLE32();
     fKeys.reserve((numKeys * 3) / 2);
+    fKeysByNameValid = false;
 
     for (uint32_t i = 0; i < numKeys; ++i)
     {
@@ -42,7 +42,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #ifndef plRegistryKeyList_h_inc
 #define plRegistryKeyList_h_inc
 
+#include <unordered_map>
 #include <vector>
+#include <string_theory/string>
 
 class plKeyImp;
 class plRegistryKeyIterator;
@@ -63,9 +65,16 @@ protected:
 
     std::vector<plKeyImp*> fKeys;
 
-    plRegistryKeyList() {}
+    // Case-insensitive name lookup, built by the first FindKey by name.
+    // Keys are named before they are added and stay in the list until it
+    // is destroyed, so only adding keys has to keep it up to date.
+    mutable std::unordered_map<ST::string, plKeyImp*, ST::hash_i, ST::equal_i> fKeysByName;
+    mutable bool fKeysByNameValid;
+
+    plRegistryKeyList() : fKeysByNameValid(false) {}
 
     void IRepack();
+    void IIndexKey(plKeyImp* key) const;
     void ILock() { ++fLocked; }
     void IUnlock() { --fLocked; }
 
@@ -78,7 +87,7 @@ public:
     };
 
     plRegistryKeyList(uint16_t classType)
-        : fClassType(classType), fReffedKeys(0), fLocked(0)
+        : fClassType(classType), fReffedKeys(0), fLocked(0), fKeysByNameValid(false)
     { }
     ~plRegistryKeyList();
 
@@ -89,6 +98,10 @@ public:
 
     bool IterateKeys(plRegistryKeyIterator* iterator);
 
+    // Appends the (start, length) of the page data for every key whose
+    // object isn't loaded yet
+    void GetUnloadedRanges(std::vector<std::pair<uint32_t, uint32_t>>& ranges) const;
+
     void AddKey(plKeyImp* key, LoadStatus& loadStatusChange);
     void SetKeyUsed(plKeyImp* key) { ++fReffedKeys; }
     bool SetKeyUnused(plKeyImp* key, LoadStatus& loadStatusChange);
@@ -39,9 +39,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
       Mead, WA   99021
 
 *==LICENSE==*/
+#include <algorithm>
+#include <vector>
+
 #include "plRegistryNode.h"
 #include "plRegistryKeyList.h"
 #include "plRegistryHelpers.h"
+#include "plResPrefetcher.h"
 
 #include "pnKeyedObject/plKeyImp.h"
 #include "plStatusLog/plStatusLog.h"
@@ -53,23 +57,37 @@ plRegistryPageNode::plRegistryPageNode(const plFileName& path)
     : fValid(kPageCorrupt)
     , fPath(path)
     , fLoadedTypes(0)
+    , fReadStream(nil)
     , fOpenRequests(0)
     , fIsNewPage(false)
 {
     hsStream* stream = OpenStream();
     if (stream)
     {
-        fPageInfo.Read(&fStream);
-        fValid = IVerify();
+        fPageInfo.Read(stream);
+        fValid = IVerify(stream->GetEOF());
         CloseStream();
     }
 }
 
+plRegistryPageNode::plRegistryPageNode(const plFileName& path, const plPageInfo& pageInfo, uint32_t fileSize)
+    : fValid(kPageCorrupt)
+    , fPath(path)
+    , fPageInfo(pageInfo)
+    , fLoadedTypes(0)
+    , fReadStream(nil)
+    , fOpenRequests(0)
+    , fIsNewPage(false)
+{
+    fValid = IVerify(fileSize);
+}
+
 plRegistryPageNode::plRegistryPageNode(const plLocation& location, const ST::string& age,
                                        const ST::string& page, const plFileName& dataPath)
     : fValid(kPageOk)
     , fPageInfo(location)
     , fLoadedTypes(0)
+    , fReadStream(nil)
     , fOpenRequests(0)
     , fIsNewPage(true)
 {
@@ -86,16 +104,10 @@ plRegistryPageNode::~plRegistryPageNode()
     UnloadKeys();
 }
 
-PageCond plRegistryPageNode::IVerify()
+PageCond plRegistryPageNode::IVerify(uint32_t fileSize)
 {
     // Check the checksum values first, to make sure the files aren't corrupt
-    uint32_t ourChecksum = 0;
-    hsStream* stream = OpenStream();
-    if (stream)
-    {
-        ourChecksum = stream->GetEOF() - fPageInfo.GetDataStart();
-        CloseStream();
-    }
+    uint32_t ourChecksum = fileSize - fPageInfo.GetDataStart();
     if (ourChecksum != fPageInfo.GetChecksum())
         return kPageCorrupt;
 
@@ -121,15 +133,27 @@ PageCond plRegistryPageNode::IVerify()
     return kPageOk;
 }
 
-hsStream* plRegistryPageNode::OpenStream()
+hsStream* plRegistryPageNode::OpenStream(plResPrefetcher* prefetcher)
 {
     if (fOpenRequests == 0)
     {
-        if (!fStream.Open(fPath, "rb"))
+        // Use the copy read ahead if there is one, otherwise map the page if
+        // we can; fall back on plain buffered reads if not
+        if (prefetcher && prefetcher->Take(fPath, fPrefetched))
+        {
+            fPrefetchedStream.Init(fPrefetched.size(), fPrefetched.data());
+            fPrefetchedStream.Rewind();
+            fReadStream = &fPrefetchedStream;
+        }
+        else if (fMappedStream.Open(fPath, "rb"))
+            fReadStream = &fMappedStream;
+        else if (fStream.Open(fPath, "rb"))
+            fReadStream = &fStream;
+        else
             return nil;
     }
     fOpenRequests++;
-    return &fStream;
+    return fReadStream;
 }
 
 void plRegistryPageNode::CloseStream()
@@ -137,8 +161,50 @@ void plRegistryPageNode::CloseStream()
     if (fOpenRequests > 0)
         fOpenRequests--;
 
-    if (fOpenRequests == 0)
-        fStream.Close();
+    if (fOpenRequests == 0 && fReadStream)
+    {
+        if (fReadStream == &fPrefetchedStream)
+        {
+            fPrefetchedStream.Init(0, nil);
+            fPrefetched.clear();
+            fPrefetched.shrink_to_fit();
+        }
+        else
+            fReadStream->Close();
+        fReadStream = nil;
+    }
+}
+
+void plRegistryPageNode::PrefetchObjects()
+{
+    if (fOpenRequests == 0 || fReadStream != &fMappedStream)
+        return;
+
+    typedef std::pair<uint32_t, uint32_t> Range;
+    std::vector<Range> ranges;
+    for (KeyMap::const_iterator it = fKeyLists.begin(); it != fKeyLists.end(); it++)
+        it->second->GetUnloadedRanges(ranges);
+    if (ranges.empty())
+        return;
+
+    // Objects are mostly laid out back to back, so coalesce neighbouring
+    // ranges into a few large hints instead of one per object.
+    const uint32_t kMaxGap = 64 * 1024;
+    std::sort(ranges.begin(), ranges.end());
+
+    Range run = ranges[0];
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+        uint32_t runEnd = run.first + run.second;
+        if (ranges[i].first <= runEnd + kMaxGap)
+            run.second = std::max(runEnd, ranges[i].first + ranges[i].second) - run.first;
+        else
+        {
+            fMappedStream.WillNeed(run.first, run.second);
+            run = ranges[i];
+        }
+    }
+    fMappedStream.WillNeed(run.first, run.second);
 }
 
 void plRegistryPageNode::LoadKeys()
@@ -47,11 +47,13 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plPageInfo.h"
 
 #include <map>
+#include <vector>
 
 class plRegistryKeyList;
 class hsStream;
 class plKeyImp;
 class plRegistryKeyIterator;
+class plResPrefetcher;
 
 enum PageCond
 {
@@ -79,20 +81,29 @@ protected:
     plFileName  fPath;          // Path to the page file
     plPageInfo  fPageInfo;      // Info about this page
 
-    hsBufferedStream fStream;   // Stream for reading/writing our page
-    uint8_t fOpenRequests;        // How many handles there are to fStream (or
+    hsBufferedStream fStream;   // Stream for writing our page, and reading it
+                                // if it can't be mapped
+    hsMappedStream fMappedStream; // Stream for reading our page
+    std::vector<uint8_t> fPrefetched; // Page data handed over by the prefetcher
+    hsReadOnlyStream fPrefetchedStream; // Stream for reading fPrefetched
+    hsStream* fReadStream;      // Whichever of the above is open for reading
+    uint8_t fOpenRequests;        // How many handles there are to fReadStream (or
                                 // zero if it's closed)
     bool fIsNewPage;          // True if this page is new (not read off disk)
 
     plRegistryPageNode() {}
 
     plRegistryKeyList* IGetKeyList(uint16_t classType) const;
-    PageCond IVerify();
+    PageCond IVerify(uint32_t fileSize);
 
 public:
     // For reading a page off disk
     plRegistryPageNode(const plFileName& path);
 
+    // For a page on disk whose header we already know, so we don't have to
+    // open the file until its keys are needed
+    plRegistryPageNode(const plFileName& path, const plPageInfo& pageInfo, uint32_t fileSize);
+
     // For creating a new page.
     plRegistryPageNode(const plLocation& location, const ST::string& age,
                        const ST::string& page, const plFileName& dataPath);
@@ -135,9 +146,15 @@ public:
 
     // Call this to get a read stream for the page.  If a valid pointer is
     // returned, make sure to call CloseStream when you're done using it.
-    hsStream*   OpenStream();
+    // If the page was queued with the prefetcher, its data is taken from
+    // there rather than read off disk again.
+    hsStream*   OpenStream(plResPrefetcher* prefetcher = nil);
     void        CloseStream();
 
+    // While the stream is open, asks the OS to start paging in the data for
+    // every object in this page that hasn't been read yet.
+    void        PrefetchObjects();
+
     // Takes care of everything involved in writing this page to disk
     void Write();
     void DeleteSource();
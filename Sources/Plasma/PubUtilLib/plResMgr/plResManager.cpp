@@ -42,6 +42,8 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plResManager.h"
 #include "plRegistryNode.h"
 #include "plResManagerHelper.h"
+#include "plPageInfoCache.h"
+#include "plResPrefetcher.h"
 #include "plResMgrSettings.h"
 #include "plLocalization.h"
 #include "hsSTLStream.h"
@@ -100,6 +102,7 @@ plResManager::plResManager():
     fCloningCounter(0),
     fProgressProc(nil),
     fMyHelper(nil),
+    fPrefetcher(nil),
     fLogReadTimes(false),
     fPageListLock(0),
     fPagesNeedCleanup(false),
@@ -126,10 +129,25 @@ bool plResManager::IInit()
 
     if (plResMgrSettings::Get().GetLoadPagesOnInit()) {
         // We want to go through all the data files in our data path and add new
-        // plRegistryPageNodes to the regTree for each
+        // plRegistryPageNodes to the regTree for each. Headers of pages that
+        // haven't changed since last time come from the page info cache, so we
+        // don't have to open every file just to find out what's in it.
+        plPageInfoCache pageCache;
+        plFileName pageCachePath = plPageInfoCache::GetDefaultPath();
+        pageCache.Read(pageCachePath, fDataPath);
+
         std::vector<plFileName> prpFiles = plFileSystem::ListDir(fDataPath, "*.prp");
         for (auto iter = prpFiles.begin(); iter != prpFiles.end(); ++iter) {
-            plRegistryPageNode* node = new plRegistryPageNode(*iter);
+            plFileInfo fileInfo(*iter);
+            plRegistryPageNode* node;
+            if (const plPageInfo* cachedInfo = pageCache.Find(fileInfo)) {
+                node = new plRegistryPageNode(*iter, *cachedInfo, uint32_t(fileInfo.FileSize()));
+            } else {
+                node = new plRegistryPageNode(*iter);
+                // Only remember headers we actually managed to read
+                if (node->GetPageInfo().IsValid())
+                    pageCache.Update(fileInfo, node->GetPageInfo());
+            }
             const plPageInfo& pi = node->GetPageInfo();
 
             // If a page is already added with this location, add both the already known page
@@ -140,6 +158,9 @@ bool plResManager::IInit()
                 fConflictingPages.insert(node);
             }
         }
+
+        if (pageCache.IsDirty())
+            pageCache.Write(pageCachePath, fDataPath);
     }
 
     // Special case: we always create pages for the predefined pages
@@ -155,6 +176,9 @@ bool plResManager::IInit()
     fMyHelper->Init();
     hsAssert(fMyHelper->GetKey() != nil, "ResManager helper didn't init properly!" );
 
+    fPrefetcher = new plResPrefetcher;
+    fPrefetcher->Start();
+
     kResMgrLog(1, ILog(1, "   ...Init was successful!"));
 
     return true; 
@@ -180,6 +204,10 @@ void plResManager::IShutdown()
 
     kResMgrLog(1, ILog(1, "Shutting down resManager..."));
 
+    // Nothing else is getting paged in, so don't bother reading ahead
+    delete fPrefetcher;
+    fPrefetcher = nil;
+
     // Make sure we're not holding on to any ages for load optimization
     IDropAllAgeKeys();
 
@@ -1169,16 +1197,19 @@ void plResManager::PageInRoom(const plLocation& page, uint16_t objClassToRef, pl
             pageNode->GetPageInfo().GetAge(), pageNode->GetPageInfo().GetPage(), condStr);
         hsMessageBox(msg.c_str(), "Error", hsMessageBoxNormal, hsMessageBoxIconError);
 
+        DropPrefetchedPage(page);
         hsRefCnt_SafeUnRef(refMsg);
         return;
     }
 
-    // Step 0.9: Open the stream on this page, so it remains open for the entire loading process
-    pageNode->OpenStream();
+    // Step 0.9: Open the stream on this page, so it remains open for the entire loading process.
+    // If the page was read ahead, this is where its buffer gets handed over.
+    pageNode->OpenStream(fPrefetcher);
 
     // Step 1: We force a load on all the keys in the given page
     kResMgrLog(2, ILog(2, "...Loading page keys..."));
     LoadPageKeys(pageNode);
+    pageNode->PrefetchObjects();
 
     // Step 2: Now ref all the keys in that page, every single one. This lets us unref 
     // (and thus potentially delete) them later. Note that we also use this for our find.
@@ -1195,6 +1226,7 @@ void plResManager::PageInRoom(const plLocation& page, uint16_t objClassToRef, pl
         // This is coming up a lot lately; too intrusive to be an assert.
         // hsAssert( false, "No object found on which to base our PageInRoom()" );
         pageNode->CloseStream();
+        DropPrefetchedPage(page);
         return;
     }
 
@@ -1213,8 +1245,10 @@ void plResManager::PageInRoom(const plLocation& page, uint16_t objClassToRef, pl
     kResMgrLog(2, ILog(2, "...Dispatching refMessage..."));
     AddViaNotify(objKey, refMsg, plRefFlags::kActiveRef);
 
-    // Step 5.9: Close the page stream
+    // Step 5.9: Close the page stream.  If something else had the page open
+    // first, the read ahead copy was never taken, so let it go now.
     pageNode->CloseStream();
+    DropPrefetchedPage(page);
 
     // All done!
     kResMgrLog(1, ILog(1, "...Page in complete!"));
@@ -1283,6 +1317,28 @@ void plResManager::PageInAge(const ST::string &age)
     IterateAllPages(&iter);
 }
 
+//// PrefetchPage ////////////////////////////////////////////////////////////
+
+void plResManager::PrefetchPage(const plLocation& page)
+{
+    if (!fPrefetcher)
+        return;
+
+    plRegistryPageNode* pageNode = FindPage(page);
+    if (pageNode && !pageNode->IsNewPage())
+        fPrefetcher->Queue(pageNode->GetPagePath());
+}
+
+void plResManager::DropPrefetchedPage(const plLocation& page)
+{
+    if (!fPrefetcher)
+        return;
+
+    plRegistryPageNode* pageNode = FindPage(page);
+    if (pageNode)
+        fPrefetcher->Drop(pageNode->GetPagePath());
+}
+
 //// VerifyPages /////////////////////////////////////////////////////////////
 //  Runs through all the pages and ensures they are all up-to-date in version
 //  numbers and that no out-of-date objects exist in them
@@ -55,6 +55,7 @@ class plRegistryPageIterator;
 class plRegistryDataStream;
 class plResAgeHolder;
 class plResManagerHelper;
+class plResPrefetcher;
 class plDispatch;
 
 // plProgressProc is a proc called every time an object loads, to keep a progress bar for
@@ -139,6 +140,12 @@ public:
     void PageInRoom(const plLocation& page, uint16_t objClassToRef, plRefMsg* refMsg);
     void PageInAge(const ST::string& age);
 
+    // Starts reading a page's file in the background, ahead of it being paged in
+    void PrefetchPage(const plLocation& page);
+    // Throws away whatever was read ahead for a page.  PageInRoom does this when
+    // it's done; call it for a prefetched page that won't be paged in after all.
+    void DropPrefetchedPage(const plLocation& page);
+
     // Usually, a page file is kept open during load because the first keyed object
     // read causes all the other objects to be read before it returns.  In some
     // cases though (mostly just the texture file), this doesn't work.  In that
@@ -228,6 +235,7 @@ protected:
     plProgressProc  fProgressProc;
 
     plResManagerHelper  *fMyHelper;
+    plResPrefetcher     *fPrefetcher;
 
     bool    fLogReadTimes;
 
@@ -0,0 +1,256 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#include "plResPrefetcher.h"
+#include "hsLockGuard.h"
+
+#include <algorithm>
+#include <thread>
+
+// Enough to keep a few reads in flight without fighting the main thread for the disk
+static const unsigned kMaxWorkers = 4;
+// Pages that would push the buffered total past this are left to be mapped
+// by the page node instead
+static const size_t kMaxReadyBytes = 256 * 1024 * 1024;
+
+void plResPrefetcher::Start(unsigned numWorkers)
+{
+    if (fRunning)
+        return;
+
+    if (numWorkers == 0)
+        numWorkers = std::min(std::max(std::thread::hardware_concurrency() / 2, 1u), kMaxWorkers);
+
+    fRunning = true;
+    for (unsigned i = 0; i < numWorkers; i++)
+    {
+        Worker* worker = new Worker(this);
+        fWorkers.push_back(worker);
+        worker->Start();
+    }
+}
+
+void plResPrefetcher::Stop()
+{
+    if (!fRunning)
+        return;
+
+    {
+        hsLockGuard(fMutex);
+        fRunning = false;
+        fRequests.clear();
+    }
+
+    // Wake everyone up so they see we're done
+    for (size_t i = 0; i < fWorkers.size(); i++)
+        fPending.Signal();
+
+    for (Worker* worker : fWorkers)
+    {
+        worker->Stop();
+        delete worker;
+    }
+    fWorkers.clear();
+
+    fDropped.clear();
+    fReady.clear();
+    fReadyBytes = 0;
+}
+
+void plResPrefetcher::Queue(const plFileName& path)
+{
+    if (!fRunning || !path.IsValid())
+        return;
+
+    plFileInfo info(path);
+    {
+        hsLockGuard(fMutex);
+        if (std::find(fRequests.begin(), fRequests.end(), path) != fRequests.end())
+            return;
+
+        auto reading = std::find(fReading.begin(), fReading.end(), path);
+        if (reading != fReading.end())
+        {
+            // Wanted again after all, keep what the worker reads
+            auto dropped = std::find(fDropped.begin(), fDropped.end(), path);
+            if (dropped != fDropped.end())
+                fDropped.erase(dropped);
+            return;
+        }
+
+        PageMap::iterator it = fReady.find(path);
+        if (it != fReady.end())
+        {
+            if (it->second.IsCurrent(info))
+                return;
+            IEraseReady(it);
+        }
+        fRequests.push_back(path);
+    }
+
+    fPending.Signal();
+}
+
+bool plResPrefetcher::Take(const plFileName& path, std::vector<uint8_t>& data)
+{
+    plFileInfo info(path);
+    std::unique_lock<std::mutex> lock(fMutex);
+
+    auto queued = std::find(fRequests.begin(), fRequests.end(), path);
+    if (queued != fRequests.end())
+    {
+        fRequests.erase(queued);
+        return false;
+    }
+
+    fReadDone.wait(lock, [this, &path]() {
+        return std::find(fReading.begin(), fReading.end(), path) == fReading.end();
+    });
+
+    PageMap::iterator it = fReady.find(path);
+    if (it == fReady.end())
+        return false;
+
+    bool current = it->second.IsCurrent(info);
+    if (current)
+        data.swap(it->second.fData);
+    IEraseReady(it);
+    return current;
+}
+
+void plResPrefetcher::Drop(const plFileName& path)
+{
+    hsLockGuard(fMutex);
+
+    auto queued = std::find(fRequests.begin(), fRequests.end(), path);
+    if (queued != fRequests.end())
+        fRequests.erase(queued);
+
+    // Can't take the buffer away from a worker, have it thrown out when it's done
+    if (std::find(fReading.begin(), fReading.end(), path) != fReading.end() &&
+        std::find(fDropped.begin(), fDropped.end(), path) == fDropped.end())
+        fDropped.push_back(path);
+
+    PageMap::iterator it = fReady.find(path);
+    if (it != fReady.end())
+        IEraseReady(it);
+}
+
+void plResPrefetcher::IEraseReady(PageMap::iterator it)
+{
+    fReadyBytes -= it->second.fFileSize;
+    fReady.erase(it);
+}
+
+bool plResPrefetcher::IGetNextRequest(plFileName& path)
+{
+    hsLockGuard(fMutex);
+    if (!fRunning || fRequests.empty())
+        return false;
+
+    path = fRequests.front();
+    fRequests.pop_front();
+    fReading.push_back(path);
+    return true;
+}
+
+bool plResPrefetcher::IReadFile(const plFileName& path, Page& page)
+{
+    plFileInfo info(path);
+    int64_t size = info.FileSize();
+    if (size <= 0)
+        return false;
+
+    {
+        hsLockGuard(fMutex);
+        if (fReadyBytes + size > kMaxReadyBytes)
+            return false;
+    }
+
+    FILE* fp = plFileSystem::Open(path, "rb");
+    if (!fp)
+        return false;
+
+    page.fData.resize(size);
+    page.fFileSize = size;
+    page.fModifyTime = info.ModifyTime();
+    bool ok = fread(page.fData.data(), 1, page.fData.size(), fp) == page.fData.size();
+    fclose(fp);
+    return ok;
+}
+
+void plResPrefetcher::IFinishRequest(const plFileName& path, Page& page, bool ok)
+{
+    {
+        hsLockGuard(fMutex);
+        fReading.erase(std::find(fReading.begin(), fReading.end(), path));
+
+        auto dropped = std::find(fDropped.begin(), fDropped.end(), path);
+        if (dropped != fDropped.end())
+        {
+            fDropped.erase(dropped);
+            ok = false;
+        }
+
+        if (ok && fRunning)
+        {
+            fReadyBytes += page.fFileSize;
+            fReady[path] = std::move(page);
+        }
+    }
+    fReadDone.notify_all();
+}
+
+void plResPrefetcher::Worker::Run()
+{
+    while (fOwner->IsRunning())
+    {
+        fOwner->fPending.Wait();
+
+        plFileName path;
+        if (fOwner->IGetNextRequest(path))
+        {
+            Page page;
+            bool ok = fOwner->IReadFile(path, page);
+            fOwner->IFinishRequest(path, page, ok);
+        }
+    }
+}
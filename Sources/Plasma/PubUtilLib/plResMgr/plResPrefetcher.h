@@ -0,0 +1,140 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+#ifndef plResPrefetcher_h_inc
+#define plResPrefetcher_h_inc
+
+#include "HeadSpin.h"
+#include "hsThread.h"
+#include "plFileSystem.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+//
+// Reads page files ahead of the resManager on a small pool of worker threads,
+// so that by the time a room is actually paged in its data is already in
+// memory and the main thread isn't stuck waiting on the disk.  The page node
+// takes the buffer over with Take() and reads the page out of it directly.
+//
+// The workers only ever touch the files themselves.  Object creation, key
+// lookups and ref notifies stay on the main thread, in the order the rooms
+// were asked for.
+//
+class plResPrefetcher
+{
+protected:
+    class Worker : public hsThread
+    {
+        plResPrefetcher* fOwner;
+
+    public:
+        Worker(plResPrefetcher* owner) : fOwner(owner) { }
+        void Run() override;
+    };
+
+    // A page read ahead, along with what the file looked like when it was
+    // read so we can tell if it has been replaced since
+    struct Page
+    {
+        std::vector<uint8_t> fData;
+        int64_t     fFileSize;
+        uint64_t    fModifyTime;
+
+        Page() : fFileSize(-1), fModifyTime(0) { }
+
+        bool IsCurrent(const plFileInfo& info) const
+        {
+            return info.FileSize() == fFileSize && info.ModifyTime() == fModifyTime;
+        }
+    };
+    typedef std::map<plFileName, Page> PageMap;
+
+    std::mutex              fMutex;
+    std::condition_variable fReadDone;
+    std::deque<plFileName>  fRequests;
+    std::vector<plFileName> fReading;       // Pages the workers are reading now
+    std::vector<plFileName> fDropped;       // Pages being read that nobody wants anymore
+    PageMap                 fReady;         // Pages read and waiting to be taken
+    size_t                  fReadyBytes;
+    hsSemaphore             fPending;
+    std::atomic<bool>       fRunning;
+    std::vector<Worker*>    fWorkers;
+
+    bool IGetNextRequest(plFileName& path);
+    bool IReadFile(const plFileName& path, Page& page);
+    void IFinishRequest(const plFileName& path, Page& page, bool ok);
+    void IEraseReady(PageMap::iterator it);
+
+public:
+    plResPrefetcher() : fReadyBytes(0), fRunning(false) { }
+    ~plResPrefetcher() { Stop(); }
+
+    // Starts numWorkers threads.  Zero picks a count based on the machine.
+    void Start(unsigned numWorkers = 0);
+    // Drops anything not yet started and waits for the workers to finish
+    void Stop();
+
+    bool IsRunning() const { return fRunning; }
+
+    // Queues a page file to be read in the background.  Files already waiting
+    // in the queue are ignored, as are ones already read unless the file has
+    // changed since.
+    void Queue(const plFileName& path);
+
+    // Hands over the contents of a queued page.  Waits if a worker is in the
+    // middle of reading it; a page no worker has started on yet is dropped
+    // from the queue instead, and false is returned so the caller reads it
+    // itself.  Either way the file is never read twice.  Data for a file that
+    // has changed since it was read is thrown out rather than handed over.
+    bool Take(const plFileName& path, std::vector<uint8_t>& data);
+
+    // Forgets a page, whether it is queued, being read or waiting to be taken.
+    // Call once the page has been loaded (or failed to) so a buffer that was
+    // never taken doesn't sit around counting against the read ahead limit.
+    void Drop(const plFileName& path);
+};
+
+#endif // plResPrefetcher_h_inc
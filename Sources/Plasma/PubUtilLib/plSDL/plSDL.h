@@ -47,8 +47,12 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 //
 
 #include <list>
+#include <unordered_map>
+#include <vector>
 #include <string_theory/format>
 
+#include "hsBitVector.h"
+
 #include "plSDLDescriptor.h"
 
 #include "pnFactory/plCreatable.h"
@@ -74,6 +78,7 @@ namespace plSDL
         kSameAsDefault  = 0x8,
         kHasDirtyFlag   = 0x10,
         kWantTimeStamp  = 0x20,
+        kHasElementDeltas = 0x40,   // only the changed array elements follow
 
         kAddedVarLengthIO = 0x8000,     // using to establish a new version in the header, can delete in 8/03
         
@@ -93,6 +98,8 @@ namespace plSDL
         kMakeDirty              = 1<< 8,            // read/write: set dirty flag on var read/write. 
         kDirtyNonDefaults       = 1<< 9,            // dirty the var if non default value.
         kForceConvert           = 1<<10,            // always try to convert rec to latest on read
+        kDeltaEncode            = 1<<11,            // read/write: bitmask of the vars that follow, and only the changed elements of arrays.
+                                                    // only used with a server that accepts it, see plNetMsgSDLState::IsDeltaState
     };
 
     enum BehaviorFlags
@@ -129,7 +136,8 @@ public:
     enum Flags
     {
         kDirty  = 0x1,  // true when someone sets the value using Set(...), can be cleared after writing
-        kUsed   = 0x2   // true when it contains some value (either by Set(...) or Read() ) 
+        kUsed   = 0x2,  // true when it contains some value (either by Set(...) or Read() ) 
+        kElementDelta = 0x4 // only the array elements in the change mask have changed (on a received var, only they are set)
     };
 protected:
     uint32_t fFlags;
@@ -232,6 +240,8 @@ protected:
 
     typedef std::vector<plStateChangeNotifier> StateChangeNotifiers;
     StateChangeNotifiers fChangeNotifiers;
+    hsBitVector fChangedElements;   // valid when kElementDelta is set
+    uint32_t fDeltaBaseline;        // checksum of the value the deltas were taken against
 
     void IDeAlloc();
     void IInit();   // initize vars
@@ -252,6 +262,11 @@ protected:
 
     bool IReadData(hsStream* s, float timeConvert, int idx, uint32_t readOptions);    
     bool IWriteData(hsStream* s, float timeConvert, int idx, uint32_t writeOptions) const;
+    bool IReadElementDeltas(hsStream* s, float timeConvert, uint32_t readOptions);
+    bool IWriteElementDeltas(hsStream* s, float timeConvert, uint32_t writeOptions) const;
+    bool IElementEquals(const plSimpleStateVariable& other, int idx) const;
+    void ICopyElement(const plSimpleStateVariable& other, int idx);
+    uint32_t IGetElementsChecksum() const;
 
 public:
 
@@ -318,6 +333,12 @@ public:
     void RemoveStateChangeNotification(plStateChangeNotifier n);    // remove ones which match
     void NotifyStateChange(const plSimpleStateVariable* other, const ST::string& sdlName);      // send notification msg if necessary, internal use
 
+    // Element deltas
+    bool HasElementDeltas() const { return (fFlags & kElementDelta) != 0; }
+    void FlagDifferentElements(const plSimpleStateVariable& other);     // build the change mask of a dirty array against 'other'
+    bool ResolveElementDeltas(const plSimpleStateVariable& base);       // fill in the unchanged elements from 'base', false if it isn't our baseline
+    void ClearElementDeltas();                                          // forget the change mask
+
     void DumpToObjectDebugger(bool dirtyOnly, int level) const;
     void DumpToStream(hsStream* stream, bool dirtyOnly, int level) const;
 
@@ -427,6 +448,9 @@ protected:
     int IGetNumDirtyVars(const VarsList& vars) const;
     int IGetDirtyVars(const VarsList& varsOut, VarsList *varsIn) const; // build a list of vars that are dirty
     bool IHasDirtyVars(const VarsList& vars) const;
+
+    void IWriteVarsMask(hsStream* s, const VarsList& vars, bool dirtyOnly) const;
+    void IReadVarsMask(hsStream* s, const VarsList& vars, std::vector<int>* idxs) const;
 public:
     CLASSNAME_REGISTER( plStateDataRecord );
     GETINTERFACE_ANY( plStateDataRecord, plCreatable);
@@ -492,6 +516,9 @@ public:
     void FlagDifferentState(const plStateDataRecord& other);    // mark items which differ from 'other' as dirty
     void FlagNewerState(const plStateDataRecord& other, bool respectAlwaysNew=false);   // mark items which are newer than 'other' as dirty
     void FlagAlwaysNewState();  // mark 'alwaysNew' items as dirty
+    bool HasElementDeltas() const;  // true if any array var only carries its changed elements
+    bool ResolveElementDeltas(const plStateDataRecord& base);  // fill in unchanged array elements from 'base', dropping vars it can't resolve
+    void ClearElementDeltas();  // forget the change masks of the vars
     void DumpToObjectDebugger(const char* msg, bool dirtyOnly=false, int level=0) const;
     void DumpToStream(hsStream* stream, const char* msg, bool dirtyOnly=false, int level=0) const;
 
@@ -507,15 +534,20 @@ public:
 // Simple SDL parser
 //
 class plSDLMgr;
+class plMD5Checksum;
 class plSDLParser
 {
 private:
     bool IReadDescriptors() const;
-    bool ILoadSDLFile(const plFileName& fileName) const;
+    bool ILoadSDLFile(const plFileName& fileName, plSDL::DescriptorList& descList) const;
+    void IAddDescriptors(const plFileName& fileName, plSDL::DescriptorList& descList) const;
+    void IHashSources(const std::vector<plFileName>& files, plMD5Checksum& sourceHash) const;
+    bool IReadCache(const plFileName& cacheFile, const plMD5Checksum& sourceHash) const;
+    void IWriteCache(const plFileName& cacheFile, const plMD5Checksum& sourceHash) const;
     bool IParseVarDesc(const plFileName& fileName, hsStream* stream, char token[],
                        plStateDescriptor*& curDesc, plVarDescriptor*& curVar) const;
     bool IParseStateDesc(const plFileName& fileName, hsStream* stream, char token[],
-                         plStateDescriptor*& curDesc) const;
+                         plStateDescriptor*& curDesc, plSDL::DescriptorList& descList) const;
 
     void DebugMsg(const ST::string& msg) const;
 
@@ -544,12 +576,24 @@ class plSDLMgr
 {
     friend class plSDLParser;
 private:
+    // Every version of one descriptor, oldest first
+    struct DescriptorVersions
+    {
+        std::vector<plStateDescriptor*> fVersions;
+        plStateDescriptor* fLatest;
+
+        DescriptorVersions() : fLatest(nil) { }
+    };
+    typedef std::unordered_map<ST::string, DescriptorVersions, ST::hash_i, ST::equal_i> DescriptorIndex;
+
     plFileName  fSDLDir;
     plSDL::DescriptorList fDescriptors;
+    DescriptorIndex fDescriptorIndex;   // fDescriptors by name
     plNetApp*   fNetApp;
     uint32_t    fBehaviorFlags;
 
     void IDeleteDescriptors(plSDL::DescriptorList* dl);
+    void IAddDescriptor(plStateDescriptor* sd);
 public:
     plSDLMgr();
     ~plSDLMgr();
@@ -86,6 +86,27 @@ void plSDLMgr::IDeleteDescriptors(plSDL::DescriptorList* dl)
         [](plStateDescriptor* sd) { delete sd; }
     );
     dl->clear();
+
+    if (dl == &fDescriptors)
+        fDescriptorIndex.clear();
+}
+
+//
+// add a descriptor to the list and the name index
+//
+void plSDLMgr::IAddDescriptor(plStateDescriptor* sd)
+{
+    fDescriptors.push_back(sd);
+
+    DescriptorVersions& entry = fDescriptorIndex[sd->GetName()];
+    auto pos = std::upper_bound(entry.fVersions.begin(), entry.fVersions.end(), sd,
+        [](const plStateDescriptor* a, const plStateDescriptor* b) { return a->GetVersion() < b->GetVersion(); }
+    );
+    entry.fVersions.insert(pos, sd);
+
+    // first one in wins a tie, same as a search of the list would find
+    if (!entry.fLatest || sd->GetVersion() > entry.fLatest->GetVersion())
+        entry.fLatest = sd;
 }
 
 
@@ -107,8 +128,23 @@ plStateDescriptor* plSDLMgr::FindDescriptor(const ST::string& name, int version,
     if (name.empty())
         return nil;
 
-    if ( !dl )
-        dl = &fDescriptors;
+    if ( !dl || dl == &fDescriptors )
+    {
+        DescriptorIndex::const_iterator found = fDescriptorIndex.find(name);
+        if (found == fDescriptorIndex.end())
+            return nil;
+
+        const DescriptorVersions& entry = found->second;
+        if (version == plSDL::kLatestVersion)
+            return entry.fLatest;
+
+        auto it = std::lower_bound(entry.fVersions.begin(), entry.fVersions.end(), version,
+            [](const plStateDescriptor* sd, int v) { return sd->GetVersion() < v; }
+        );
+        if (it != entry.fVersions.end() && (*it)->GetVersion() == version)
+            return *it;
+        return nil;
+    }
 
     plStateDescriptor* sd = nil;
 
@@ -187,7 +223,12 @@ int plSDLMgr::Read(hsStream* s, plSDL::DescriptorList* dl)
         {
             plStateDescriptor* sd=new plStateDescriptor;
             if (sd->Read(s))
-                dl->push_back(sd);
+            {
+                if (dl == &fDescriptors)
+                    IAddDescriptor(sd);
+                else
+                    dl->push_back(sd);
+            }
             else
                 delete sd; // well that sucked
         }
@@ -40,13 +40,24 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 *==LICENSE==*/
 #include "HeadSpin.h"
+#include "hsJobSystem.h"
+#include "hsStream.h"
+#include "hsStringTokenizer.h"
 #include "plSDL.h"
 #include "plFile/plStreamSource.h"
+#include "pnEncryption/plChecksum.h"
 #include "pnNetCommon/pnNetCommon.h"
 #include "pnNetCommon/plNetApp.h"
 
+#include <algorithm>
+
 static const int kTokenLen=256;
 
+// Binary cache of the parsed descriptors, in the user data directory
+static const char kCacheFileName[] = "SDLDescriptors.cache";
+static const uint32_t kCacheMagic = 0x4C445343;     // 'CSDL'
+static const uint32_t kCacheVersion = 1;
+
 void plSDLParser::DebugMsg(const ST::string& msg) const
 {
     return;
@@ -64,10 +75,8 @@ void plSDLParser::DebugMsg(const ST::string& msg) const
 // return true to skip the next token read
 //
 bool plSDLParser::IParseStateDesc(const plFileName& fileName, hsStream* stream, char token[],
-                                  plStateDescriptor*& curDesc) const
+                                  plStateDescriptor*& curDesc, plSDL::DescriptorList& descList) const
 {   
-    plSDL::DescriptorList* descList = &plSDLMgr::GetInstance()->fDescriptors;
-
     bool ok = true;
 
     //
@@ -115,21 +124,11 @@ bool plSDLParser::IParseStateDesc(const plFileName& fileName, hsStream* stream,
         ok = false;
     }
 
+    // Duplicates are caught when the file's descriptors are added to the
+    // manager, since other files may be parsing alongside this one
     if ( ok )
     {
-        ok = ( plSDLMgr::GetInstance()->FindDescriptor(curDesc->GetName(), curDesc->GetVersion())==nil );
-        if ( !ok )
-        {
-            ST::string err = ST::format("Found duplicate SDL descriptor for {} version {}.\nFailed to parse file: {}",
-                                        curDesc->GetName(), curDesc->GetVersion(), fileName);
-            plNetApp::StaticErrorMsg(err);
-            hsAssert( false, err.c_str() );
-        }
-    }
-
-    if ( ok )
-    {
-        descList->push_back(curDesc);
+        descList.push_back(curDesc);
     }
     else
     {
@@ -163,12 +162,8 @@ bool plSDLParser::IParseVarDesc(const plFileName& fileName, hsStream* stream, ch
     //
     if (*token == '$')
     {
-        // nested sdls
-        char* sdlName = token+1;
-        plStateDescriptor* stateDesc = plSDLMgr::GetInstance()->FindDescriptor(sdlName, plSDL::kLatestVersion);
-        hsAssert(stateDesc, ST::format("can't find nested state desc reference {}, fileName={}",
-                 sdlName, fileName).c_str());
-        curVar = new plSDVarDescriptor(stateDesc);
+        // nested sdls, resolved by IAddDescriptors just before the descriptor is added
+        curVar = new plSDVarDescriptor;
     }
     else
         curVar = new plSimpleVarDescriptor;
@@ -186,14 +181,16 @@ bool plSDLParser::IParseVarDesc(const plFileName& fileName, hsStream* stream, ch
     {
         hsAssert(strstr(token, "[") != nullptr && strstr(token, "]") != nullptr,
                  ST::format("invalid var syntax, missing [x], fileName={}", fileName).c_str());
-        (void)strtok( token, seps );  // skip [
+        // files are parsed in parallel, so no strtok here
+        hsStringTokenizer toker(token, seps);
+        char* nameTok=toker.next();         // skip [
         
         hsAssert(curVar, ST::format("Missing current var.  Syntax problem with .sdl file, fileName={}", fileName).c_str());
-        curVar->SetName(token);
+        curVar->SetName(nameTok);
         //
         // COUNT
         //
-        char* cntTok=strtok(nil, seps);     // kill ]
+        char* cntTok=toker.next();          // kill ]
         int cnt = cntTok ? atoi(cntTok) : 0;
         curVar->SetCount(cnt);
         if (cnt==0)
@@ -306,7 +303,7 @@ bool plSDLParser::IParseVarDesc(const plFileName& fileName, hsStream* stream, ch
 // create state descriptor from sdl file.
 // return false on err.
 //
-bool plSDLParser::ILoadSDLFile(const plFileName& fileName) const
+bool plSDLParser::ILoadSDLFile(const plFileName& fileName, plSDL::DescriptorList& descList) const
 {
     DebugMsg("Parsing SDL file {}", fileName);
 
@@ -354,7 +351,7 @@ bool plSDLParser::ILoadSDLFile(const plFileName& fileName) const
 
         if (parsingStateDesc)
         {
-            skip=IParseStateDesc(fileName, stream, token, curDesc);
+            skip=IParseStateDesc(fileName, stream, token, curDesc, descList);
             if ( !curDesc )
                 break;  // failed to parse state desc
         }
@@ -372,6 +369,166 @@ bool plSDLParser::ILoadSDLFile(const plFileName& fileName) const
     return true;
 }
 
+//
+// add the descriptors parsed from one file to the manager, in file order,
+// and hook up their nested descriptor references.
+// this is what parsing the files one after another used to do as it went.
+//
+void plSDLParser::IAddDescriptors(const plFileName& fileName, plSDL::DescriptorList& descList) const
+{
+    plSDLMgr* mgr = plSDLMgr::GetInstance();
+
+    while (!descList.empty())
+    {
+        plStateDescriptor* curDesc = descList.front();
+        descList.pop_front();
+
+        if (mgr->FindDescriptor(curDesc->GetName(), curDesc->GetVersion()))
+        {
+            ST::string err = ST::format("Found duplicate SDL descriptor for {} version {}.\nFailed to parse file: {}",
+                                        curDesc->GetName(), curDesc->GetVersion(), fileName);
+            plNetApp::StaticErrorMsg(err);
+            hsAssert( false, err.c_str() );
+
+            // the rest of the file is abandoned, as before
+            delete curDesc;
+            std::for_each(descList.begin(), descList.end(), [](plStateDescriptor* sd) { delete sd; });
+            descList.clear();
+            break;
+        }
+
+        // resolve nested references before adding this descriptor, as the old
+        // parser did, so a reference can't resolve to the descriptor itself
+        for (int i = 0; i < curDesc->GetNumVars(); i++)
+        {
+            plSDVarDescriptor* sdVar = curDesc->GetVar(i)->GetAsSDVarDescriptor();
+            if (!sdVar)
+                continue;
+
+            ST::string sdlName = sdVar->GetTypeString().substr(1);  // skip '$'
+            plStateDescriptor* stateDesc = mgr->FindDescriptor(sdlName, plSDL::kLatestVersion);
+            hsAssert(stateDesc, ST::format("can't find nested state desc reference {}, fileName={}",
+                     sdlName, fileName).c_str());
+            sdVar->SetStateDesc(stateDesc);
+        }
+
+        mgr->IAddDescriptor(curDesc);
+    }
+}
+
+//
+// hash the names and contents of all the sdl files, in the order they are parsed
+//
+void plSDLParser::IHashSources(const std::vector<plFileName>& files, plMD5Checksum& sourceHash) const
+{
+    sourceHash.Start();
+
+    std::vector<uint8_t> buf;
+    for (const plFileName& fileName : files)
+    {
+        ST::string name = fileName.GetFileName();
+        sourceHash.AddTo(name.size() + 1, (const uint8_t*)name.c_str());
+
+        hsStream* stream = plStreamSource::GetInstance()->GetFile(fileName);
+        if (!stream)
+            continue;
+
+        stream->Rewind();
+        buf.resize(stream->GetEOF());
+        if (!buf.empty())
+            sourceHash.AddTo(stream->Read(buf.size(), buf.data()), buf.data());
+        stream->Rewind();
+    }
+
+    sourceHash.Finish();
+}
+
+//
+// load the descriptors from the binary cache, if it was built from the same sources.
+// return false if the cache is missing or stale
+//
+bool plSDLParser::IReadCache(const plFileName& cacheFile, const plMD5Checksum& sourceHash) const
+{
+    hsMappedStream stream;
+    if (!stream.Open(cacheFile, "rb"))
+        return false;
+
+    plSDLMgr* mgr = plSDLMgr::GetInstance();
+
+    bool ok = false;
+    try
+    {
+        uint8_t hash[MD5_DIGEST_LENGTH];
+        if (stream.ReadLE32() == kCacheMagic && stream.ReadLE32() == kCacheVersion)
+        {
+            stream.Read(sizeof(hash), hash);
+            if (memcmp(hash, sourceHash.GetValue(), sizeof(hash)) == 0 && mgr->Read(&stream) > 0)
+            {
+                // Write/Read don't carry the source file names, so they follow the descriptors
+                uint16_t numNames = stream.ReadLE16();
+                ok = (numNames == mgr->fDescriptors.size());
+                for (plStateDescriptor* sd : mgr->fDescriptors)
+                {
+                    if (!ok)
+                        break;
+                    sd->SetFilename(stream.ReadSafeString());
+                }
+                ok = ok && stream.ReadLE32() == kCacheMagic;
+            }
+        }
+    }
+    catch (...)
+    {
+        ok = false;
+    }
+
+    if (!ok)
+        mgr->IDeleteDescriptors(&mgr->fDescriptors);
+
+    stream.Close();
+    return ok;
+}
+
+//
+// save the parsed descriptors so the next run can skip parsing
+//
+void plSDLParser::IWriteCache(const plFileName& cacheFile, const plMD5Checksum& sourceHash) const
+{
+    plSDLMgr* mgr = plSDLMgr::GetInstance();
+
+    // nested vars are written by their descriptor's name, so a reference that
+    // never resolved can't be cached.  parse again next time instead.
+    for (const plStateDescriptor* sd : mgr->fDescriptors)
+    {
+        for (int i = 0; i < sd->GetNumVars(); i++)
+        {
+            plSDVarDescriptor* sdVar = sd->GetVar(i)->GetAsSDVarDescriptor();
+            if (sdVar && !sdVar->GetStateDescriptor())
+            {
+                DebugMsg("SDL: Not caching descriptors, {} has an unresolved nested var {}",
+                         sd->GetName(), sdVar->GetName());
+                return;
+            }
+        }
+    }
+
+    hsUNIXStream stream;
+    if (!stream.Open(cacheFile, "wb"))
+        return;
+
+    stream.WriteLE32(kCacheMagic);
+    stream.WriteLE32(kCacheVersion);
+    stream.Write(sourceHash.GetSize(), sourceHash.GetValue());
+    mgr->Write(&stream);
+
+    stream.WriteLE16(uint16_t(mgr->fDescriptors.size()));
+    for (const plStateDescriptor* sd : mgr->fDescriptors)
+        stream.WriteSafeString(sd->GetFilename().AsString());
+    stream.WriteLE32(kCacheMagic);
+
+    stream.Close();
+}
+
 //
 // load all .sdl files in sdl directory, and create descriptors for each.
 // return false on error
@@ -384,11 +541,32 @@ bool plSDLParser::IReadDescriptors() const
     // Get the names of all the sdl files
     std::vector<plFileName> files = plStreamSource::GetInstance()->GetListOfNames(sdlDir, "sdl");
 
+    // If none of them have changed since last time, skip parsing entirely
+    plMD5Checksum sourceHash;
+    IHashSources(files, sourceHash);
+    plFileName cacheFile = plFileName::Join(plFileSystem::GetUserDataPath(), kCacheFileName);
+    if (IReadCache(cacheFile, sourceHash))
+    {
+        DebugMsg("SDL: Read {} descriptors from cache", plSDLMgr::GetInstance()->fDescriptors.size());
+        return true;
+    }
+
+    // Tokenizing is the slow part and each file stands alone, so parse them
+    // all at once, then add the results in order.
+    std::vector<plSDL::DescriptorList> parsed(files.size());
+    std::vector<uint8_t> loaded(files.size(), 0);
+    hsJobSystem::ParallelFor(0, files.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            loaded[i] = ILoadSDLFile(files[i], parsed[i]);
+    });
+
     bool ret=true;
     int cnt=0;
     for (int i = 0; i < files.size(); i++)
     {
-        if (!ILoadSDLFile(files[i]))
+        IAddDescriptors(files[i], parsed[i]);
+
+        if (!loaded[i])
         {
             plNetApp* netApp = plSDLMgr::GetInstance()->GetNetApp();
             if (netApp)
@@ -405,6 +583,9 @@ bool plSDLParser::IReadDescriptors() const
     if (!cnt)
         ret=false;
 
+    if (ret)
+        IWriteCache(cacheFile, sourceHash);
+
     return ret;
 }
 
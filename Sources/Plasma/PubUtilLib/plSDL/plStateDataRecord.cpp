@@ -249,8 +249,17 @@ bool plStateDataRecord::Read(hsStream* s, float timeConvert, uint32_t readOption
     if (!fDescriptor)
         return false;
 
+    bool deltaEncoded = (readOptions & plSDL::kDeltaEncode) != 0;
+    std::vector<int> maskIdxs;
+
     int num;
-    plSDL::VariableLengthRead(s, fDescriptor->GetNumVars(), &num );
+    if (deltaEncoded)
+    {
+        IReadVarsMask(s, fVarsList, &maskIdxs);
+        num = maskIdxs.size();
+    }
+    else
+        plSDL::VariableLengthRead(s, fDescriptor->GetNumVars(), &num );
 
     // if we are readeing the entire list, we don't need to read each index
     bool all = (num==fVarsList.size());
@@ -261,7 +270,9 @@ bool plStateDataRecord::Read(hsStream* s, float timeConvert, uint32_t readOption
         for(i=0;i<num;i++)
         {
             int idx;
-            if (!all)
+            if (deltaEncoded)
+                idx=maskIdxs[i];
+            else if (!all)
                 plSDL::VariableLengthRead(s, fDescriptor->GetNumVars(), &idx );
             else
                 idx=i;
@@ -292,7 +303,13 @@ bool plStateDataRecord::Read(hsStream* s, float timeConvert, uint32_t readOption
     //
     // read nested var data
     //
-    plSDL::VariableLengthRead(s, fDescriptor->GetNumVars(), &num );
+    if (deltaEncoded)
+    {
+        IReadVarsMask(s, fSDVarsList, &maskIdxs);
+        num = maskIdxs.size();
+    }
+    else
+        plSDL::VariableLengthRead(s, fDescriptor->GetNumVars(), &num );
 
     // if we are readeing the entire list, we don't need to write each index
     all = (num==fSDVarsList.size());
@@ -302,7 +319,9 @@ bool plStateDataRecord::Read(hsStream* s, float timeConvert, uint32_t readOption
         for(i=0;i<num;i++)
         {
             int idx;
-            if (!all)
+            if (deltaEncoded)
+                idx=maskIdxs[i];
+            else if (!all)
                 plSDL::VariableLengthRead(s, fDescriptor->GetNumVars(), &idx );
             else
                 idx=i;
@@ -365,11 +384,15 @@ void plStateDataRecord::Write(hsStream* s, float timeConvert, uint32_t writeOpti
     // write simple vars
     //
     bool dirtyOnly = (writeOptions & plSDL::kDirtyOnly) != 0;
+    bool deltaEncode = (writeOptions & plSDL::kDeltaEncode) != 0;
     int num = dirtyOnly ? GetNumDirtyVars() : GetNumUsedVars();
-    plSDL::VariableLengthWrite(s, fDescriptor->GetNumVars(), num ); // write affected vars count
+    if (deltaEncode)
+        IWriteVarsMask(s, fVarsList, dirtyOnly);                        // write affected vars mask
+    else
+        plSDL::VariableLengthWrite(s, fDescriptor->GetNumVars(), num ); // write affected vars count
 
     // if we are writing he entire list, we don't need to write each index
-    bool all = (num==fVarsList.size());
+    bool all = deltaEncode || (num==fVarsList.size());
 
     int i;
     for(i=0;i<fVarsList.size(); i++)
@@ -387,10 +410,13 @@ void plStateDataRecord::Write(hsStream* s, float timeConvert, uint32_t writeOpti
     // write nested vars
     //
     num = dirtyOnly ? GetNumDirtySDVars() : GetNumUsedSDVars();
-    plSDL::VariableLengthWrite(s, fDescriptor->GetNumVars(), num ); // write affected vars count
+    if (deltaEncode)
+        IWriteVarsMask(s, fSDVarsList, dirtyOnly);                      // write affected vars mask
+    else
+        plSDL::VariableLengthWrite(s, fDescriptor->GetNumVars(), num ); // write affected vars count
 
     // if we are writing he entire list, we don't need to write each index
-    all = (num==fSDVarsList.size());
+    all = deltaEncode || (num==fSDVarsList.size());
 
     for(i=0;i<fSDVarsList.size(); i++)
     {
@@ -404,6 +430,37 @@ void plStateDataRecord::Write(hsStream* s, float timeConvert, uint32_t writeOpti
     }
 }
 
+//
+// one bit per var, set for each var whose data follows
+//
+void plStateDataRecord::IWriteVarsMask(hsStream* s, const VarsList& vars, bool dirtyOnly) const
+{
+    for (size_t i = 0; i < vars.size(); i += 8)
+    {
+        uint8_t bits = 0;
+        for (size_t j = i; j < vars.size() && j < i + 8; j++)
+        {
+            if ( (dirtyOnly && vars[j]->IsDirty()) || (!dirtyOnly && vars[j]->IsUsed()) )
+                bits |= (1 << (j - i));
+        }
+        s->WriteByte(bits);
+    }
+}
+
+void plStateDataRecord::IReadVarsMask(hsStream* s, const VarsList& vars, std::vector<int>* idxs) const
+{
+    idxs->clear();
+    for (size_t i = 0; i < vars.size(); i += 8)
+    {
+        uint8_t bits = s->ReadByte();
+        for (size_t j = i; j < vars.size() && j < i + 8; j++)
+        {
+            if (bits & (1 << (j - i)))
+                idxs->push_back(j);
+        }
+    }
+}
+
 //
 // STATIC - read prefix header.  returns true on success 
 //
@@ -524,6 +581,11 @@ void plStateDataRecord::UpdateFrom(const plStateDataRecord& other, uint32_t writ
     {
         if ( (dirtyOnly && other.GetVar(i)->IsDirty()) || (!dirtyOnly && other.GetVar(i)->IsUsed()) )
         {
+            // a received delta only holds some of its elements, resolve it first
+            hsAssert(!other.GetVar(i)->HasElementDeltas(), "updating from SDL var with unresolved element deltas");
+            if (other.GetVar(i)->HasElementDeltas())
+                continue;
+
             GetVar(i)->NotifyStateChange(other.GetVar(i), GetDescriptor()->GetName());  // see if there is enough difference to send state chg notification
             GetVar(i)->CopyData(other.GetVar(i), writeOptions );    // simple vars get copied completely, non-partial
         }
@@ -549,6 +611,7 @@ void plStateDataRecord::FlagDifferentState(const plStateDataRecord& other)
         {
             bool diff = (GetVar(i)->IsUsed() && ! (*other.GetVar(i) == *GetVar(i)) );
             GetVar(i)->SetDirty(diff);
+            GetVar(i)->FlagDifferentElements(*other.GetVar(i));
         }
 
         for(i=0;i<other.GetNumSDVars();i++)
@@ -565,6 +628,55 @@ void plStateDataRecord::FlagDifferentState(const plStateDataRecord& other)
     }
 }
 
+bool plStateDataRecord::HasElementDeltas() const
+{
+    for (const plStateVariable* var : fVarsList)
+    {
+        if (((const plSimpleStateVariable*)var)->HasElementDeltas())
+            return true;
+    }
+    return false;
+}
+
+//
+// fill in the array elements a delta encoded record didn't carry from 'base'.
+// Vars whose baseline doesn't match 'base' can't be completed, so they are
+// marked unused and false is returned; the caller should get the full state.
+//
+bool plStateDataRecord::ResolveElementDeltas(const plStateDataRecord& base)
+{
+    bool sameDesc = (base.GetDescriptor()==fDescriptor);
+    bool resolved = true;
+
+    int i;
+    for(i=0;i<GetNumVars();i++)
+    {
+        plSimpleStateVariable* var = GetVar(i);
+        if (!var->HasElementDeltas())
+            continue;
+
+        if (!sameDesc || !var->ResolveElementDeltas(*base.GetVar(i)))
+        {
+            var->ClearElementDeltas();
+            var->SetUsed(false);
+            var->SetDirty(false);
+            resolved = false;
+        }
+    }
+    return resolved;
+}
+
+//
+// forget the change masks built by FlagDifferentState once they are sent,
+// the vars themselves hold complete values
+//
+void plStateDataRecord::ClearElementDeltas()
+{
+    int i;
+    for(i=0;i<GetNumVars();i++)
+        GetVar(i)->ClearElementDeltas();
+}
+
 //
 // dirty my items which are flagged as alwaysNew.
 //
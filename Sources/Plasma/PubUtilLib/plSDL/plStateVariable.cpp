@@ -169,6 +169,7 @@ void plSimpleStateVariable::IInit()
     fS32=nil;
     fC=nil;
     fT=nil;
+    fDeltaBaseline=0;
     fTimeStamp.ToEpoch();   
 }
 
@@ -1983,6 +1984,7 @@ bool plSimpleStateVariable::WriteData(hsStream* s, float timeConvert, uint32_t w
     bool forceDirtyFlags = (writeOptions & plSDL::kMakeDirty)!=0;
     bool wantTimeStamp   = (writeOptions & plSDL::kTimeStampOnRead)!=0;
     bool needTimeStamp   = (writeOptions & plSDL::kTimeStampOnWrite)!=0;
+    bool elementDeltas   = !sameAsDefaults && HasElementDeltas() && (writeOptions & plSDL::kDeltaEncode)!=0;
     forceDirtyFlags = forceDirtyFlags || (!sameAsDefaults && (writeOptions & plSDL::kDirtyNonDefaults)!=0);
 
     // write save flags
@@ -1991,6 +1993,7 @@ bool plSimpleStateVariable::WriteData(hsStream* s, float timeConvert, uint32_t w
     saveFlags |= forceDirtyFlags || (writeDirtyFlags && IsDirty()) ? plSDL::kHasDirtyFlag : 0;
     saveFlags |= wantTimeStamp ? plSDL::kWantTimeStamp : 0;
     saveFlags |= needTimeStamp ? plSDL::kHasTimeStamp : 0;
+    saveFlags |= elementDeltas ? plSDL::kHasElementDeltas : 0;
 
     if (sameAsDefaults)
         saveFlags |= plSDL::kSameAsDefault;
@@ -2007,6 +2010,9 @@ bool plSimpleStateVariable::WriteData(hsStream* s, float timeConvert, uint32_t w
     }
 
     // write var data
+    if (elementDeltas)
+        return IWriteElementDeltas(s, timeConvert, writeOptions);
+
     if (!sameAsDefaults)
     {
         // list size
@@ -2078,7 +2084,12 @@ bool plSimpleStateVariable::ReadData(hsStream* s, float timeConvert, uint32_t re
         TimeStamp(ut);
 
     // read list
-    if (!(saveFlags & plSDL::kSameAsDefault))
+    if (saveFlags & plSDL::kHasElementDeltas)
+    {
+        if (!IReadElementDeltas(s, timeConvert, readOptions))
+            return false;
+    }
+    else if (!(saveFlags & plSDL::kSameAsDefault))
     {
         int i;
         for(i=0;i<fVar.GetCount();i++)
@@ -2094,11 +2105,22 @@ bool plSimpleStateVariable::ReadData(hsStream* s, float timeConvert, uint32_t re
     SetUsed( true );
     SetDirty( setDirty );
 
+    // only the changed elements are set until ResolveElementDeltas fills in the rest
+    if (saveFlags & plSDL::kHasElementDeltas)
+        fFlags |= kElementDelta;
+    else
+        fFlags &= ~kElementDelta;
+
     return true;
 }
 
 void plSimpleStateVariable::CopyData(const plSimpleStateVariable* other, uint32_t writeOptions/*=0*/)
 {
+    // a received delta only holds some of its elements, resolve it first
+    hsAssert(!other->HasElementDeltas(), "copying SDL var with unresolved element deltas");
+    if (other->HasElementDeltas())
+        return;
+
     // use stream as a medium
     hsRAMStream stream;
     other->WriteData(&stream, 0, writeOptions);
@@ -2106,6 +2128,148 @@ void plSimpleStateVariable::CopyData(const plSimpleStateVariable* other, uint32_
     ReadData(&stream, 0, writeOptions);
 }
 
+//
+// write the changed elements as runs of (start, length) followed by their data
+//
+bool plSimpleStateVariable::IWriteElementDeltas(hsStream* s, float timeConvert, uint32_t writeOptions) const
+{
+    int cnt = fVar.GetCount();
+
+    std::vector<std::pair<int, int>> runs;
+    int i;
+    for (i = 0; i < cnt; )
+    {
+        if (!fChangedElements.IsBitSet(i))
+        {
+            i++;
+            continue;
+        }
+        int start = i;
+        while (i < cnt && fChangedElements.IsBitSet(i))
+            i++;
+        runs.emplace_back(start, i - start);
+    }
+
+    s->WriteLE32(fDeltaBaseline);
+    plSDL::VariableLengthWrite(s, cnt, runs.size());
+    for (const auto& run : runs)
+    {
+        plSDL::VariableLengthWrite(s, cnt, run.first);
+        plSDL::VariableLengthWrite(s, cnt, run.second);
+        for (i = run.first; i < run.first + run.second; i++)
+            if (!IWriteData(s, timeConvert, i, writeOptions))
+                return false;
+    }
+    return true;
+}
+
+bool plSimpleStateVariable::IReadElementDeltas(hsStream* s, float timeConvert, uint32_t readOptions)
+{
+    int cnt = fVar.GetCount();
+    fChangedElements.Clear();
+
+    fDeltaBaseline = s->ReadLE32();
+
+    int numRuns;
+    plSDL::VariableLengthRead(s, cnt, &numRuns);
+    for (int r = 0; r < numRuns; r++)
+    {
+        int start, len;
+        plSDL::VariableLengthRead(s, cnt, &start);
+        plSDL::VariableLengthRead(s, cnt, &len);
+        if (start + len > cnt)
+            return false;
+
+        for (int i = start; i < start + len; i++)
+        {
+            if (!IReadData(s, timeConvert, i, readOptions))
+                return false;
+            fChangedElements.SetBit(i);
+        }
+    }
+    return true;
+}
+
+//
+// Flag the elements of a dirty array which differ from 'other'.
+// Only fixed size arrays which 'other' has a value for can be sent as deltas.
+//
+void plSimpleStateVariable::FlagDifferentElements(const plSimpleStateVariable& other)
+{
+    fFlags &= ~kElementDelta;
+    fChangedElements.Clear();
+
+    if (!IsDirty() || !other.IsUsed() || GetCount() < 2 || other.GetCount() != GetCount() ||
+        fVar.IsVariableLength() || fVar.GetAtomicType() == plVarDescriptor::kCreatable)
+        return;
+
+    int i;
+    for (i = 0; i < GetCount(); i++)
+        if (!IElementEquals(other, i))
+            fChangedElements.SetBit(i);
+    fDeltaBaseline = other.IGetElementsChecksum();
+    fFlags |= kElementDelta;
+}
+
+//
+// A received var with element deltas only holds the changed elements,
+// copy the rest from the last known value.  That only works if it is the
+// value the sender diffed against; anything else (we joined late, weren't
+// relevant, missed an update) and nothing is copied and false is returned.
+//
+bool plSimpleStateVariable::ResolveElementDeltas(const plSimpleStateVariable& base)
+{
+    if (!HasElementDeltas())
+        return true;
+
+    if (!base.IsUsed() || base.GetCount() != GetCount() ||
+        base.IGetElementsChecksum() != fDeltaBaseline)
+        return false;
+
+    int i;
+    for (i = 0; i < GetCount(); i++)
+        if (!fChangedElements.IsBitSet(i))
+            ICopyElement(base, i);
+    fFlags &= ~kElementDelta;
+    return true;
+}
+
+//
+// Drop the change mask.  A var we sent still holds its whole value; the data
+// of a received one is incomplete without it, so the caller stops using it.
+//
+void plSimpleStateVariable::ClearElementDeltas()
+{
+    if (!HasElementDeltas())
+        return;
+
+    fFlags &= ~kElementDelta;
+    fChangedElements.Clear();
+}
+
+//
+// FNV-1a of the elements as they are written, identifies the baseline
+// of a delta on both ends
+//
+uint32_t plSimpleStateVariable::IGetElementsChecksum() const
+{
+    hsRAMStream stream;
+    int i;
+    for (i = 0; i < GetCount(); i++)
+        IWriteData(&stream, 0, i, 0);
+
+    std::vector<uint8_t> buf(stream.GetEOF());
+    stream.CopyToMem(buf.data());
+
+    uint32_t hash = 2166136261u;
+    for (uint8_t b : buf)
+    {
+        hash ^= b;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 //
 // send notification msg if necessary, called internally
 //
@@ -2194,6 +2358,75 @@ case type:  \
             return false;   \
     break;  
 
+#define ELEMENT_EQ_CHECK(type, var)     \
+case type:  \
+    for(i=j;i<j+cnt;i++)  \
+        if (var[i]!=other.var[i])   \
+            return false;   \
+    break;
+
+bool plSimpleStateVariable::IElementEquals(const plSimpleStateVariable& other, int idx) const
+{
+    int i;
+    int cnt = fVar.GetAtomicCount();
+    int j = idx*cnt;
+    switch(fVar.GetAtomicType())
+    {
+        ELEMENT_EQ_CHECK(plVarDescriptor::kAgeTimeOfDay, fF)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kInt, fI)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kFloat, fF)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kTime, fT)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kDouble, fD)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kBool, fB)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kKey, fU)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kCreatable, fC)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kShort, fS)
+        ELEMENT_EQ_CHECK(plVarDescriptor::kByte, fBy)
+    case plVarDescriptor::kString32:
+        for(i=j;i<j+cnt;i++)
+            if (stricmp(fS32[i],other.fS32[i]))
+                return false;
+        break;
+    default:
+        hsAssert(false, "invalid atomic type");
+        return false;
+    }
+
+    return true;
+}
+
+#define ELEMENT_COPY(type, var)     \
+case type:  \
+    for(i=j;i<j+cnt;i++)  \
+        var[i]=other.var[i];   \
+    break;
+
+void plSimpleStateVariable::ICopyElement(const plSimpleStateVariable& other, int idx)
+{
+    int i;
+    int cnt = fVar.GetAtomicCount();
+    int j = idx*cnt;
+    switch(fVar.GetAtomicType())
+    {
+        ELEMENT_COPY(plVarDescriptor::kAgeTimeOfDay, fF)
+        ELEMENT_COPY(plVarDescriptor::kInt, fI)
+        ELEMENT_COPY(plVarDescriptor::kFloat, fF)
+        ELEMENT_COPY(plVarDescriptor::kTime, fT)
+        ELEMENT_COPY(plVarDescriptor::kDouble, fD)
+        ELEMENT_COPY(plVarDescriptor::kBool, fB)
+        ELEMENT_COPY(plVarDescriptor::kKey, fU)
+        ELEMENT_COPY(plVarDescriptor::kShort, fS)
+        ELEMENT_COPY(plVarDescriptor::kByte, fBy)
+    case plVarDescriptor::kString32:
+        for(i=j;i<j+cnt;i++)
+            hsStrncpy(fS32[i], other.fS32[i], 32);
+        break;
+    default:
+        hsAssert(false, "can't copy element of this type");
+        break;
+    }
+}
+
 bool plSimpleStateVariable::operator==(const plSimpleStateVariable &other) const
 {
     hsAssert(fVar.GetType() == other.GetVarDescriptor()->GetType(), "type mismatch in equality check");
@@ -2641,8 +2874,9 @@ bool plSDStateVariable::ReadData(hsStream* s, float timeConvert, uint32_t readOp
         else
             idx=i;
         
+        // nested records are always written with the full encoding
         if (idx<fDataRecList.size())
-            fDataRecList[idx]->Read(s, timeConvert, readOptions);
+            fDataRecList[idx]->Read(s, timeConvert, readOptions & ~plSDL::kDeltaEncode);
         else
             return false;
     }
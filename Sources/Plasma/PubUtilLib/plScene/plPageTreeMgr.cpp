@@ -42,6 +42,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "HeadSpin.h"
 #include <algorithm>
+#include <limits>
 
 #include "plPageTreeMgr.h"
 #include "plDrawable/plSpaceTreeMaker.h"
@@ -83,20 +84,25 @@ plPageTreeMgr::~plPageTreeMgr()
 
 void plPageTreeMgr::AddNode(plSceneNode* node)
 {
-    ITrashSpaceTree();
-
     node->Init();
 
+    // The space tree picks this up next time someone asks for it
     fNodes.push_back(node);
 }
 
 void plPageTreeMgr::RemoveNode(plSceneNode* node)
 {
-    ITrashSpaceTree();
-
     auto it = std::find(fNodes.begin(), fNodes.end(), node);
-    if (it != fNodes.end())
-        fNodes.erase(it);
+    if (it == fNodes.end())
+        return;
+
+    size_t idx = it - fNodes.begin();
+    fNodes.erase(it);
+
+    if (fNodes.empty())
+        ITrashSpaceTree();
+    else if (fSpaceTree && idx < size_t(fSpaceTree->GetNumLeaves()))
+        fSpaceTree->RemoveLeaf(int16_t(idx));
 }
 
 void plPageTreeMgr::Reset()
@@ -473,11 +479,27 @@ bool plPageTreeMgr::IRenderSortingSpans(plPipeline* pipe, hsTArray<plDrawVisList
     return true;
 }
 
+plSpaceTree* plPageTreeMgr::GetSpaceTree()
+{
+    if (!fSpaceTree || size_t(fSpaceTree->GetNumLeaves()) < fNodes.size())
+        IBuildSpaceTree();
+    return fSpaceTree;
+}
+
 bool plPageTreeMgr::IBuildSpaceTree()
 {
     if (fNodes.empty())
         return false;
 
+    // Nodes added since the tree was built just get slotted in
+    if (fSpaceTree)
+    {
+        hsAssert(fNodes.size() < std::numeric_limits<int16_t>::max(), "Too many nodes");
+        for (size_t i = fSpaceTree->GetNumLeaves(); i < fNodes.size(); ++i)
+            fSpaceTree->InsertLeaf(fNodes[i]->GetSpaceTree()->GetWorldBounds(), fNodes[i]->GetSpaceTree()->IsEmpty());
+        return true;
+    }
+
     plSpaceTreeMaker maker;
     maker.Reset();
     for (plSceneNode* node : fNodes)
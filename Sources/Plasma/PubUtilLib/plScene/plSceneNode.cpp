@@ -43,6 +43,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 
 #include "HeadSpin.h"
 #include <algorithm>
+#include <limits>
 
 #include "plSceneNode.h"
 #include "pnDispatch/plDispatch.h"
@@ -225,10 +226,32 @@ void plSceneNode::IDirtySpaceTree()
     }
 }
 
+void plSceneNode::IInsertNewDrawables()
+{
+    hsAssert(fDrawPool.size() < std::numeric_limits<int16_t>::max(), "Too many nodes");
+
+    hsBounds3Ext bnd;
+    hsPoint3 zero;
+    bnd.Reset(&zero);
+
+    for (size_t i = fSpaceTree->GetNumLeaves(); i < fDrawPool.size(); ++i)
+    {
+        if (fDrawPool[i])
+            fSpaceTree->InsertLeaf(fDrawPool[i]->GetSpaceTree()->GetWorldBounds());
+        else
+            fSpaceTree->InsertLeaf(bnd, true);
+    }
+
+    // So the page tree picks up our new bounds
+    fSpaceTree->MakeDirty();
+}
+
 plSpaceTree* plSceneNode::GetSpaceTree()
 {
     if (!fSpaceTree)
         IBuildSpaceTree();
+    else if (size_t(fSpaceTree->GetNumLeaves()) < fDrawPool.size())
+        IInsertNewDrawables();
     IDirtySpaceTree();
     return fSpaceTree;
 }
@@ -238,10 +261,9 @@ void plSceneNode::ISetDrawable(plDrawable* d)
     if( !d )
         return;
 
-    if (std::find(fDrawPool.begin(), fDrawPool.end(), d) == fDrawPool.end()) {
+    // The space tree picks this up next time someone asks for it
+    if (std::find(fDrawPool.begin(), fDrawPool.end(), d) == fDrawPool.end())
         fDrawPool.push_back(d);
-        ITrashSpaceTree();
-    }
 }
 
 void plSceneNode::ISetAudible(plAudible* a)
@@ -301,8 +323,14 @@ void plSceneNode::IRemoveDrawable(plDrawable* d)
 {
     auto it = std::find(fDrawPool.begin(), fDrawPool.end(), d);
     if (it != fDrawPool.end()) {
+        size_t idx = it - fDrawPool.begin();
         fDrawPool.erase(it);
-        ITrashSpaceTree();
+
+        if (fSpaceTree && idx < size_t(fSpaceTree->GetNumLeaves()))
+        {
+            fSpaceTree->RemoveLeaf(int16_t(idx));
+            fSpaceTree->MakeDirty();
+        }
     }
 }
 
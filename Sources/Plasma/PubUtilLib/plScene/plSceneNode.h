@@ -92,6 +92,7 @@ protected:
     plSpaceTree*                        fSpaceTree;
 
     void            IDirtySpaceTree();
+    void            IInsertNewDrawables();
     plSpaceTree*    ITrashSpaceTree();
     plSpaceTree*    IBuildSpaceTree();
 
@@ -55,8 +55,12 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 //                                                                          //
 //////////////////////////////////////////////////////////////////////////////
 
+#include <atomic>
+#include <chrono>
 #include <cstdarg>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 #include "hsThread.h"
 #include "hsTemplates.h"
 #include "hsTimer.h"
@@ -68,6 +72,120 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plEncryptLogLine.h"
 
 
+//////////////////////////////////////////////////////////////////////////////
+//// plStatusLogQueue ////////////////////////////////////////////////////////
+//  Bounded lock-free queue of finished lines.  Any number of threads may
+//  push; only the holder of plStatusLogMgr::fWriteMut pops.  Each cell's
+//  sequence number says whether it's free for the push at that position or
+//  holds a line for the pop at that position.
+
+class plStatusLogQueue
+{
+    struct Cell
+    {
+        std::atomic<size_t> fSequence;
+        ST::string          fLine;
+    };
+
+    enum { kNumCells = 512 };   // Must be a power of two
+
+    Cell                fCells[kNumCells];
+    std::atomic<size_t> fPushPos;
+    std::atomic<size_t> fPopPos;
+
+public:
+    plStatusLogQueue() : fPushPos(0), fPopPos(0)
+    {
+        for (size_t i = 0; i < kNumCells; i++)
+            fCells[i].fSequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Returns false if the queue is full
+    bool Push(ST::string&& line)
+    {
+        size_t pos = fPushPos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &fCells[pos & (kNumCells - 1)];
+            size_t seq = cell->fSequence.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0)
+            {
+                if (fPushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = fPushPos.load(std::memory_order_relaxed);
+        }
+
+        cell->fLine = std::move(line);
+        cell->fSequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(ST::string& line)
+    {
+        size_t pos = fPopPos.load(std::memory_order_relaxed);
+        Cell* cell = &fCells[pos & (kNumCells - 1)];
+        size_t seq = cell->fSequence.load(std::memory_order_acquire);
+        if (intptr_t(seq) - intptr_t(pos + 1) < 0)
+            return false;
+
+        fPopPos.store(pos + 1, std::memory_order_relaxed);
+        line = std::move(cell->fLine);
+        cell->fSequence.store(pos + kNumCells, std::memory_order_release);
+        return true;
+    }
+
+    // Rough fill level, for deciding when to poke the writer
+    size_t Count() const
+    {
+        return fPushPos.load(std::memory_order_relaxed) - fPopPos.load(std::memory_order_relaxed);
+    }
+
+    static size_t Capacity() { return kNumCells; }
+};
+
+
+//////////////////////////////////////////////////////////////////////////////
+//// plStatusLogWriter ///////////////////////////////////////////////////////
+//  One background thread that drains every log's queue to disk, in batches,
+//  so nobody calling AddLine() ever waits on the file system.  Each pass
+//  flushes the files it wrote to.
+
+static thread_local bool s_isLogWriterThread = false;
+
+class plStatusLogWriter : public hsThread
+{
+    hsSemaphore fWake;
+
+public:
+    enum { kFlushIntervalMs = 100 };
+
+    void Wake() { fWake.Signal(); }
+
+    void Run() override
+    {
+        s_isLogWriterThread = true;
+        while (!GetQuit())
+        {
+            fWake.Wait(std::chrono::milliseconds(kFlushIntervalMs));
+            plStatusLogMgr::GetInstance().IWriteQueuedLines(true);
+        }
+    }
+
+    void Stop() override
+    {
+        SetQuit(true);
+        fWake.Signal();
+        hsThread::Stop();
+    }
+};
+
+
 //////////////////////////////////////////////////////////////////////////////
 //// plStatusLogMgr Stuff ////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
@@ -86,10 +204,20 @@ plStatusLogMgr::plStatusLogMgr()
     fCurrDisplay = nil;
     fDrawer = nil;
     fLastLogChangeTime = 0;
+    fWriter = nil;
 }
 
 plStatusLogMgr::~plStatusLogMgr()
 {
+    // Stop the writer and put everything it didn't get to on disk
+    if (fWriter != nil)
+    {
+        fWriter->Stop();
+        delete fWriter;
+        fWriter = nil;
+    }
+    IWriteQueuedLines(true);
+
     // Unlink all the displays, but don't delete them; leave that to whomever owns them
     while( fDisplays != nil )
     {
@@ -100,6 +228,7 @@ plStatusLogMgr::~plStatusLogMgr()
         if( log->fFlags & plStatusLog::kDeleteForMe )
             delete log;
     }
+    fLogsByName.clear();
 }
 
 plStatusLogMgr  &plStatusLogMgr::GetInstance()
@@ -126,10 +255,22 @@ void    plStatusLogMgr::Draw()
 //// CreateStatusLog /////////////////////////////////////////////////////////
 
 plStatusLog *plStatusLogMgr::CreateStatusLog( uint8_t numDisplayLines, const plFileName &filename, uint32_t flags )
+{
+    std::lock_guard<std::mutex> lock(fLogsMut);
+    return ICreateStatusLog(numDisplayLines, filename, flags);
+}
+
+plStatusLog *plStatusLogMgr::ICreateStatusLog( uint8_t numDisplayLines, const plFileName &filename, uint32_t flags )
 {
     plFileSystem::CreateDir(IGetBasePath(), true);
     plStatusLog *log = new plStatusLog( numDisplayLines, filename, flags );
 
+    if (fWriter == nil)
+    {
+        fWriter = new plStatusLogWriter;
+        fWriter->Start();
+    }
+
     // Put the new log in its alphabetical position
     plStatusLog** nextLog = &fDisplays;
     while (*nextLog)
@@ -140,11 +281,32 @@ plStatusLog *plStatusLogMgr::CreateStatusLog( uint8_t numDisplayLines, const plF
     }
     log->ILink(nextLog);
 
+    // Newer logs shadow older ones of the same name, as they do in the list
+    fLogsByName[filename.AsString()] = log;
+
     log->fDisplayPointer = &fCurrDisplay;
 
     return log;
 }
 
+void plStatusLogMgr::IUnregisterLog(plStatusLog *log)
+{
+    auto iter = fLogsByName.find(log->GetFileName().AsString());
+    if (iter == fLogsByName.end() || iter->second != log)
+        return;
+    fLogsByName.erase(iter);
+
+    // Let an older log with the same name be found again
+    for (plStatusLog *other = fDisplays; other != nil; other = other->fNext)
+    {
+        if (other != log && other->GetFileName().AsString().compare_i(log->GetFileName().AsString()) == 0)
+        {
+            fLogsByName[other->GetFileName().AsString()] = other;
+            break;
+        }
+    }
+}
+
 //// ToggleStatusLog /////////////////////////////////////////////////////////
 
 void    plStatusLogMgr::ToggleStatusLog( plStatusLog *logToDisplay )
@@ -202,30 +364,27 @@ void    plStatusLogMgr::PrevStatusLog()
 
 plStatusLog *plStatusLogMgr::FindLog( const plFileName &filename, bool createIfNotFound )
 {
-    plStatusLog *log = fDisplays;
+    std::lock_guard<std::mutex> lock(fLogsMut);
 
-    while( log != nil )
-    {
-        if (log->GetFileName().AsString().compare_i(filename.AsString()) == 0)
-            return log;
-
-        log = log->fNext;
-    }
+    auto iter = fLogsByName.find(filename.AsString());
+    if (iter != fLogsByName.end())
+        return iter->second;
 
     if( !createIfNotFound )
         return nil;
 
     // Didn't find one, so create one! (make it a nice default one :)
-    log = CreateStatusLog( kDefaultNumLines, filename, plStatusLog::kFilledBackground |
-                                                       plStatusLog::kDeleteForMe );
-
-    return log;
+    return ICreateStatusLog( kDefaultNumLines, filename, plStatusLog::kFilledBackground |
+                                                        plStatusLog::kDeleteForMe );
 }
 
 //// BounceLogs ///////////////////////////////////////////////////////////////
 
 void plStatusLogMgr::BounceLogs()
 {
+    std::lock_guard<std::recursive_mutex> writeLock(fWriteMut);
+    std::lock_guard<std::mutex> logsLock(fLogsMut);
+
     plStatusLog *log = fDisplays;
 
     while( log != nil )
@@ -236,6 +395,57 @@ void plStatusLogMgr::BounceLogs()
     }
 }
 
+//// IWriteQueuedLines ///////////////////////////////////////////////////////
+//  Drain every log's queue to disk.  With wait false, gives up instead of
+//  blocking on a lock (for the crash handler).
+
+void plStatusLogMgr::IWriteQueuedLines(bool wait)
+{
+    std::unique_lock<std::recursive_mutex> writeLock(fWriteMut, std::defer_lock);
+    if (wait)
+        writeLock.lock();
+    else if (!writeLock.try_lock())
+        return;
+
+    // Logs can't be deleted while we hold fWriteMut (see plStatusLog::IFini),
+    // so we only need fLogsMut long enough to see which ones there are.
+    std::vector<plStatusLog*> logs;
+    {
+        std::unique_lock<std::mutex> logsLock(fLogsMut, std::defer_lock);
+        if (wait)
+            logsLock.lock();
+        else if (!logsLock.try_lock())
+            return;
+
+        for (plStatusLog *log = fDisplays; log != nil; log = log->fNext)
+            logs.push_back(log);
+    }
+
+    bool bounce = false;
+    for (plStatusLog *log : logs)
+        bounce |= log->IWriteQueuedLines();
+
+    if (bounce)
+        BounceLogs();
+}
+
+//// FlushLogs ///////////////////////////////////////////////////////////////
+
+void plStatusLogMgr::FlushLogs()
+{
+    // The writer may be in the middle of a pass; give it a moment
+    for (int i = 0; i < 50; i++)
+    {
+        if (fWriteMut.try_lock())
+        {
+            IWriteQueuedLines(false);
+            fWriteMut.unlock();
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
 //// DumpLogs ////////////////////////////////////////////////////////////////
 
 bool plStatusLogMgr::DumpLogs( const plFileName &newFolderName )
@@ -266,7 +476,7 @@ uint32_t plStatusLog::fLoggingOff = false;
 
 plStatusLog::plStatusLog( uint8_t numDisplayLines, const plFileName &filename, uint32_t flags )
     : fFileHandle(), fSema(), fSize(), fForceLog(), fMaxNumLines(numDisplayLines),
-      fDisplayPointer()
+      fDisplayPointer(), fQueue(new plStatusLogQueue)
 {
     if (filename.IsValid())
     {
@@ -312,11 +522,7 @@ void    plStatusLog::IInit()
 
 bool plStatusLog::IReOpen()
 {
-    if( fFileHandle != nil )
-    {
-        fclose( fFileHandle );
-        fFileHandle = nil;
-    }
+    ICloseFile();
 
     // Open the file, clearing it, if necessary
     if(!(fFlags & kDontWriteFile))
@@ -361,23 +567,30 @@ void    plStatusLog::IFini()
 {
     int     i;
 
-    if( fFileHandle != nil )
+    plStatusLogMgr &mgr = plStatusLogMgr::GetInstance();
     {
-        fclose( fFileHandle );
-        fFileHandle = nil;
-    }
+        // Holding fWriteMut keeps the writer thread away from us from here on
+        std::lock_guard<std::recursive_mutex> writeLock(mgr.fWriteMut);
+        IWriteQueuedLines();
+        ICloseFile();
 
-    if( *fDisplayPointer == this )
-        *fDisplayPointer = nil;
+        if( *fDisplayPointer == this )
+            *fDisplayPointer = nil;
 
-    if( fBack != nil || fNext != nil )
-        IUnlink();
+        if( fBack != nil || fNext != nil )
+        {
+            std::lock_guard<std::mutex> logsLock(mgr.fLogsMut);
+            mgr.IUnregisterLog(this);
+            IUnlink();
+        }
+    }
 
     for( i = 0; i < fMaxNumLines; i++ )
         delete [] fLines[ i ];
 
     if (fSema)
         delete fSema;
+    delete fQueue;
 
     delete [] fLines;
     delete [] fColors;
@@ -441,7 +654,7 @@ bool plStatusLog::IAddLine( const char *line, int32_t count, uint32_t color )
         return true;
 
     /// Scroll pointers up
-    fSema->Wait();
+    std::unique_lock<std::mutex> lock(fLinesMut);
 
     bool ret = true;
 
@@ -463,6 +676,7 @@ bool plStatusLog::IAddLine( const char *line, int32_t count, uint32_t color )
             fColors[ i ] = 0;
             fLines[ i ] = nil;
         }
+        lock.unlock();
         ret = IPrintLineToFile( "", 0 );
     }
     else
@@ -486,11 +700,10 @@ bool plStatusLog::IAddLine( const char *line, int32_t count, uint32_t color )
             fColors[ i ] = color;
         }
 
+        lock.unlock();
         ret = IPrintLineToFile( line, count );
     }
 
-    fSema->Signal();
-
     return ret;
 }
 
@@ -526,7 +739,7 @@ void    plStatusLog::Clear()
 {
     int     i;
 
-
+    std::lock_guard<std::mutex> lock(fLinesMut);
     for( i = 0; i < fMaxNumLines; i++ )
     {
         delete [] fLines[ i ];
@@ -542,97 +755,104 @@ void    plStatusLog::Bounce( uint32_t flags)
     if (flags)
         fOrigFlags=flags;
     Clear();
+    {
+        // Whatever's still queued belongs in the old file
+        std::lock_guard<std::recursive_mutex> lock(plStatusLogMgr::GetInstance().fWriteMut);
+        IWriteQueuedLines();
+        ICloseFile();
+    }
+    AddLine( "--------- Bounced Log ---------" );
+}
+
+//// ICloseFile //////////////////////////////////////////////////////////////
+
+void plStatusLog::ICloseFile()
+{
     if( fFileHandle != nil )
     {
         fclose( fFileHandle );
         fFileHandle = nil;
     }
-    AddLine( "--------- Bounced Log ---------" );
 }
 
 //// IPrintLineToFile ////////////////////////////////////////////////////////
+//  Formats the line on the calling thread (so timestamps and thread IDs are
+//  the caller's) and hands it to the writer thread.
 
 bool plStatusLog::IPrintLineToFile( const char *line, uint32_t count )
 {
     if( fFlags & kDontWriteFile )
         return true;
 
-#ifdef PLASMA_EXTERNAL_RELEASE
-    uint8_t hint = 0;
-    if( fFlags & kAppendToLast )
-    {
-        hint = (uint8_t)fSize;
-    }
-#endif
+    char work[256];
+    ST::string_stream buf;
 
-    if (!fFileHandle)
-        IReOpen();
-
-    bool ret = ( fFileHandle!=nil );
-
-    if( fFileHandle != nil )
+    if( count != 0 )
     {
-        char work[256];
-        ST::string_stream buf;
-
-        //build line to encrypt
-
-        if( count != 0 )
+        if ( fFlags & kTimestamp )
         {
-            if ( fFlags & kTimestamp )
-            {
-                snprintf(work, std::size(work), "(%s) ", plUnifiedTime(kNow).Format("%m/%d %H:%M:%S").c_str());
-                buf.append(work);
-            }
-            if ( fFlags & kTimestampGMT )
-            {
-                snprintf(work, std::size(work), "(%s) ", plUnifiedTime::GetCurrent().Format("%m/%d %H:%M:%S UTC").c_str());
-                buf.append(work);
-            }
-            if ( fFlags & kTimeInSeconds )
-            {
-                snprintf(work, std::size(work), "(%lu) ", (unsigned long)plUnifiedTime(kNow).GetSecs());
-                buf.append(work);
-            }
-            if ( fFlags & kTimeAsDouble )
-            {
-                snprintf(work, std::size(work), "(%f) ", plUnifiedTime(kNow).GetSecsDouble());
-                buf.append(work);
-            }
-            if (fFlags & kRawTimeStamp)
-            {
-                snprintf(work, std::size(work), "[t=%10f] ", hsTimer::GetSeconds());
-                buf.append(work);
-            }
-            if (fFlags & kThreadID)
-            {
-                snprintf(work, std::size(work), "[t=%lu] ", hsThread::ThisThreadHash());
-                buf.append(work);
-            }
-
-            buf.append(line, count);
-            buf.append_char('\n');
+            snprintf(work, std::size(work), "(%s) ", plUnifiedTime(kNow).Format("%m/%d %H:%M:%S").c_str());
+            buf.append(work);
         }
-
+        if ( fFlags & kTimestampGMT )
         {
-            int err;
-            err = fwrite(buf.raw_buffer(), 1, buf.size(), fFileHandle);
-            ret = ( ferror( fFileHandle )==0 );
-
-            if ( ret )
-            {
-                fSize += err;
-                if (!(fFlags & kNonFlushedLog))
-                    fflush(fFileHandle);
-            }
+            snprintf(work, std::size(work), "(%s) ", plUnifiedTime::GetCurrent().Format("%m/%d %H:%M:%S UTC").c_str());
+            buf.append(work);
+        }
+        if ( fFlags & kTimeInSeconds )
+        {
+            snprintf(work, std::size(work), "(%lu) ", (unsigned long)plUnifiedTime(kNow).GetSecs());
+            buf.append(work);
+        }
+        if ( fFlags & kTimeAsDouble )
+        {
+            snprintf(work, std::size(work), "(%f) ", plUnifiedTime(kNow).GetSecsDouble());
+            buf.append(work);
+        }
+        if (fFlags & kRawTimeStamp)
+        {
+            snprintf(work, std::size(work), "[t=%10f] ", hsTimer::GetSeconds());
+            buf.append(work);
+        }
+        if (fFlags & kThreadID)
+        {
+            snprintf(work, std::size(work), "[t=%lu] ", hsThread::ThisThreadHash());
+            buf.append(work);
         }
 
-        if ( fSize>=kMaxFileSize )
+        buf.append(line, count);
+        buf.append_char('\n');
+    }
+
+    plStatusLogMgr &mgr = plStatusLogMgr::GetInstance();
+    ST::string text = buf.to_string();
+    while (!fQueue->Push(std::move(text)))
+    {
+        // Full.  Drain it ourselves if we can get at the file (we may already
+        // be holding fWriteMut further up the stack), else let the writer catch up.
+        std::unique_lock<std::recursive_mutex> lock(mgr.fWriteMut, std::try_to_lock);
+        if (lock.owns_lock())
         {
-            plStatusLogMgr::GetInstance().BounceLogs();
+            if (IWriteQueuedLines())
+                mgr.BounceLogs();
         }
+        else
+        {
+            if (mgr.fWriter != nil)
+                mgr.fWriter->Wake();
+            std::this_thread::yield();
+        }
+    }
 
+    if (mgr.fWriter == nil || s_isLogWriterThread)
+    {
+        // Nobody's going to come along and write it for us
+        std::lock_guard<std::recursive_mutex> lock(mgr.fWriteMut);
+        if (IWriteQueuedLines())
+            mgr.BounceLogs();
     }
+    else if (fQueue->Count() >= plStatusLogQueue::Capacity() / 2)
+        mgr.fWriter->Wake();
 
     ST::string out_str = ST::string::from_utf8(line, count) + "\n";
     if (fFlags & kDebugOutput)
@@ -652,5 +872,39 @@ bool plStatusLog::IPrintLineToFile( const char *line, uint32_t count )
         fputs(out_str.c_str(), stdout);
     }
 
-    return ret;
+    return true;
+}
+
+//// IWriteQueuedLines ///////////////////////////////////////////////////////
+//  Writes out everything in the queue as one batch.  Must be called with
+//  plStatusLogMgr::fWriteMut held.  Returns true if the file has grown past
+//  kMaxFileSize and the logs need bouncing.
+
+bool plStatusLog::IWriteQueuedLines()
+{
+    ST::string line;
+    if (!fQueue->Pop(line))
+        return false;
+
+    fSema->Wait();
+
+    if (!fFileHandle)
+        IReOpen();
+
+    do
+    {
+        if (fFileHandle != nil && !line.empty())
+        {
+            size_t written = fwrite(line.c_str(), 1, line.size(), fFileHandle);
+            if (ferror(fFileHandle) == 0)
+                fSize += written;
+        }
+    } while (fQueue->Pop(line));
+
+    if (fFileHandle != nil && !(fFlags & kNonFlushedLog))
+        fflush(fFileHandle);
+
+    fSema->Signal();
+
+    return fFileHandle != nil && fSize >= kMaxFileSize;
 }
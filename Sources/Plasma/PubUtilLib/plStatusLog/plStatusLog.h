@@ -61,7 +61,9 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include "plFileSystem.h"
 #include "plLoggable.h"
 
+#include <mutex>
 #include <string_theory/format>
+#include <unordered_map>
 
 class plPipeline;
 
@@ -71,6 +73,8 @@ class plPipeline;
 
 class plStatusLogMgr;
 class plStatusLogDrawerStub;
+class plStatusLogQueue;
+class plStatusLogWriter;
 
 class plStatusLog : public plLog
 {
@@ -88,11 +92,16 @@ class plStatusLog : public plLog
         plFileName   fFilename;
         char**       fLines;
         uint32_t*    fColors;
-        hsGlobalSemaphore* fSema;
+        std::mutex   fLinesMut;     // Guards fLines and fColors
+        hsGlobalSemaphore* fSema;   // Held while writing to the file
         FILE*        fFileHandle;
         uint32_t     fSize;
         bool         fForceLog;
 
+        // Lines waiting to be written out by the plStatusLogWriter thread.
+        // Everything touching fFileHandle runs under plStatusLogMgr::fWriteMut.
+        plStatusLogQueue *fQueue;
+
         plStatusLog *fNext, **fBack;
 
         plStatusLog **fDisplayPointer;      // Inside pfConsole
@@ -102,6 +111,8 @@ class plStatusLog : public plLog
 
         bool    IAddLine( const char *line, int32_t count, uint32_t color );
         bool    IPrintLineToFile( const char *line, uint32_t count );
+        bool    IWriteQueuedLines();
+        void    ICloseFile();
         void    IParseFileName(plFileName &fileNoExt, ST::string &ext) const;
         static plStatusLog* IFindLog(const plFileName& filename);
 
@@ -243,6 +254,7 @@ class plStatusLog : public plLog
 class plStatusLogMgr
 {
     friend class plStatusLog;
+    friend class plStatusLogWriter;
 
     private:
 
@@ -258,8 +270,20 @@ class plStatusLogMgr
 
         double fLastLogChangeTime;
 
+        // fDisplays is also walked by the writer thread, and FindLog() is
+        // called from any thread, so both go through fLogsMut.
+        std::mutex  fLogsMut;
+        std::unordered_map<ST::string, plStatusLog*, ST::hash_i, ST::equal_i> fLogsByName;
+
+        plStatusLogWriter       *fWriter;
+        std::recursive_mutex    fWriteMut;
+
         static plFileName IGetBasePath();
 
+        plStatusLog *ICreateStatusLog( uint8_t numDisplayLines, const plFileName &filename, uint32_t flags );
+        void        IUnregisterLog( plStatusLog *log );
+        void        IWriteQueuedLines( bool wait );
+
     public:
 
         enum
@@ -284,6 +308,11 @@ class plStatusLogMgr
 
         void        BounceLogs();
 
+        // Write out everything that's still queued, right now.  Safe to call
+        // from a crash handler; it gives up rather than waiting on a lock
+        // the crashing thread might hold.
+        void        FlushLogs();
+
         // Create a new folder and copy all log files into it (returns false on failure)
         bool        DumpLogs( const plFileName &newFolderName );
 };
@@ -303,6 +332,7 @@ class plStatusLogDrawerStub
         char        **IGetLines( plStatusLog *log ) const { return log->fLines; }
         plFileName    IGetFilename( plStatusLog *log ) const { return log->GetFileName(); }
         uint32_t     *IGetColors( plStatusLog *log ) const { return log->fColors; }
+        std::mutex   &IGetLinesMutex( plStatusLog *log ) const { return log->fLinesMut; }
         uint32_t      IGetFlags( plStatusLog *log ) const { return log->fFlags; }
         
     public:
@@ -49,3 +49,18 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #error "Header $/Plasma20/Sources/Plasma/PubUtilLib/plVault/Intern.h included more than once"
 #endif
 #define PLASMA20_SOURCES_PLASMA_PUBUTILLIB_PLVAULT_INTERN_H
+
+
+/*****************************************************************************
+*
+*   plVaultNodeCache.cpp
+*
+***/
+
+// Nodes downloaded from the vault are kept on disk between sessions, keyed by
+// node id and modify time, so a cached node only needs to be revalidated
+// with the server rather than fetched again.
+hsRef<NetVaultNode> VaultNodeCacheFind (unsigned nodeId);
+void VaultNodeCacheStore (NetVaultNode * node);
+void VaultNodeCacheRemove (unsigned nodeId);
+void VaultNodeCacheClose ();
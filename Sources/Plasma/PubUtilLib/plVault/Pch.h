@@ -57,6 +57,7 @@ You can contact Cyan Worlds, Inc. by email legal@cyan.com
 #include <memory>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include "hsSTLStream.h"
 #include "hsStringTokenizer.h"
 #include "hsGeometry3.h"
@@ -92,6 +92,10 @@ struct RelVaultNodeLink : THashKeyVal<unsigned> {
 
 struct IRelVaultNode {
     hsWeakRef<RelVaultNode> node;
+
+    // The keys this node is filed under in the global node indexes
+    bool                    indexed;
+    NetVaultNode::IndexKeys indexedKeys;
     
     HASHTABLEDECL(
         RelVaultNodeLink,
@@ -251,6 +255,26 @@ struct AddChildNodeFetchTrans {
     );
 };
 
+// Asks the server whether a node we have on disk still has the same modify
+// time, then hands either the cached copy or a freshly fetched one to the
+// original fetch callback.
+struct CachedNodeRevalidateTrans {
+    hsRef<NetVaultNode>         node;
+    FNetCliAuthVaultNodeFetched fetchCallback;
+    void *                      fetchParam;
+
+    CachedNodeRevalidateTrans(hsRef<NetVaultNode> _node, FNetCliAuthVaultNodeFetched _callback,
+                              void * _param)
+        : node(std::move(_node)), fetchCallback(_callback), fetchParam(_param) { }
+
+    static void VaultNodeFound (
+        ENetError           result,
+        void *              param,
+        unsigned            nodeIdCount,
+        const unsigned      nodeIds[]
+    );
+};
+
 
 /*****************************************************************************
 *
@@ -279,6 +303,14 @@ static HASHTABLEDECL(
 
 static std::unordered_map<ST::string, ST::string, ST::hash> s_ageDeviceInboxes;
 
+// Secondary indexes on s_nodes, by the template fields most queries use.
+// Candidates found through them are still checked with Matches().
+typedef std::unordered_set<unsigned> VaultNodeIdSet;
+static std::unordered_map<uint32_t, VaultNodeIdSet> s_nodesByType;
+static std::unordered_map<uint32_t, VaultNodeIdSet> s_nodesByCreatorId;
+static std::unordered_map<ST::string, VaultNodeIdSet, ST::hash> s_nodesByString64_1;
+static std::map<plUUID, VaultNodeIdSet> s_nodesByUuid_1;
+
 static bool s_processPlayerInbox = false;
 
 /*****************************************************************************
@@ -331,6 +363,101 @@ static void VaultNodeAddedDownloadCallback(ENetError result, void * param) {
     }
 }
 
+//============================================================================
+template <typename Key, typename Index>
+static void RemoveFromIndex (Index & index, const Key & key, unsigned nodeId) {
+    auto it = index.find(key);
+    if (it == index.end())
+        return;
+    it->second.erase(nodeId);
+    if (it->second.empty())
+        index.erase(it);
+}
+
+//============================================================================
+static void UnindexNode (hsWeakRef<RelVaultNode> node) {
+    IRelVaultNode * state = node->state;
+    if (!state->indexed)
+        return;
+
+    unsigned nodeId = node->GetNodeId();
+    const NetVaultNode::IndexKeys & keys = state->indexedKeys;
+    if (keys.nodeType)
+        RemoveFromIndex(s_nodesByType, keys.nodeType, nodeId);
+    if (keys.creatorId)
+        RemoveFromIndex(s_nodesByCreatorId, keys.creatorId, nodeId);
+    if (!keys.string64_1.empty())
+        RemoveFromIndex(s_nodesByString64_1, keys.string64_1, nodeId);
+    if (!keys.uuid_1.IsNull())
+        RemoveFromIndex(s_nodesByUuid_1, keys.uuid_1, nodeId);
+    state->indexed = false;
+}
+
+//============================================================================
+// File a node in s_nodes under its current template fields.
+// Called again whenever one of them changes, see RelVaultNode::IIndexKeysChanged.
+static void IndexNode (hsWeakRef<RelVaultNode> node) {
+    UnindexNode(node);
+
+    IRelVaultNode * state = node->state;
+    unsigned nodeId = node->GetNodeId();
+    state->indexed = true;
+    state->indexedKeys = node->GetIndexKeys();
+
+    const NetVaultNode::IndexKeys & keys = state->indexedKeys;
+    if (keys.nodeType)
+        s_nodesByType[keys.nodeType].insert(nodeId);
+    if (keys.creatorId)
+        s_nodesByCreatorId[keys.creatorId].insert(nodeId);
+    if (!keys.string64_1.empty())
+        s_nodesByString64_1[keys.string64_1].insert(nodeId);
+    if (!keys.uuid_1.IsNull())
+        s_nodesByUuid_1[keys.uuid_1].insert(nodeId);
+}
+
+//============================================================================
+template <typename Key, typename Index>
+static void NarrowIndexedNodes (
+    const Index &           index,
+    const Key &             key,
+    const VaultNodeIdSet ** best
+) {
+    static const VaultNodeIdSet s_none;
+
+    auto it = index.find(key);
+    const VaultNodeIdSet * ids = (it != index.end()) ? &it->second : &s_none;
+    if (!*best || ids->size() < (*best)->size())
+        *best = ids;
+}
+
+//============================================================================
+// Returns the smallest set of node ids which may match the template,
+// or nil if the template has none of the indexed fields.
+static const VaultNodeIdSet * FindIndexedNodes (hsWeakRef<NetVaultNode> templateNode) {
+    // Nodes with a zero or empty value aren't indexed, so those can't be looked up
+    const VaultNodeIdSet * best = nil;
+    NetVaultNode::IndexKeys keys = templateNode->GetIndexKeys();
+    if (keys.nodeType)
+        NarrowIndexedNodes(s_nodesByType, keys.nodeType, &best);
+    if (keys.creatorId)
+        NarrowIndexedNodes(s_nodesByCreatorId, keys.creatorId, &best);
+    if (!keys.string64_1.empty())
+        NarrowIndexedNodes(s_nodesByString64_1, keys.string64_1, &best);
+    if (!keys.uuid_1.IsNull())
+        NarrowIndexedNodes(s_nodesByUuid_1, keys.uuid_1, &best);
+    return best;
+}
+
+//============================================================================
+template <typename Table>
+static bool HasMoreLinksThan (const Table & table, size_t count) {
+    for (const RelVaultNodeLink * link = table.Head(); link; link = table.Next(link)) {
+        if (count-- == 0)
+            return true;
+    }
+    return false;
+}
+
 //============================================================================
 // Returns ids of nodes that had to be created (so we can fetch them)
 static void BuildNodeTree (
@@ -348,6 +475,7 @@ static void BuildNodeTree (
             parentLink = new RelVaultNodeLink(false, 0, refs[i].parentId);
             parentLink->node->SetNodeId_NoDirty(refs[i].parentId);
             s_nodes.Add(parentLink);
+            IndexNode(parentLink->node);
         }
         else {
             existingNodeIds->Add(refs[i].parentId);
@@ -358,6 +486,7 @@ static void BuildNodeTree (
             childLink = new RelVaultNodeLink(refs[i].seen, refs[i].ownerId, refs[i].childId);
             childLink->node->SetNodeId_NoDirty(refs[i].childId);
             s_nodes.Add(childLink);
+            IndexNode(childLink->node);
         }
         else {
             existingNodeIds->Add(refs[i].childId);
@@ -440,6 +569,31 @@ static void FetchRefOwners (
     }
 }
 
+//============================================================================
+// Fetches a node we don't have in memory yet.  If it is in the node cache,
+// only a find on its id and modify time goes to the server, and the node is
+// fetched only if that comes back empty.
+static void FetchNode (
+    unsigned                    nodeId,
+    FNetCliAuthVaultNodeFetched fetchCallback,
+    void *                      fetchParam
+) {
+    hsRef<NetVaultNode> cached = VaultNodeCacheFind(nodeId);
+    if (!cached) {
+        NetCliAuthVaultNodeFetch(nodeId, fetchCallback, fetchParam);
+        return;
+    }
+
+    NetVaultNode templateNode;
+    templateNode.SetNodeId(nodeId);
+    templateNode.SetModifyTime(cached->GetModifyTime());
+    NetCliAuthVaultNodeFind(
+        &templateNode,
+        CachedNodeRevalidateTrans::VaultNodeFound,
+        new CachedNodeRevalidateTrans(std::move(cached), fetchCallback, fetchParam)
+    );
+}
+
 //============================================================================
 static void FetchNodesFromRefs (
     NetVaultNodeRef *           refs,
@@ -474,7 +628,7 @@ static void FetchNodesFromRefs (
         if (link->node->GetNodeId() == prevId)
             continue;
         prevId = link->node->GetNodeId();
-        NetCliAuthVaultNodeFetch(
+        FetchNode(
             nodeIds[i],
             fetchCallback,
             fetchParam
@@ -524,9 +678,11 @@ static void VaultNodeFetched (
         link = new RelVaultNodeLink(false, 0, node->GetNodeId());
         link->node->SetNodeId_NoDirty(node->GetNodeId());
         s_nodes.Add(link);
+        IndexNode(link->node);
     }
     link->node->CopyFrom(node);
     InitFetchedNode(link->node);
+    VaultNodeCacheStore(node);
 
     link->node->Print("Fetched", 0);
 }
@@ -682,6 +838,7 @@ static void VaultNodeDeleted (
 ) {
     LogMsg(kLogDebug, "Notify: Node deleted: {}", nodeId);
     VaultCull(nodeId);
+    VaultNodeCacheRemove(nodeId);
 }
 
 //============================================================================
@@ -889,7 +1046,7 @@ void VaultDownloadTrans::VaultNodeRefsFetched (
             // root node has no child heirarchy? Make sure we still d/l the root node if necessary.
             RelVaultNodeLink* rootNodeLink = s_nodes.Find(trans->vaultId);
             if (!rootNodeLink || rootNodeLink->node->GetNodeType() == 0) {
-                NetCliAuthVaultNodeFetch(
+                FetchNode(
                     trans->vaultId,
                     VaultDownloadTrans::VaultNodeFetched,
                     trans
@@ -912,6 +1069,39 @@ void VaultDownloadTrans::VaultNodeRefsFetched (
 }
 
 
+/*****************************************************************************
+*
+*   CachedNodeRevalidateTrans
+*
+***/
+
+//============================================================================
+void CachedNodeRevalidateTrans::VaultNodeFound (
+    ENetError           result,
+    void *              param,
+    unsigned            nodeIdCount,
+    const unsigned      nodeIds[]
+) {
+    CachedNodeRevalidateTrans * trans = (CachedNodeRevalidateTrans *)param;
+    unsigned nodeId = trans->node->GetNodeId();
+
+    if (IS_NET_SUCCESS(result) && nodeIdCount == 1 && nodeIds[0] == nodeId) {
+        // Unchanged since we cached it
+        trans->fetchCallback(kNetSuccess, trans->fetchParam, trans->node.Get());
+    }
+    else {
+        LogMsg(kLogDebug, "Vault: Cached node {} is stale, fetching", nodeId);
+        NetCliAuthVaultNodeFetch(
+            nodeId,
+            trans->fetchCallback,
+            trans->fetchParam
+        );
+    }
+
+    delete trans;
+}
+
+
 /*****************************************************************************
 *
 *   VaultAgeInitTrans
@@ -1013,7 +1203,7 @@ void AddChildNodeFetchTrans::VaultNodeFetched (
 
 //============================================================================
 IRelVaultNode::IRelVaultNode(hsWeakRef<RelVaultNode> node)
-    : node(std::move(node))
+    : node(std::move(node)), indexed(false), indexedKeys()
 { }
 
 //============================================================================
@@ -1082,6 +1272,12 @@ RelVaultNode::~RelVaultNode () {
     delete state;
 }
 
+//============================================================================
+void RelVaultNode::IIndexKeysChanged () {
+    if (state && state->indexed)
+        IndexNode(this);
+}
+
 //============================================================================
 bool RelVaultNode::IsParentOf (unsigned childId, unsigned maxDepth) {
     if (GetNodeId() == childId)
@@ -1167,6 +1363,11 @@ hsRef<RelVaultNode> RelVaultNode::GetParentNode (
     if (maxDepth == 0)
         return nullptr;
 
+    // Nothing in the vault matches, no need to look
+    const VaultNodeIdSet * ids = FindIndexedNodes(templateNode);
+    if (ids && ids->empty())
+        return nullptr;
+
     RelVaultNodeLink * link;
     link = state->parents.Head();
     for (; link; link = state->parents.Next(link)) {
@@ -1191,6 +1392,30 @@ hsRef<RelVaultNode> RelVaultNode::GetChildNode (
     if (maxDepth == 0)
         return nullptr;
 
+    if (const VaultNodeIdSet * ids = FindIndexedNodes(templateNode)) {
+        if (ids->empty())
+            return nullptr;
+
+        // When there are fewer candidates than children, check where each
+        // candidate sits instead of walking our subtree
+        if (HasMoreLinksThan(state->children, ids->size())) {
+            // direct children first, like the walk below
+            for (unsigned nodeId : *ids) {
+                RelVaultNodeLink * link = state->children.Find(nodeId);
+                if (link && link->node->Matches(templateNode.Get()))
+                    return link->node;
+            }
+            if (maxDepth > 1) {
+                for (unsigned nodeId : *ids) {
+                    RelVaultNodeLink * link = s_nodes.Find(nodeId);
+                    if (link && link->node->IsChildOf(GetNodeId(), maxDepth) && link->node->Matches(templateNode.Get()))
+                        return link->node;
+                }
+            }
+            return nullptr;
+        }
+    }
+
     RelVaultNodeLink * link;
     link = state->children.Head();
     for (; link; link = state->children.Next(link)) {
@@ -1278,6 +1503,11 @@ void RelVaultNode::GetChildNodes (
     unsigned                maxDepth,
     RelVaultNode::RefList * nodes
 ) {
+    // Nothing in the vault matches, no need to look
+    const VaultNodeIdSet * ids = FindIndexedNodes(templateNode);
+    if (ids && ids->empty())
+        return;
+
     RelVaultNodeLink * link;
     link = state->children.Head();
     for (; link; link = state->children.Next(link)) {
@@ -1506,8 +1736,11 @@ void VaultDestroy () {
     for (; link; link = next) {
         next = s_nodes.Next(link);
         link->node->state->UnlinkFromRelatives();
+        UnindexNode(link->node);
         delete link;
     }
+
+    VaultNodeCacheClose();
 }
 
 //============================================================================
@@ -1527,6 +1760,15 @@ hsRef<RelVaultNode> VaultGetNode (
     hsWeakRef<NetVaultNode> templateNode
 ) {
     ASSERT(templateNode);
+    if (const VaultNodeIdSet * ids = FindIndexedNodes(templateNode)) {
+        for (unsigned nodeId : *ids) {
+            RelVaultNodeLink * link = s_nodes.Find(nodeId);
+            if (link && link->node->Matches(templateNode.Get()))
+                return link->node;
+        }
+        return nullptr;
+    }
+
     RelVaultNodeLink * link = s_nodes.Head();
     while (link) {
         if (link->node->Matches(templateNode.Get()))
@@ -1570,6 +1812,7 @@ void VaultAddChildNode (
             childLink = new RelVaultNodeLink(false, ownerId, childId);
             childLink->node->SetNodeId_NoDirty(childId);
             s_nodes.Add(childLink);
+            IndexNode(childLink->node);
         }
         else if (ownerId) {
             childLink->ownerId = ownerId;
@@ -2002,6 +2245,15 @@ void VaultLocalFindNodes (
     hsWeakRef<NetVaultNode> templateNode,
     TArray<unsigned> *      nodeIds
 ) {
+    if (const VaultNodeIdSet * ids = FindIndexedNodes(templateNode)) {
+        for (unsigned nodeId : *ids) {
+            RelVaultNodeLink * link = s_nodes.Find(nodeId);
+            if (link && link->node->Matches(templateNode.Get()))
+                nodeIds->Add(nodeId);
+        }
+        return;
+    }
+
     for (RelVaultNodeLink * link = s_nodes.Head(); link != nil; link = s_nodes.Next(link)) {
         if (link->node->Matches(templateNode.Get()))
             nodeIds->Add(link->node->GetNodeId());
@@ -4609,6 +4861,7 @@ void VaultCull (unsigned vaultId) {
     if (RelVaultNodeLink * link = s_nodes.Find(vaultId)) {
         LogMsg(kLogDebug, "Vault: Culling node {}", link->node->GetNodeId());
         link->node->state->UnlinkFromRelatives();
+        UnindexNode(link->node);
         delete link;
     }
 
@@ -4632,6 +4885,7 @@ void VaultCull (unsigned vaultId) {
         if (!foundRoot) {
             LogMsg(kLogDebug, "Vault: Culling node {}", link->node->GetNodeId());
             link->node->state->UnlinkFromRelatives();
+            UnindexNode(link->node);
             delete link;
         }
     }   
@@ -176,6 +176,9 @@ struct RelVaultNode : NetVaultNode {
     
     // AgeInfoNode-specific (and it checks!)
     hsRef<RelVaultNode> GetParentAgeLink ();
+
+protected:
+    void IIndexKeysChanged () override;
 };
 
 
@@ -0,0 +1,281 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+/*****************************************************************************
+*
+*   $/Plasma20/Sources/Plasma/PubUtilLib/plVault/plVaultNodeCache.cpp
+*   
+***/
+
+#include "Pch.h"
+
+
+/*****************************************************************************
+*
+*   Private
+*
+***/
+
+// The cache is an append-only log of node records.  A record supersedes any
+// earlier one for the same node id, and an empty record marks a node that
+// was deleted.  The log is compacted when it is opened if more than half of
+// it is superseded records, or if the last write was cut short.
+static const uint32_t kCacheMagic       = 0x43444E56;   // 'VNDC'
+static const uint32_t kCacheVersion     = 1;
+static const uint32_t kRecordHeaderSize = 3 * sizeof(uint32_t);
+static const uint32_t kMaxRecordSize    = 16 * 1024 * 1024;
+
+struct CachedNode {
+    uint32_t                modifyTime;
+    std::vector<uint8_t>    buffer;
+};
+
+static std::unordered_map<unsigned, CachedNode> s_cachedNodes;
+static hsUNIXStream s_cacheFile;
+static bool         s_cacheOpen;
+static bool         s_cacheTried;
+
+//============================================================================
+static plFileName GetCachePath () {
+    return plFileName::Join(plFileSystem::GetUserDataPath(), "VaultNodes.cache");
+}
+
+//============================================================================
+// Node ids are only unique per shard, so the cache belongs to one auth server
+static ST::string GetCacheShard () {
+    const ST::string* addrs;
+    if (GetAuthSrvHostnames(addrs) && !addrs[0].empty())
+        return addrs[0];
+    return ST::string();
+}
+
+//============================================================================
+static void WriteRecord (
+    hsStream *      s,
+    unsigned        nodeId,
+    uint32_t        modifyTime,
+    const uint8_t * buffer,
+    uint32_t        size
+) {
+    s->WriteLE32(nodeId);
+    s->WriteLE32(modifyTime);
+    s->WriteLE32(size);
+    if (size)
+        s->Write(size, buffer);
+}
+
+//============================================================================
+static bool ReadCache (
+    const plFileName &  path,
+    const ST::string &  shard,
+    bool *              compact
+) {
+    hsUNIXStream s;
+    if (!s.Open(path, "rb"))
+        return false;
+
+    if (s.ReadLE32() != kCacheMagic || s.ReadLE32() != kCacheVersion ||
+        s.ReadSafeString() != shard)
+    {
+        s.Close();
+        return false;
+    }
+
+    uint32_t fileSize   = s.GetEOF();
+    uint32_t liveBytes  = 0;
+    uint32_t deadBytes  = 0;
+    while (s.GetPosition() + kRecordHeaderSize <= fileSize) {
+        unsigned nodeId     = s.ReadLE32();
+        uint32_t modifyTime = s.ReadLE32();
+        uint32_t size       = s.ReadLE32();
+        if (size > kMaxRecordSize || s.GetPosition() + size > fileSize) {
+            // Partially written record; back up so it counts as truncated
+            s.SetPosition(s.GetPosition() - kRecordHeaderSize);
+            break;
+        }
+
+        auto it = s_cachedNodes.find(nodeId);
+        if (it != s_cachedNodes.end()) {
+            uint32_t oldSize = kRecordHeaderSize + it->second.buffer.size();
+            liveBytes -= oldSize;
+            deadBytes += oldSize;
+        }
+
+        if (!size) {
+            if (it != s_cachedNodes.end())
+                s_cachedNodes.erase(it);
+            deadBytes += kRecordHeaderSize;
+            continue;
+        }
+
+        CachedNode & node = s_cachedNodes[nodeId];
+        node.modifyTime = modifyTime;
+        node.buffer.resize(size);
+        s.Read(size, node.buffer.data());
+        liveBytes += kRecordHeaderSize + size;
+    }
+
+    *compact = (s.GetPosition() != fileSize) || (deadBytes > liveBytes);
+    s.Close();
+    return true;
+}
+
+//============================================================================
+static bool WriteCache (
+    const plFileName &  path,
+    const ST::string &  shard
+) {
+    hsUNIXStream s;
+    if (!s.Open(path, "wb"))
+        return false;
+
+    s.WriteLE32(kCacheMagic);
+    s.WriteLE32(kCacheVersion);
+    s.WriteSafeString(shard);
+    for (const auto & it : s_cachedNodes)
+        WriteRecord(&s, it.first, it.second.modifyTime, it.second.buffer.data(), it.second.buffer.size());
+
+    s.Close();
+    return true;
+}
+
+//============================================================================
+static bool OpenCache () {
+    if (s_cacheTried)
+        return s_cacheOpen;
+    s_cacheTried = true;
+
+    ST::string shard = GetCacheShard();
+    if (shard.empty())
+        return false;
+
+    plFileName path = GetCachePath();
+    bool compact = false;
+    if (!ReadCache(path, shard, &compact)) {
+        s_cachedNodes.clear();
+        compact = true;
+    }
+    if (compact && !WriteCache(path, shard)) {
+        LogMsg(kLogError, "VaultNodeCache: Unable to write {}", path);
+        s_cachedNodes.clear();
+        return false;
+    }
+
+    s_cacheOpen = s_cacheFile.Open(path, "ab");
+    if (!s_cacheOpen)
+        s_cachedNodes.clear();
+    else
+        LogMsg(kLogDebug, "VaultNodeCache: {} nodes cached for {}", s_cachedNodes.size(), shard);
+    return s_cacheOpen;
+}
+
+
+/*****************************************************************************
+*
+*   Exports
+*
+***/
+
+//============================================================================
+void VaultNodeCacheClose () {
+    if (s_cacheOpen)
+        s_cacheFile.Close();
+    s_cachedNodes.clear();
+    s_cacheOpen  = false;
+    s_cacheTried = false;
+}
+
+//============================================================================
+hsRef<NetVaultNode> VaultNodeCacheFind (unsigned nodeId) {
+    if (!OpenCache())
+        return nullptr;
+
+    auto it = s_cachedNodes.find(nodeId);
+    if (it == s_cachedNodes.end())
+        return nullptr;
+
+    hsRef<NetVaultNode> node(new NetVaultNode, hsStealRef);
+    node->Read(it->second.buffer.data(), it->second.buffer.size());
+    if (node->GetNodeId() != nodeId || !node->GetNodeType()) {
+        // Not what we wrote; forget it so it gets fetched instead
+        VaultNodeCacheRemove(nodeId);
+        return nullptr;
+    }
+    return node;
+}
+
+//============================================================================
+void VaultNodeCacheStore (NetVaultNode * node) {
+    if (!node->GetNodeId() || !node->GetNodeType())
+        return;
+    if (!OpenCache())
+        return;
+
+    TArray<uint8_t> buffer;
+    node->Write(&buffer);
+    if (buffer.Count() > kMaxRecordSize)
+        return;
+
+    // Modify times only go down to the second, so a node changed twice in one
+    // second keeps its time.  Only skip the write if the contents are the same.
+    auto it = s_cachedNodes.find(node->GetNodeId());
+    if (it != s_cachedNodes.end() && it->second.buffer.size() == buffer.Count() &&
+        std::equal(it->second.buffer.begin(), it->second.buffer.end(), buffer.Ptr()))
+        return;
+
+    CachedNode & cached = s_cachedNodes[node->GetNodeId()];
+    cached.modifyTime = node->GetModifyTime();
+    cached.buffer.assign(buffer.Ptr(), buffer.Ptr() + buffer.Count());
+    WriteRecord(&s_cacheFile, node->GetNodeId(), cached.modifyTime, buffer.Ptr(), buffer.Count());
+}
+
+//============================================================================
+void VaultNodeCacheRemove (unsigned nodeId) {
+    if (!OpenCache())
+        return;
+
+    auto it = s_cachedNodes.find(nodeId);
+    if (it == s_cachedNodes.end())
+        return;
+
+    s_cachedNodes.erase(it);
+    WriteRecord(&s_cacheFile, nodeId, 0, nullptr, 0);
+}
@@ -0,0 +1,111 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+// Rough throughput numbers for hsJobSystem: tiny jobs measure scheduling
+// overhead, a ParallelFor over a big array measures how well it scales.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "HeadSpin.h"
+#include "hsJobSystem.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double MillisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double BenchTinyJobs(size_t numJobs)
+{
+    std::atomic<size_t> count(0);
+    Clock::time_point start = Clock::now();
+
+    hsJobGroup group;
+    for (size_t i = 0; i < numJobs; i++)
+        group.Run([&count] () { ++count; });
+    group.Wait();
+
+    return MillisecondsSince(start);
+}
+
+static double BenchParallelFor(std::vector<float>& data)
+{
+    Clock::time_point start = Clock::now();
+
+    hsJobSystem::ParallelFor(0, data.size(), 0, [&data] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            data[i] = std::sqrt(data[i] * 1.0001f + 1.f);
+    });
+
+    return MillisecondsSince(start);
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned numWorkers = argc > 1 ? unsigned(atoi(argv[1])) : 0;
+    const size_t kTinyJobs = 200000;
+    const size_t kElements = 16 * 1024 * 1024;
+
+    std::vector<float> data(kElements, 1.f);
+
+    // Single threaded baseline, before the workers exist
+    double serialMs = BenchParallelFor(data);
+
+    hsJobSystem::Init(numWorkers);
+    printf("workers:             %u\n", hsJobSystem::GetNumWorkers());
+
+    double tinyMs = BenchTinyJobs(kTinyJobs);
+    printf("tiny jobs:           %zu in %.2f ms (%.0f ns/job)\n",
+           kTinyJobs, tinyMs, tinyMs * 1.0e6 / kTinyJobs);
+
+    double parallelMs = BenchParallelFor(data);
+    printf("parallel for:        %.2f ms serial, %.2f ms parallel (%.2fx)\n",
+           serialMs, parallelMs, serialMs / parallelMs);
+
+    hsJobSystem::Shutdown();
+    return 0;
+}
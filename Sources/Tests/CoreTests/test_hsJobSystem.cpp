@@ -0,0 +1,121 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+#include "HeadSpin.h"
+#include "hsJobSystem.h"
+
+class hsJobSystemTest : public ::testing::Test
+{
+protected:
+    void SetUp() override { hsJobSystem::Init(3); }
+    void TearDown() override { hsJobSystem::Shutdown(); }
+};
+
+TEST_F(hsJobSystemTest, group_runs_every_job)
+{
+    std::atomic<int> count(0);
+    hsJobGroup group;
+    for (int i = 0; i < 1000; i++)
+        group.Run([&count] () { ++count; });
+    group.Wait();
+
+    EXPECT_TRUE(group.IsDone());
+    EXPECT_EQ(count.load(), 1000);
+}
+
+TEST_F(hsJobSystemTest, nested_groups)
+{
+    std::atomic<int> count(0);
+    hsJobGroup outer;
+    for (int i = 0; i < 16; i++)
+    {
+        outer.Run([&count] () {
+            hsJobGroup inner;
+            for (int j = 0; j < 16; j++)
+                inner.Run([&count] () { ++count; });
+            inner.Wait();
+        });
+    }
+    outer.Wait();
+
+    EXPECT_EQ(count.load(), 256);
+}
+
+TEST_F(hsJobSystemTest, parallel_for_covers_range)
+{
+    std::vector<int> hits(10007, 0);
+    hsJobSystem::ParallelFor(0, hits.size(), 0, [&hits] (size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            hits[i]++;
+    });
+
+    for (size_t i = 0; i < hits.size(); i++)
+        ASSERT_EQ(hits[i], 1) << "index " << i;
+}
+
+TEST_F(hsJobSystemTest, main_thread_jobs)
+{
+    std::atomic<bool> ranOnMain(false);
+    hsJobGroup group;
+    group.Run([&ranOnMain] () {
+        hsJobSystem::RunOnMainThread([&ranOnMain] () {
+            ranOnMain = hsJobSystem::IsMainThread();
+        });
+    });
+    group.Wait();
+
+    EXPECT_FALSE(ranOnMain.load());
+    hsJobSystem::ProcessMainThreadJobs();
+    EXPECT_TRUE(ranOnMain.load());
+}
+
+TEST(hsJobSystem, runs_inline_without_workers)
+{
+    int count = 0;
+    hsJobGroup group;
+    group.Run([&count] () { ++count; });
+    EXPECT_EQ(count, 1);
+    EXPECT_TRUE(group.IsDone());
+}
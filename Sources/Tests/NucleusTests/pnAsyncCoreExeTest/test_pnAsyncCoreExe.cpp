@@ -0,0 +1,498 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "HeadSpin.h"
+#include "pnUtils/pnUtils.h"
+#include "pnNetBase/pnNetBase.h"
+#include "pnAsyncCore/pnAsyncCore.h"
+
+using namespace std::chrono_literals;
+
+// All completions arrive on the library's own threads; callbacks record what
+// happened in s_state and the test thread waits for it with a timeout.
+struct TestState
+{
+    unsigned                  timerCalls = 0;
+
+    bool                      lookupDone = false;
+    std::string               lookupName;
+    std::vector<plNetAddress> lookupAddrs;
+
+    AsyncSocket               client = nullptr;
+    bool                      connectFailed = false;
+    bool                      clientDisconnected = false;
+    std::string               clientReceived;
+    std::vector<void*>        writesCompleted;
+
+    AsyncSocket               server = nullptr;
+    unsigned                  serverConnType = 0;
+    bool                      serverDisconnected = false;
+    std::string               serverReceived;
+};
+
+static std::mutex              s_lock;
+static std::condition_variable s_signal;
+static TestState               s_state;
+
+template <typename _Fn>
+static void Record(_Fn fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+        fn(s_state);
+    }
+    s_signal.notify_all();
+}
+
+template <typename _Pred>
+static bool WaitFor(_Pred pred)
+{
+    std::unique_lock<std::mutex> lock(s_lock);
+    return s_signal.wait_for(lock, 10s, [&pred] { return pred(s_state); });
+}
+
+static plNetAddress Loopback(uint16_t port = 0)
+{
+    return plNetAddress(htonl(INADDR_LOOPBACK), port);
+}
+
+enum class Backend
+{
+    Default,        // io_uring socket writes where the kernel allows it
+    EpollFallback,  // io_uring setup fails, so writes are sent by epoll
+};
+
+// Starts the library with io_uring setup failing. The reactor creates its
+// epoll instance and wakeup eventfd first, so only leave room for those two
+// descriptors; the ring then fails with EMFILE and the library falls back.
+static void InitializeWithoutUring()
+{
+    int first = open("/dev/null", O_RDONLY);
+    int second = open("/dev/null", O_RDONLY);
+    close(first);
+    close(second);
+
+    rlimit saved;
+    ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &saved));
+    rlimit limited = saved;
+    limited.rlim_cur = std::max(first, second) + 1;
+    ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &limited));
+    AsyncCoreInitialize();
+    ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &saved));
+}
+
+class pnAsyncCoreExe : public ::testing::TestWithParam<Backend>
+{
+protected:
+    void SetUp() override
+    {
+        s_state = TestState();
+        if (GetParam() == Backend::EpollFallback)
+            InitializeWithoutUring();
+        else
+            AsyncCoreInitialize();
+    }
+
+    void TearDown() override
+    {
+        AsyncCoreDestroy(5 * 1000);
+    }
+};
+
+
+/****************************************************************************
+*
+*   Notification procs
+*
+***/
+
+static bool ClientNotifyProc(AsyncSocket sock, EAsyncNotifySocket code,
+                             AsyncNotifySocket* notify, void**)
+{
+    switch (code) {
+    case kNotifySocketConnectSuccess:
+        Record([sock](TestState& s) { s.client = sock; });
+        break;
+
+    case kNotifySocketConnectFailed:
+        Record([](TestState& s) { s.connectFailed = true; });
+        break;
+
+    case kNotifySocketRead: {
+        AsyncNotifySocketRead* read = (AsyncNotifySocketRead*)notify;
+        Record([read](TestState& s) {
+            s.clientReceived.append((const char*)read->buffer, read->bytes);
+        });
+        read->bytesProcessed += read->bytes;
+        break;
+    }
+
+    case kNotifySocketWrite: {
+        void* param = notify->param;
+        Record([param](TestState& s) { s.writesCompleted.push_back(param); });
+        break;
+    }
+
+    case kNotifySocketDisconnect:
+        AsyncSocketDelete(sock);
+        Record([](TestState& s) { s.clientDisconnected = true; });
+        break;
+
+    default:
+        break;
+    }
+    return true;
+}
+
+// Echoes everything it receives back to the sender
+static bool EchoNotifyProc(AsyncSocket sock, EAsyncNotifySocket code,
+                           AsyncNotifySocket* notify, void**)
+{
+    switch (code) {
+    case kNotifySocketListenSuccess: {
+        unsigned connType = ((AsyncNotifySocketListen*)notify)->connType;
+        Record([sock, connType](TestState& s) {
+            s.server = sock;
+            s.serverConnType = connType;
+        });
+        break;
+    }
+
+    case kNotifySocketRead: {
+        AsyncNotifySocketRead* read = (AsyncNotifySocketRead*)notify;
+        Record([read](TestState& s) {
+            s.serverReceived.append((const char*)read->buffer, read->bytes);
+        });
+        AsyncSocketSend(sock, read->buffer, read->bytes);
+        read->bytesProcessed += read->bytes;
+        break;
+    }
+
+    case kNotifySocketDisconnect:
+        AsyncSocketDelete(sock);
+        Record([](TestState& s) { s.serverDisconnected = true; });
+        break;
+
+    default:
+        break;
+    }
+    return true;
+}
+
+// Swallows everything it receives
+static bool SinkNotifyProc(AsyncSocket sock, EAsyncNotifySocket code,
+                           AsyncNotifySocket* notify, void** userState)
+{
+    if (code != kNotifySocketRead)
+        return EchoNotifyProc(sock, code, notify, userState);
+
+    AsyncNotifySocketRead* read = (AsyncNotifySocketRead*)notify;
+    Record([read](TestState& s) {
+        s.serverReceived.append((const char*)read->buffer, read->bytes);
+    });
+    read->bytesProcessed += read->bytes;
+    return true;
+}
+
+static void ConnectToLoopback(FAsyncNotifySocketProc serverProc,
+                              uint16_t* port)
+{
+    *port = (uint16_t)AsyncSocketStartListening(Loopback(), serverProc);
+    ASSERT_NE(0, *port);
+
+    AsyncCancelId cancelId;
+    AsyncSocketConnect(&cancelId, Loopback(*port), ClientNotifyProc);
+    ASSERT_TRUE(WaitFor([](TestState& s) { return s.client && s.server; }));
+}
+
+static void DisconnectClient(uint16_t port, FAsyncNotifySocketProc serverProc)
+{
+    AsyncSocketDisconnect(s_state.client, false);
+    EXPECT_TRUE(WaitFor([](TestState& s) {
+        return s.clientDisconnected && s.serverDisconnected;
+    }));
+    AsyncSocketStopListening(Loopback(port), serverProc);
+}
+
+
+/****************************************************************************
+*
+*   Sockets
+*
+***/
+
+TEST_P(pnAsyncCoreExe, socket_send_echo)
+{
+    uint16_t port;
+    ConnectToLoopback(EchoNotifyProc, &port);
+
+    EXPECT_TRUE(AsyncSocketSend(s_state.client, "Hello ", 6));
+    EXPECT_TRUE(AsyncSocketSend(s_state.client, "World", 5));
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.clientReceived.size() >= 11; }));
+    EXPECT_EQ("Hello World", s_state.clientReceived);
+
+    DisconnectClient(port, EchoNotifyProc);
+}
+
+TEST_P(pnAsyncCoreExe, socket_write_notifies)
+{
+    uint16_t port;
+    ConnectToLoopback(EchoNotifyProc, &port);
+
+    static const char kData[] = "notify me";
+    int param;
+    EXPECT_TRUE(AsyncSocketWrite(s_state.client, kData, sizeof(kData) - 1, &param));
+    EXPECT_TRUE(WaitFor([](TestState& s) {
+        return !s.writesCompleted.empty() && s.clientReceived.size() >= sizeof(kData) - 1;
+    }));
+    ASSERT_EQ(1, s_state.writesCompleted.size());
+    EXPECT_EQ(&param, s_state.writesCompleted[0]);
+    EXPECT_EQ(kData, s_state.clientReceived);
+
+    DisconnectClient(port, EchoNotifyProc);
+}
+
+TEST_P(pnAsyncCoreExe, socket_send_queues_large_backlog)
+{
+    uint16_t port;
+    ConnectToLoopback(SinkNotifyProc, &port);
+
+    // Far more than the kernel will buffer, so most of it has to be queued
+    // and flushed by the reactor as the socket drains
+    std::string data;
+    for (unsigned i = 0; data.size() < 8 * 1024 * 1024; ++i)
+        data += std::to_string(i) + ',';
+
+    AsyncSocketSetBacklogAlloc(s_state.client, 64 * 1024);
+    for (size_t offset = 0; offset < data.size(); offset += 60 * 1024) {
+        size_t bytes = std::min<size_t>(60 * 1024, data.size() - offset);
+        ASSERT_TRUE(AsyncSocketSend(s_state.client, data.data() + offset, (unsigned)bytes));
+    }
+
+    // A graceful disconnect must not drop anything still queued
+    DisconnectClient(port, SinkNotifyProc);
+    EXPECT_EQ(data.size(), s_state.serverReceived.size());
+    EXPECT_TRUE(data == s_state.serverReceived);
+}
+
+TEST_P(pnAsyncCoreExe, socket_hard_close_disconnects_peer)
+{
+    uint16_t port;
+    ConnectToLoopback(EchoNotifyProc, &port);
+
+    AsyncSocketDisconnect(s_state.server, true);
+    EXPECT_TRUE(WaitFor([](TestState& s) {
+        return s.clientDisconnected && s.serverDisconnected;
+    }));
+    AsyncSocketStopListening(Loopback(port), EchoNotifyProc);
+}
+
+TEST_P(pnAsyncCoreExe, socket_connect_packet_selects_notify_proc)
+{
+    AsyncSocketRegisterNotifyProc(kConnTypeDebug, EchoNotifyProc);
+    uint16_t port = (uint16_t)AsyncSocketStartListening(Loopback());
+    ASSERT_NE(0, port);
+
+    struct {
+        AsyncSocketConnectPacket hdr;
+        char                     payload[5];
+    } connect;
+    connect.hdr.connType  = kConnTypeDebug;
+    connect.hdr.hdrBytes  = sizeof(connect.hdr);
+    connect.hdr.buildId   = 0;
+    connect.hdr.buildType = 0;
+    connect.hdr.branchId  = 0;
+    connect.hdr.productId = kNilUuid;
+    memcpy(connect.payload, "hello", 5);
+
+    AsyncCancelId cancelId;
+    AsyncSocketConnect(&cancelId, Loopback(port), ClientNotifyProc, nullptr,
+                       &connect, sizeof(connect));
+
+    // The payload following the header is echoed back
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.clientReceived.size() >= 5; }));
+    EXPECT_EQ(kConnTypeDebug, s_state.serverConnType);
+    EXPECT_EQ("hello", s_state.clientReceived);
+
+    DisconnectClient(port, nullptr);
+    AsyncSocketUnregisterNotifyProc(kConnTypeDebug, EchoNotifyProc);
+}
+
+TEST_P(pnAsyncCoreExe, socket_connect_refused)
+{
+    // Grab a free port, then stop listening on it
+    uint16_t port = (uint16_t)AsyncSocketStartListening(Loopback(), EchoNotifyProc);
+    ASSERT_NE(0, port);
+    AsyncSocketStopListening(Loopback(port), EchoNotifyProc);
+
+    AsyncCancelId cancelId;
+    AsyncSocketConnect(&cancelId, Loopback(port), ClientNotifyProc);
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.connectFailed; }));
+    EXPECT_EQ(nullptr, s_state.client);
+}
+
+TEST_P(pnAsyncCoreExe, socket_connect_cancel)
+{
+    // Nothing answers on this address, so the attempt stays pending
+    AsyncCancelId cancelId;
+    AsyncSocketConnect(&cancelId, plNetAddress(htonl(0xC0000201), 9), ClientNotifyProc);
+    AsyncSocketConnectCancel(ClientNotifyProc, cancelId);
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.connectFailed; }));
+    EXPECT_EQ(nullptr, s_state.client);
+}
+
+
+TEST_P(pnAsyncCoreExe, socket_peer_reset_does_not_raise_sigpipe)
+{
+    uint16_t port;
+    ConnectToLoopback(SinkNotifyProc, &port);
+
+    // Writes to a reset socket raise SIGPIPE unless suppressed, and the
+    // default action would end the test run
+    AsyncSocketDisconnect(s_state.server, true);
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.serverDisconnected; }));
+
+    char data[kAsyncSocketBufferSize] = {};
+    for (unsigned i = 0; i < 1000 && AsyncSocketSend(s_state.client, data, sizeof(data)); ++i)
+        std::this_thread::sleep_for(1ms);
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.clientDisconnected; }));
+    AsyncSocketStopListening(Loopback(port), SinkNotifyProc);
+}
+
+TEST_P(pnAsyncCoreExe, socket_writes_use_selected_backend)
+{
+    uint16_t port;
+    ConnectToLoopback(EchoNotifyProc, &port);
+
+    long uringWrites = AsyncPerfGetCounter(kAsyncPerfSocketUringWritesTotal);
+    EXPECT_TRUE(AsyncSocketSend(s_state.client, "ping", 4));
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.clientReceived.size() >= 4; }));
+    EXPECT_EQ("ping", s_state.clientReceived);
+    uringWrites = AsyncPerfGetCounter(kAsyncPerfSocketUringWritesTotal) - uringWrites;
+
+    DisconnectClient(port, EchoNotifyProc);
+
+    if (GetParam() == Backend::EpollFallback)
+        EXPECT_EQ(0, uringWrites);
+    else if (!uringWrites)
+        GTEST_SKIP() << "io_uring is not available; only the epoll path ran";
+}
+
+
+/****************************************************************************
+*
+*   Timers
+*
+***/
+
+static unsigned CountdownTimerProc(void*)
+{
+    unsigned calls;
+    Record([&calls](TestState& s) { calls = ++s.timerCalls; });
+    return calls < 3 ? 10 : kAsyncTimeInfinite;
+}
+
+TEST_P(pnAsyncCoreExe, timer_repeats_until_infinite)
+{
+    AsyncTimer* timer;
+    AsyncTimerCreate(&timer, CountdownTimerProc, 0);
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.timerCalls == 3; }));
+
+    // The timer stays idle until it is rescheduled
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(3, s_state.timerCalls);
+    AsyncTimerUpdate(timer, 0);
+    EXPECT_TRUE(WaitFor([](TestState& s) { return s.timerCalls == 4; }));
+
+    AsyncTimerDelete(timer, kAsyncTimerDestroyWaitComplete);
+}
+
+
+/****************************************************************************
+*
+*   Dns
+*
+***/
+
+static void LookupProc(void*, const char name[], unsigned addrCount,
+                       const plNetAddress addrs[])
+{
+    Record([&](TestState& s) {
+        s.lookupDone = true;
+        s.lookupName = name;
+        s.lookupAddrs.assign(addrs, addrs + addrCount);
+    });
+}
+
+TEST_P(pnAsyncCoreExe, dns_lookup_name_with_port)
+{
+    AsyncCancelId cancelId;
+    AsyncAddressLookupName(&cancelId, LookupProc, "127.0.0.1:14617", 0, nullptr);
+    ASSERT_TRUE(WaitFor([](TestState& s) { return s.lookupDone; }));
+    ASSERT_EQ(1, s_state.lookupAddrs.size());
+    EXPECT_EQ(Loopback(14617), s_state.lookupAddrs[0]);
+}
+
+TEST_P(pnAsyncCoreExe, dns_lookup_failure_reports_no_addresses)
+{
+    AsyncCancelId cancelId;
+    AsyncAddressLookupName(&cancelId, LookupProc, "nonexistent.invalid", 80, nullptr);
+    ASSERT_TRUE(WaitFor([](TestState& s) { return s.lookupDone; }));
+    EXPECT_EQ(0, s_state.lookupAddrs.size());
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, pnAsyncCoreExe,
+    ::testing::Values(Backend::Default, Backend::EpollFallback),
+    [](const ::testing::TestParamInfo<Backend>& info) {
+        return info.param == Backend::Default ? "Default" : "EpollFallback";
+    });
@@ -0,0 +1,216 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "HeadSpin.h"
+#include "plMath/hsRadixSort.h"
+
+// Lets the tests see whether SortNearlySorted() gave up on the insertion sort
+class TestRadixSortArray : public hsRadixSortArray
+{
+public:
+    bool InsertionSortOnly(const float* keys, uint32_t count)
+    {
+        ISetup(keys, count);
+        return IInsertionSort(count);
+    }
+};
+
+static std::vector<uint32_t> IStableOrder(const std::vector<float>& keys)
+{
+    std::vector<uint32_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) {
+        return keys[a] < keys[b];
+    });
+    return order;
+}
+
+// Both sorts have to give exactly the stable order, ties included
+static void ICheckSorts(const std::vector<float>& keys)
+{
+    std::vector<uint32_t> expected = IStableOrder(keys);
+    uint32_t count = uint32_t(keys.size());
+
+    hsRadixSortArray sorter;
+    const uint32_t* order = sorter.Sort(keys.data(), count);
+    std::vector<uint32_t> sorted(order, order + count);
+    EXPECT_EQ(expected, sorted) << "Sort, " << count << " keys";
+
+    order = sorter.SortNearlySorted(keys.data(), count);
+    std::vector<uint32_t> nearlySorted(order, order + count);
+    EXPECT_EQ(expected, nearlySorted) << "SortNearlySorted, " << count << " keys";
+}
+
+TEST(hsRadixSortArray, Empty)
+{
+    hsRadixSortArray sorter;
+    sorter.Sort(nullptr, 0);
+    sorter.SortNearlySorted(nullptr, 0);
+
+    float key = 1.f;
+    EXPECT_EQ(0, sorter.Sort(&key, 1)[0]);
+    EXPECT_EQ(0, sorter.SortNearlySorted(&key, 1)[0]);
+}
+
+TEST(hsRadixSortArray, Random)
+{
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> dist(-1.e4f, 1.e4f);
+
+    // odd sizes too, so the keys don't always come in whole SIMD blocks
+    for (uint32_t count : { 2u, 3u, 5u, 16u, 33u, 255u, 1000u, 4099u })
+    {
+        std::vector<float> keys(count);
+        for (float& key : keys)
+            key = dist(rng);
+        ICheckSorts(keys);
+    }
+}
+
+TEST(hsRadixSortArray, NegativeKeys)
+{
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<float> dist(-1.e6f, -1.e-6f);
+
+    std::vector<float> keys(500);
+    for (float& key : keys)
+        key = dist(rng);
+    ICheckSorts(keys);
+
+    // both signs, tiny and huge magnitudes
+    std::vector<float> mixed = { -1.f, 1.f, -1.e30f, 1.e30f, -1.e-30f, 1.e-30f, -2.5f, 2.5f, -1.f, 1.f };
+    ICheckSorts(mixed);
+}
+
+TEST(hsRadixSortArray, TiesAreStable)
+{
+    std::mt19937 rng(31);
+
+    std::vector<float> keys(2000);
+    for (float& key : keys)
+        key = float(int(rng() % 7) - 3) * 0.25f;
+    ICheckSorts(keys);
+
+    std::vector<float> same(100, -4.f);
+    ICheckSorts(same);
+}
+
+TEST(hsRadixSortArray, SkippedBytePasses)
+{
+    std::mt19937 rng(41);
+
+    // Whole numbers leave the low mantissa bytes zero, so the first passes
+    // have nothing to do
+    std::vector<float> whole(300);
+    for (float& key : whole)
+        key = float(int(rng() % 64) - 32);
+    ICheckSorts(whole);
+
+    // Everything in [1, 2) shares the top byte, only the last pass is skipped
+    std::uniform_real_distribution<float> oneToTwo(1.f, 2.f);
+    std::vector<float> sameTop(300);
+    for (float& key : sameTop)
+        key = oneToTwo(rng);
+    ICheckSorts(sameTop);
+
+    // Keys only differing in the lowest byte, an odd number of passes
+    std::vector<float> lowByte(300);
+    for (size_t i = 0; i < lowByte.size(); i++)
+    {
+        uint32_t bits = 0x3f800000 | uint32_t(rng() % 256);
+        memcpy(&lowByte[i], &bits, sizeof(bits));
+    }
+    ICheckSorts(lowByte);
+}
+
+TEST(hsRadixSortArray, NearlySorted)
+{
+    std::mt19937 rng(53);
+    std::uniform_real_distribution<float> jitter(-0.6f, 0.6f);
+
+    // Last frame's order with a little movement, the insertion sort handles it
+    std::vector<float> keys(1000);
+    for (size_t i = 0; i < keys.size(); i++)
+        keys[i] = float(i) + jitter(rng);
+
+    TestRadixSortArray sorter;
+    EXPECT_TRUE(sorter.InsertionSortOnly(keys.data(), uint32_t(keys.size())));
+    ICheckSorts(keys);
+
+    // Already in order, nothing to do at all
+    std::vector<float> inOrder(100);
+    for (size_t i = 0; i < inOrder.size(); i++)
+        inOrder[i] = float(i / 3);
+    EXPECT_TRUE(sorter.InsertionSortOnly(inOrder.data(), uint32_t(inOrder.size())));
+    ICheckSorts(inOrder);
+}
+
+TEST(hsRadixSortArray, InsertionSortBailOut)
+{
+    TestRadixSortArray sorter;
+
+    // Too many pairs out of order to start with
+    std::vector<float> reversed(200);
+    for (size_t i = 0; i < reversed.size(); i++)
+        reversed[i] = -float(i);
+    EXPECT_FALSE(sorter.InsertionSortOnly(reversed.data(), uint32_t(reversed.size())));
+    ICheckSorts(reversed);
+
+    // Only one pair out of order, but the keys after it all belong at the
+    // front, so the shift budget runs out part way through.  Duplicates on
+    // both sides make sure the radix sort still gets them in order after that.
+    std::vector<float> tail(1000);
+    for (size_t i = 0; i < 900; i++)
+        tail[i] = float(i / 2);
+    for (size_t i = 900; i < tail.size(); i++)
+        tail[i] = float(int(i - 900) / 10 - 10);
+    EXPECT_FALSE(sorter.InsertionSortOnly(tail.data(), uint32_t(tail.size())));
+    ICheckSorts(tail);
+}
@@ -0,0 +1,211 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include "hsStream.h"
+
+#include "plSDL/plSDL.h"
+
+static const int kNumElements = 8;
+
+// a descriptor with a fixed size int array, which can be sent as element deltas,
+// and a plain int next to it
+static plStateDescriptor* IMakeDescriptor()
+{
+    plStateDescriptor* desc = new plStateDescriptor;
+    desc->SetName("DeltaTest");
+    desc->SetVersion(1);
+
+    plSimpleVarDescriptor* values = new plSimpleVarDescriptor;
+    values->SetName("values");
+    values->SetType("INT");
+    values->SetCount(kNumElements);
+    desc->AddVar(values);
+
+    plSimpleVarDescriptor* flag = new plSimpleVarDescriptor;
+    flag->SetName("flag");
+    flag->SetType("INT");
+    desc->AddVar(flag);
+
+    return desc;
+}
+
+static void ISetValues(plStateDataRecord& rec, const int* values, int flag)
+{
+    plSimpleStateVariable* var = rec.FindVar("values");
+    for (int i = 0; i < kNumElements; i++)
+        var->Set(values[i], i);
+    rec.FindVar("flag")->Set(flag);
+}
+
+static void IGetValues(const plStateDataRecord& rec, int* values)
+{
+    plSimpleStateVariable* var = rec.FindVar("values");
+    for (int i = 0; i < kNumElements; i++)
+        var->Get(&values[i], i);
+}
+
+// what the sender has cached and what it sends next, like plSDLModifier::SendState
+struct DeltaTestSender
+{
+    plStateDataRecord fCache;
+    plStateDataRecord fCur;
+
+    DeltaTestSender(plStateDescriptor* desc, const int* base, const int* cur)
+        : fCache(desc), fCur(desc)
+    {
+        ISetValues(fCache, base, 1);
+        ISetValues(fCur, cur, 1);
+        fCur.FlagDifferentState(fCache);
+    }
+};
+
+TEST(plStateDataRecord, ElementDeltaRoundTrip)
+{
+    plStateDescriptor* desc = IMakeDescriptor();
+
+    const int base[kNumElements] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    const int cur[kNumElements]  = { 0, 1, 20, 30, 4, 5, 60, 7 };
+    DeltaTestSender sender(desc, base, cur);
+
+    // only the array changed, and only some of its elements
+    EXPECT_TRUE(sender.fCur.FindVar("values")->IsDirty());
+    EXPECT_FALSE(sender.fCur.FindVar("flag")->IsDirty());
+    EXPECT_TRUE(sender.fCur.HasElementDeltas());
+
+    // the receiver got the full state earlier
+    hsRAMStream fullStream;
+    sender.fCache.Write(&fullStream, 0);
+    fullStream.Rewind();
+
+    plStateDataRecord recvCache(desc);
+    ASSERT_TRUE(recvCache.Read(&fullStream, 0));
+    EXPECT_FALSE(recvCache.HasElementDeltas());
+
+    // now the delta
+    uint32_t deltaOptions = plSDL::kDirtyOnly | plSDL::kDeltaEncode;
+    hsRAMStream deltaStream;
+    sender.fCur.Write(&deltaStream, 0, deltaOptions);
+
+    hsRAMStream dirtyStream;
+    sender.fCur.Write(&dirtyStream, 0, plSDL::kDirtyOnly);
+    EXPECT_LT(deltaStream.GetEOF(), dirtyStream.GetEOF());
+
+    deltaStream.Rewind();
+    plStateDataRecord recv(desc);
+    ASSERT_TRUE(recv.Read(&deltaStream, 0, plSDL::kDeltaEncode));
+    EXPECT_EQ(deltaStream.GetPosition(), deltaStream.GetEOF());
+    EXPECT_TRUE(recv.HasElementDeltas());
+    EXPECT_FALSE(recv.FindVar("flag")->IsUsed());
+
+    EXPECT_TRUE(recv.ResolveElementDeltas(recvCache));
+    EXPECT_FALSE(recv.HasElementDeltas());
+    EXPECT_TRUE(recv.FindVar("values")->IsUsed());
+
+    int values[kNumElements];
+    IGetValues(recv, values);
+    for (int i = 0; i < kNumElements; i++)
+        EXPECT_EQ(cur[i], values[i]) << "element " << i;
+
+    // once resolved it can be applied like any other state
+    recvCache.UpdateFrom(recv, false);
+    IGetValues(recvCache, values);
+    for (int i = 0; i < kNumElements; i++)
+        EXPECT_EQ(cur[i], values[i]) << "element " << i;
+
+    // the sender caches whole values after sending
+    sender.fCur.ClearElementDeltas();
+    EXPECT_FALSE(sender.fCur.HasElementDeltas());
+    IGetValues(sender.fCur, values);
+    for (int i = 0; i < kNumElements; i++)
+        EXPECT_EQ(cur[i], values[i]) << "element " << i;
+
+    delete desc;
+}
+
+TEST(plStateDataRecord, ElementDeltaBaselineMismatch)
+{
+    plStateDescriptor* desc = IMakeDescriptor();
+
+    const int base[kNumElements] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    const int cur[kNumElements]  = { 0, 1, 20, 30, 4, 5, 60, 7 };
+    DeltaTestSender sender(desc, base, cur);
+
+    // the receiver missed an update, its copy isn't what the sender diffed against
+    const int stale[kNumElements] = { 0, 1, 2, 3, 4, 50, 6, 7 };
+    plStateDataRecord recvCache(desc);
+    ISetValues(recvCache, stale, 1);
+
+    hsRAMStream deltaStream;
+    sender.fCur.Write(&deltaStream, 0, plSDL::kDirtyOnly | plSDL::kDeltaEncode);
+    deltaStream.Rewind();
+
+    plStateDataRecord recv(desc);
+    ASSERT_TRUE(recv.Read(&deltaStream, 0, plSDL::kDeltaEncode));
+    ASSERT_TRUE(recv.HasElementDeltas());
+
+    // the var can't be completed, it is dropped and the receiver has to ask for the
+    // full state (plSDLModifier::ReceiveState) instead of applying a mix of both
+    EXPECT_FALSE(recv.ResolveElementDeltas(recvCache));
+    EXPECT_FALSE(recv.HasElementDeltas());
+    EXPECT_FALSE(recv.FindVar("values")->IsUsed());
+    EXPECT_FALSE(recv.FindVar("values")->IsDirty());
+    EXPECT_FALSE(recv.IsUsed());
+
+    // a full state resolves nothing and is used as is
+    hsRAMStream fullStream;
+    sender.fCur.Write(&fullStream, 0);
+    fullStream.Rewind();
+
+    plStateDataRecord full(desc);
+    ASSERT_TRUE(full.Read(&fullStream, 0));
+    EXPECT_FALSE(full.HasElementDeltas());
+    EXPECT_TRUE(full.ResolveElementDeltas(recvCache));
+
+    int values[kNumElements];
+    IGetValues(full, values);
+    for (int i = 0; i < kNumElements; i++)
+        EXPECT_EQ(cur[i], values[i]) << "element " << i;
+
+    delete desc;
+}
@@ -0,0 +1,260 @@
+/*==LICENSE==*
+
+CyanWorlds.com Engine - MMOG client, server and tools
+Copyright (C) 2011  Cyan Worlds, Inc.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Additional permissions under GNU GPL version 3 section 7
+
+If you modify this Program, or any covered work, by linking or
+combining it with any of RAD Game Tools Bink SDK, Autodesk 3ds Max SDK,
+NVIDIA PhysX SDK, Microsoft DirectX SDK, OpenSSL library, Independent
+JPEG Group JPEG library, Microsoft Windows Media SDK, or Apple QuickTime SDK
+(or a modified version of those libraries),
+containing parts covered by the terms of the Bink SDK EULA, 3ds Max EULA,
+PhysX SDK EULA, DirectX SDK EULA, OpenSSL and SSLeay licenses, IJG
+JPEG Library README, Windows Media SDK EULA, or QuickTime SDK EULA, the
+licensors of this Program grant you additional
+permission to convey the resulting work. Corresponding Source for a
+non-source form of such a combination shall include the source code for
+the parts of OpenSSL and IJG JPEG Library used as well as that of the covered
+work.
+
+You can contact Cyan Worlds, Inc. by email legal@cyan.com
+ or by snail mail at:
+      Cyan Worlds, Inc.
+      14617 N Newport Hwy
+      Mead, WA   99021
+
+*==LICENSE==*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "plDrawable/plSpaceTree.h"
+#include "plDrawable/plSpaceTreeMaker.h"
+
+struct TestLeaf
+{
+    hsBounds3Ext    fBounds;
+    bool            fDisabled;
+};
+
+static hsBounds3Ext IMakeBox(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> pos(-500.f, 500.f);
+    std::uniform_real_distribution<float> size(0.5f, 20.f);
+
+    hsPoint3 mins(pos(rng), pos(rng), pos(rng));
+    hsPoint3 maxs(mins.fX + size(rng), mins.fY + size(rng), mins.fZ + size(rng));
+
+    hsBounds3Ext bnd;
+    bnd.Reset(&mins);
+    bnd.Union(&maxs);
+    return bnd;
+}
+
+static void IExpectSameBounds(const hsBounds3Ext& a, const hsBounds3Ext& b)
+{
+    ASSERT_EQ(a.GetType(), b.GetType());
+    if (a.GetType() != kBoundsNormal)
+        return;
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_FLOAT_EQ(a.GetMins()[i], b.GetMins()[i]);
+        EXPECT_FLOAT_EQ(a.GetMaxs()[i], b.GetMaxs()[i]);
+    }
+}
+
+// Walks the whole tree checking it is what InsertLeaf/RemoveLeaf promise:
+// leaf i is node i, every interior node's children point back at it and fit
+// in its bounds (disabled ones are left out of their parent's bounds), each
+// node is reached exactly once and the flat copy of the bounds the cullers
+// use is up to date.
+static void IValidateTree(const plSpaceTree* tree, const std::vector<TestLeaf>& leaves)
+{
+    ASSERT_EQ(leaves.size(), size_t(tree->GetNumLeaves()));
+    if (leaves.empty())
+    {
+        EXPECT_TRUE(tree->IsEmpty());
+        return;
+    }
+    EXPECT_FALSE(tree->IsEmpty());
+
+    int16_t root = tree->GetRoot();
+    EXPECT_EQ(plSpaceTree::kRootParent, tree->GetNode(root).GetParent());
+
+    size_t numNodes = 2 * leaves.size() - 1;
+    std::vector<int> seen(numNodes, 0);
+    std::vector<int16_t> stack;
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        int16_t idx = stack.back();
+        stack.pop_back();
+
+        ASSERT_GE(idx, 0);
+        ASSERT_LT(size_t(idx), numNodes);
+        seen[idx]++;
+
+        const plSpaceTreeNode& node = tree->GetNode(idx);
+        if (node.IsLeaf())
+        {
+            ASSERT_LT(idx, tree->GetNumLeaves());
+            EXPECT_EQ(idx, node.GetLeaf());
+            IExpectSameBounds(leaves[idx].fBounds, node.GetWorldBounds());
+            EXPECT_EQ(leaves[idx].fDisabled, tree->HasLeafFlag(idx, plSpaceTreeNode::kDisabled) != 0);
+        }
+        else
+        {
+            ASSERT_GE(idx, tree->GetNumLeaves());
+            for (int c = 0; c < 2; c++)
+            {
+                int16_t child = node.GetChild(c);
+                ASSERT_GE(child, 0);
+                ASSERT_LT(size_t(child), numNodes);
+                EXPECT_EQ(idx, tree->GetNode(child).GetParent());
+                stack.push_back(child);
+
+                const plSpaceTreeNode& childNode = tree->GetNode(child);
+                if (childNode.fFlags & plSpaceTreeNode::kDisabled)
+                    continue;
+
+                const hsBounds3Ext& childBnd = childNode.GetWorldBounds();
+                if (childBnd.GetType() != kBoundsNormal)
+                    continue;
+
+                ASSERT_EQ(kBoundsNormal, node.GetWorldBounds().GetType());
+                for (int j = 0; j < 3; j++)
+                {
+                    EXPECT_GE(childBnd.GetMins()[j], node.GetWorldBounds().GetMins()[j]);
+                    EXPECT_LE(childBnd.GetMaxs()[j], node.GetWorldBounds().GetMaxs()[j]);
+                }
+            }
+        }
+
+        const plSpaceTreeFlatBounds& flat = tree->GetFlatBounds()[idx >> 2];
+        const hsBounds3Ext& bnd = node.GetWorldBounds();
+        for (int j = 0; j < 3; j++)
+        {
+            if (bnd.GetType() == kBoundsNormal)
+            {
+                EXPECT_FLOAT_EQ((bnd.GetMaxs()[j] + bnd.GetMins()[j]) * 0.5f, flat.fCenter[j][idx & 3]);
+                EXPECT_FLOAT_EQ((bnd.GetMaxs()[j] - bnd.GetMins()[j]) * 0.5f, flat.fExtent[j][idx & 3]);
+            }
+            else
+            {
+                EXPECT_EQ(0.f, flat.fCenter[j][idx & 3]);
+                EXPECT_EQ(0.f, flat.fExtent[j][idx & 3]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < numNodes; i++)
+        EXPECT_EQ(1, seen[i]) << "node " << i;
+}
+
+// Whatever shape the updates left the tree in, it has to cover the same
+// leaves as one built from scratch
+static void ICompareRebuilt(const plSpaceTree* tree, const std::vector<TestLeaf>& leaves)
+{
+    if (leaves.empty())
+        return;
+
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    for (const TestLeaf& leaf : leaves)
+        maker.AddLeaf(leaf.fBounds, leaf.fDisabled);
+    plSpaceTree* rebuilt = maker.MakeTree();
+
+    // The maker's interior bounds still cover disabled leaves; a refresh
+    // leaves them out, like the incremental updates do
+    rebuilt->SetTreeFlag(plSpaceTreeNode::kDirty);
+    rebuilt->Refresh();
+
+    ASSERT_EQ(rebuilt->GetNumLeaves(), tree->GetNumLeaves());
+    IExpectSameBounds(rebuilt->GetWorldBounds(), tree->GetWorldBounds());
+    for (int16_t i = 0; i < tree->GetNumLeaves(); i++)
+    {
+        IExpectSameBounds(rebuilt->GetNode(i).GetWorldBounds(), tree->GetNode(i).GetWorldBounds());
+        EXPECT_EQ(rebuilt->HasLeafFlag(i, plSpaceTreeNode::kDisabled), tree->HasLeafFlag(i, plSpaceTreeNode::kDisabled));
+    }
+
+    delete rebuilt;
+}
+
+TEST(plSpaceTree, InsertRemoveLeaf)
+{
+    std::mt19937 rng(1234);
+
+    std::vector<TestLeaf> leaves;
+    plSpaceTreeMaker maker;
+    maker.Reset();
+    for (int i = 0; i < 8; i++)
+    {
+        leaves.push_back({ IMakeBox(rng), false });
+        maker.AddLeaf(leaves.back().fBounds);
+    }
+    plSpaceTree* tree = maker.MakeTree();
+    IValidateTree(tree, leaves);
+
+    for (int iter = 0; iter < 2000; iter++)
+    {
+        SCOPED_TRACE(iter);
+
+        // grow more often than shrink, so the tree gets some depth
+        if (leaves.empty() || rng() % 3 != 0)
+        {
+            bool disabled = (rng() % 8 == 0);
+            leaves.push_back({ IMakeBox(rng), disabled });
+            int16_t idx = tree->InsertLeaf(leaves.back().fBounds, disabled);
+            ASSERT_EQ(leaves.size() - 1, size_t(idx));
+        }
+        else
+        {
+            int16_t idx = int16_t(rng() % leaves.size());
+            tree->RemoveLeaf(idx);
+            leaves.erase(leaves.begin() + idx);
+        }
+
+        IValidateTree(tree, leaves);
+        if (::testing::Test::HasFatalFailure())
+            break;
+        if (iter % 50 == 0)
+            ICompareRebuilt(tree, leaves);
+    }
+    ICompareRebuilt(tree, leaves);
+
+    // and all the way back down to nothing
+    while (!leaves.empty())
+    {
+        tree->RemoveLeaf(0);
+        leaves.erase(leaves.begin());
+        IValidateTree(tree, leaves);
+        if (::testing::Test::HasFatalFailure())
+            break;
+    }
+
+    // an emptied tree takes leaves again
+    leaves.push_back({ IMakeBox(rng), false });
+    EXPECT_EQ(0, tree->InsertLeaf(leaves.back().fBounds));
+    IValidateTree(tree, leaves);
+
+    delete tree;
+}